@@ -0,0 +1,272 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+
+/// --------------------- COUNTERS FOR LISTING PATH --------------------
+
+// We count calls made by the listing path of homework.c.
+// Real read syscalls are taken from /proc/self/io (syscr field).
+struct counters
+{
+    size_t mallocs;
+    size_t frees;
+    size_t fseeks;
+    size_t freads;
+} cnt;
+
+void *counting_malloc(size_t size)
+{
+    cnt.mallocs++;
+    return malloc(size);
+}
+
+void counting_free(void *p)
+{
+    cnt.frees++;
+    free(p);
+}
+
+int counting_fseek(FILE *f, long offset, int whence)
+{
+    cnt.fseeks++;
+    return fseek(f, offset, whence);
+}
+
+size_t counting_fread(void *ptr, size_t size, size_t nmemb, FILE *f)
+{
+    cnt.freads++;
+    return fread(ptr, size, nmemb, f);
+}
+
+/// BENCH FOR
+#define malloc(size) counting_malloc(size)
+#define free(p) counting_free(p)
+#define fseek(f, o, w) counting_fseek(f, o, w)
+#define fread(p, s, n, f) counting_fread(p, s, n, f)
+#define main homework_main
+#include "homework.c"
+#undef main
+#undef fread
+#undef fseek
+#undef free
+#undef malloc
+
+/// --------------------- SYNTHETIC ARCHIVE GENERATOR --------------------
+
+#define LFH_SIGNATURE 0x04034B50
+#define LFH_SIZE 30
+#define JUNK_SIZE (64 * 1024)
+#define LONG_NAME_PREFIX "very/long/directory/name/used/for/benchmarking/the/central/directory/walk/of/homework4/"
+
+static void put16(FILE *f, uint16_t v)
+{
+    fputc(v & 0xff, f);
+    fputc(v >> 8, f);
+}
+
+static void put32(FILE *f, uint32_t v)
+{
+    put16(f, v & 0xffff);
+    put16(f, v >> 16);
+}
+
+static size_t make_name(char *buff, size_t buff_size, size_t i, bool long_names)
+{
+    int n = snprintf(buff, buff_size, "%sf%zu", long_names ? LONG_NAME_PREFIX : "", i);
+    return (size_t)n;
+}
+
+/**
+ *  Write archive with `entries` empty stored files.
+ *  When `junk` is true the archive is prepended with JUNK_SIZE bytes like zipjpeg.
+ *  Returns size of the central directory in bytes or 0 if error happened.
+ */
+static size_t generate_archive(const char *path, size_t entries, bool long_names, bool junk)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        perror("Opening archive for writing");
+        return 0;
+    }
+
+    char name[256];
+    size_t name_len;
+    uint32_t junk_size = junk ? JUNK_SIZE : 0;
+
+    for (uint32_t i = 0; i < junk_size; i++)
+        fputc((i * 2654435761u) >> 24, f);
+
+    // local file headers (listing never reads them but real archives have them)
+    for (size_t i = 0; i < entries; i++)
+    {
+        name_len = make_name(name, sizeof(name), i, long_names);
+        put32(f, LFH_SIGNATURE);
+        put16(f, 10); put16(f, 0); put16(f, 0);   // version, flags, stored
+        put16(f, 0); put16(f, 0);                 // time, date
+        put32(f, 0); put32(f, 0); put32(f, 0);    // crc, sizes
+        put16(f, name_len); put16(f, 0);
+        fwrite(name, 1, name_len, f);
+    }
+
+    size_t lfh_offset = 0;
+    size_t cd_size = 0;
+    for (size_t i = 0; i < entries; i++)
+    {
+        name_len = make_name(name, sizeof(name), i, long_names);
+        put32(f, CDFH_SIGNATURE);
+        put16(f, 20); put16(f, 10); put16(f, 0); put16(f, 0);
+        put16(f, 0); put16(f, 0);
+        put32(f, 0); put32(f, 0); put32(f, 0);
+        put16(f, name_len); put16(f, 0); put16(f, 0);
+        put16(f, 0); put16(f, 0); put32(f, 0);
+        put32(f, lfh_offset);
+        fwrite(name, 1, name_len, f);
+        lfh_offset += LFH_SIZE + name_len;
+        cd_size += CDFH_SIZE + name_len;
+    }
+
+    // counts above UINT16_MAX are saturated (as ZIP64 writers do),
+    // the listing walks central directory by signatures anyway.
+    uint16_t count = entries > UINT16_MAX ? UINT16_MAX : entries;
+    put32(f, ECDR_SIGNATURE);
+    put16(f, 0); put16(f, 0);
+    put16(f, count); put16(f, count);
+    put32(f, cd_size);
+    put32(f, lfh_offset + junk_size);
+    put16(f, 0);
+
+    if (ferror(f))
+    {
+        perror("Writing archive");
+        cd_size = 0;
+    }
+    fclose(f);
+    return cd_size;
+}
+
+/// --------------------- BENCHMARK --------------------
+
+static size_t read_syscalls(void)
+{
+    size_t syscr = 0;
+    char line[128];
+    FILE *f = fopen("/proc/self/io", "r");
+    if (!f)
+        return 0;
+    while (fgets(line, sizeof(line), f))
+    {
+        if (sscanf(line, "syscr: %zu", &syscr) == 1)
+            break;
+    }
+    fclose(f);
+    return syscr;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool run_case(const char *path, size_t entries, bool long_names, bool junk)
+{
+    size_t cd_size = generate_archive(path, entries, long_names, junk);
+    if (!cd_size)
+        return false;
+
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        perror("Opening archive for reading");
+        return false;
+    }
+
+    // file names go to /dev/null, results go to saved stdout
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    if (-1 == saved_stdout || !freopen("/dev/null", "w", stdout))
+    {
+        perror("Redirecting stdout");
+        fclose(f);
+        return false;
+    }
+
+    memset(&cnt, 0, sizeof(cnt));
+    size_t syscr = read_syscalls();
+    double start = now();
+
+    ecdr_t ecdr;
+    bool res = find_ecdr(f, &ecdr);
+    if (res)
+        enumerate_files(f, ecdr.comment_length + ECDR_SIZE + ecdr.cd_size);
+
+    double elapsed = now() - start;
+    size_t syscalls = read_syscalls() - syscr - 1;  // minus read of /proc/self/io itself
+
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    fclose(f);
+
+    if (!res)
+    {
+        fprintf(stderr, "ECDR not found in %s\n", path);
+        return false;
+    }
+
+    printf("entries=%zu names=%s junk=%d cd_bytes=%zu seconds=%.6f "
+           "entries_per_sec=%.0f ns_per_cd_byte=%.2f "
+           "read_syscalls=%zu fseeks=%zu freads=%zu mallocs=%zu frees=%zu\n",
+           entries, long_names ? "long" : "short", junk, cd_size, elapsed,
+           entries / elapsed, elapsed * 1e9 / cd_size,
+           syscalls, cnt.fseeks, cnt.freads, cnt.mallocs, cnt.frees);
+    return true;
+}
+
+void print_bench_usage(const char *name)
+{
+    printf("Usage: %s [max_entries]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t max_entries = 1000000;
+    if (argc > 2)
+    {
+        print_bench_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (argc == 2)
+        max_entries = strtoull(argv[1], NULL, 10);
+
+    char path[] = "/tmp/bench4_XXXXXX";
+    int fd = mkstemp(path);
+    if (-1 == fd)
+    {
+        perror("Creating temporary archive");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+
+    const size_t sizes[] = {10, 10000, 1000000};
+    bool ok = true;
+    for (size_t i = 0; ok && i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        if (sizes[i] > max_entries)
+            break;
+        ok = run_case(path, sizes[i], false, false) &&
+             run_case(path, sizes[i], true, false) &&
+             run_case(path, sizes[i], false, true) &&
+             run_case(path, sizes[i], true, true);
+    }
+
+    unlink(path);
+    exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
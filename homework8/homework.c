@@ -6,13 +6,97 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#ifdef HOMEWORK_HTABLE_GEN
+#include <string.h>
+#include <time.h>
+#include "htable_gen.h"
+#else
 #include "htable.h"
+#endif
 
 void print_usage(const char *name)
 {
     printf("Usage: %s textfile\n", name);
 }
 
+/**
+ * Skip separators and return the next word (or NULL at the end of content)
+ */
+static const uint8_t *next_word(const uint8_t **p, const uint8_t *end, size_t *word_len)
+{
+    const uint8_t *word;
+
+    while (*p < end && (**p == ' ' || **p == '\n' || **p == '\t'))
+        (*p)++;
+
+    if (*p >= end)
+        return NULL;
+
+    word = *p;
+    while (*p < end && **p != ' ' && **p != '\n' && **p != '\t')
+        (*p)++;
+    *word_len = *p - word;
+    return word;
+}
+
+#ifdef HOMEWORK_HTABLE_GEN
+
+// Hash table generated for word keys (pointing into mapped file) and counters
+typedef struct
+{
+    const uint8_t *p;
+    size_t len;
+} word_t;
+
+static uint64_t seed;
+
+static inline uint32_t hash_word(word_t word)
+{
+    return htable_word_hash(word.p, word.len, seed);
+}
+
+static inline bool equal_words(word_t word1, word_t word2)
+{
+    return word1.len == word2.len && 0 == memcmp(word1.p, word2.p, word1.len);
+}
+
+HTABLE_GEN(counter, word_t, size_t, hash_word, equal_words)
+
+static bool count_words(const uint8_t *content, size_t size)
+{
+    seed = htable_fmix64((uint64_t)(uintptr_t)&seed ^ (uint64_t)time(NULL));
+    counter_t *ht = counter_make(512);
+    if (!ht)
+    {
+        perror("Can't create hash table");
+        return false;
+    }
+
+    const uint8_t *p = content, *end = content + size;
+    word_t word;
+    counter_entry_t *entry;
+    while ((word.p = next_word(&p, end, &word.len)))
+    {
+        entry = counter_upsert(ht, word, NULL);
+        if (!entry)
+        {
+            perror("Something wrong when counter_upsert was called");
+            counter_destroy(ht);
+            return false;
+        }
+        entry->val++;
+    }
+
+    size_t iter = 0;
+    while ((entry = counter_next(ht, &iter)))
+        printf("%.*s %lu\n", (int)entry->key.len, entry->key.p, entry->val);
+
+    counter_destroy(ht);
+    return true;
+}
+
+#else
+
 struct item
 {
     htable_item_base_t base;
@@ -27,6 +111,43 @@ int print_items(htable_item_base_t *item)
     return 1;
 }
 
+static bool count_words(const uint8_t *content, size_t size)
+{
+    struct item item, *req_item;
+    htable_options_t options = {512, NULL, HTABLE_OPT_ARENA | HTABLE_OPT_DENSE | HTABLE_OPT_RANDOM_SEED,
+                                 HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    if (!ht)
+    {
+        perror("Can't create hash table");
+        return false;
+    }
+
+    const uint8_t *p = content, *end = content + size;
+    const uint8_t *word;
+    while ((word = next_word(&p, end, &item.base.key_len)))
+    {
+        item.base.key = (uint8_t*)word;
+        item.val = 0;
+
+        // One probe per word: existing item is returned or new one is inserted with zero counter
+        req_item = (struct item*)htable_upsert(ht, (htable_item_base_t*)&item, sizeof(struct item), NULL);
+        if (!req_item)
+        {
+            perror("Something wrong when htable_upsert was called");
+            htable_destroy(ht);
+            return false;
+        }
+        req_item->val++;
+    }
+
+    htable_enumerate_items(ht, print_items);
+    htable_destroy(ht);
+    return true;
+}
+
+#endif
+
 int main(int argc, char *argv[])
 {
     bool err_happened = false;
@@ -65,69 +186,8 @@ int main(int argc, char *argv[])
         goto clean_file;
     }
 
-    bool found;
-    struct item item, *req_item;
-    htable_t *ht = htable_make(512, NULL);
-    if (!ht)
-    {
-        perror("Can't create hash table");
+    if (!count_words(file_content, st.st_size))
         err_happened = true;
-        goto clean_file;
-    }
-
-    int64_t index = 0;
-    uint8_t *p = file_content;
-    uint8_t *word;
-    size_t word_len;
-    while (index < st.st_size)
-    {
-        while ((*p == ' ' || *p == '\n' || *p == '\t') && index < st.st_size)
-        {
-            p++; index++;
-        }
-
-        if (index >= st.st_size)
-            break;
-
-        word = p;
-        word_len = 0;
-        while ((*p != ' ' && *p != '\n' && *p != '\t') && index < st.st_size)
-        {
-            p++; index++; word_len++;
-        }
-
-        item.base.key = word;
-        item.base.key_len = word_len;
-        item.val = 1;
-
-        found = htable_find(ht, (htable_item_base_t*)&item, (htable_item_base_t**)&req_item);
-        if (htable_status(ht) != HTABLE_OK)
-        {
-            perror("Something wrong when htable_find was called");
-            err_happened = true;
-            goto clean_hash_table;
-        }
-
-        if (found)
-        {
-            req_item->val++;
-        }
-        else
-        {
-            htable_set(ht, (htable_item_base_t*)&item, sizeof(struct item));
-            if (htable_status(ht) != HTABLE_OK)
-            {
-                perror("Something wrong when htable_set was called");
-                err_happened = true;
-                goto clean_hash_table;
-            }
-        }
-    }
-
-    htable_enumerate_items(ht, print_items);
-
-clean_hash_table:
-    htable_destroy(ht);
     munmap(file_content, st.st_size);
 
 clean_file:
@@ -1,7 +1,12 @@
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "htable.h"
+#include "htable_hash.h"
 
 #define CHECK_AND_EXIT_WITH_VAL_IF(cond, v)       if (cond)  return v;
 #define CHECK_AND_EXIT_IF(cond)                   if (cond)  return;
@@ -19,13 +24,98 @@
       return v;                                               \
     }                                                         \
 
+#ifndef HTABLE_ARENA_CHUNK_SIZE
+#define HTABLE_ARENA_CHUNK_SIZE (64 * 1024)              // Size of the first arena chunk
+#endif
+#define HTABLE_ARENA_MAX_CHUNK_SIZE (16 * 1024 * 1024)   // Chunks grow twice up to this size
+
+#define HTABLE_MIGRATE_STEP 16  // Slots moved by every operation while incremental rehashing
+#define HTABLE_BATCH_SIZE 16    // Lookups of htable_find_batch overlapping their cache misses
+
+#define ARENA_ALIGN(size) (((size) + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1))
+#define ARENA_HEADER_SIZE ARENA_ALIGN(sizeof(arena_chunk_t))
+
+// Every slot keeps pointer to item and the full hash of item's key (in parallel array)
+#define SLOT_SIZE (sizeof(htable_item_base_t*) + sizeof(uint32_t))
+
+// Swiss table layout (HTABLE_OPT_SWISS): every slot has also control byte,
+// control bytes are probed by groups (one SSE2 compare per group)
+#define SWISS_GROUP_SIZE 16
+#define SWISS_SLOT_SIZE (SLOT_SIZE + 1)
+#define CTRL_EMPTY   ((uint8_t)0x80)
+#define CTRL_DELETED ((uint8_t)0xFE)
+#define H1(hash) ((hash) >> 7)          // Selects group
+#define H2(hash) ((hash) & 0x7F)        // Stored in control byte of full slot
+
+// Dense layout (HTABLE_OPT_DENSE): items are kept in insertion order in dense array,
+// every slot keeps position of item in dense array (shifted by DENSE_FIRST) and the full hash
+#define DENSE_SLOT_SIZE (sizeof(uint32_t) + sizeof(uint32_t))
+#define DENSE_EMPTY   0
+#define DENSE_DELETED 1
+#define DENSE_FIRST   2
+#define DENSE_CAPACITY(capacity) ((capacity) / 2 + 1)  // Table grows before dense array is full
+
+// Split block Bloom filter: a key sets one bit in every word of one block (cache line)
+#define BLOOM_WORDS 8
+#define BLOOM_BLOCK_SIZE (BLOOM_WORDS * sizeof(uint64_t))
+#define BLOOM_SLOTS_PER_BLOCK 32    // 2 bytes of filter per slot, about 2^-10 false positives at max load
+
+typedef uint32_t (*seeded_hash_func_t)(const uint8_t *key, size_t key_len, uint64_t seed);
+
+typedef struct arena_chunk_t
+{
+    struct arena_chunk_t *next;
+    size_t size;
+    size_t used;
+} arena_chunk_t;
+
+typedef struct
+{
+    htable_item_base_t *item;     // NULL for removed item
+    uint32_t hash;
+} dense_entry_t;
+
+typedef struct
+{
+    size_t resize_count;
+    uint64_t resize_ns;
+    uint64_t find_probes[HTABLE_PROBE_HISTOGRAM_SIZE];
+    uint64_t insert_probes[HTABLE_PROBE_HISTOGRAM_SIZE];
+    uint64_t hits;                // Bounded table only
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t bloom_rejects;
+} stats_counters_t;
+
 struct htable_t
 {
     htable_item_base_t **items;
+    uint32_t *hashes;             // Hashes of items, the array follows items array in the same allocation
+    uint8_t *ctrl;                // Control bytes (Swiss table layout only), follows hashes array
+    uint32_t *positions;          // Slots of dense layout (instead of items), hashes array follows it
+    dense_entry_t *dense;         // Dense layout only: items in insertion order
+    size_t dense_count;           // Used entries of dense array (removed items too)
     size_t items_count;
+    size_t deleted_count;         // Slots marked as deleted
+    htable_item_base_t **old_items;  // Incremental rehashing: items are moved from old array to items
+    uint32_t *old_hashes;
+    size_t old_capacity;
+    size_t migrate_index;         // Slots of old array before this index are moved already
     size_t capacity;
-    hash_func_t hash_func;
+    hash_func_t hash_func;        // User's hash function or NULL
+    seeded_hash_func_t seeded_hash_func;  // Built-in hash function, used if hash_func is NULL
+    uint64_t seed;
     item_destructor_t item_destructor;
+    size_t inline_key_max;
+    uint32_t flags;
+    arena_chunk_t *arena;
+    uint64_t *bloom;              // Bloom filter (HTABLE_OPT_BLOOM only), blocks of BLOOM_WORDS words
+    void *bloom_mem;              // Allocation of filter, bloom is aligned to BLOOM_BLOCK_SIZE in it
+    size_t bloom_blocks;
+    size_t max_items;             // Bounded table (0 - unbounded), see htable_set_max_items
+    size_t clock_hand;            // Slot the eviction starts from
+    htable_allocator_t allocator; // Everything is allocated by it, the table itself too
+    stats_counters_t stats;       // Counted with HTABLE_OPT_STATS only
     int last_error;
 };
 
@@ -34,37 +124,201 @@ htable_item_base_t deleted__;
 htable_item_base_t * const marked_as_deleted = &deleted__;
 
 /**
- * Jenkins hash function. Used as default hash function.
- * see: https://en.wikipedia.org/wiki/Jenkins_hash_function
+ * Built-in hash functions (see htable_hash.h). Used through seeded_hash_func pointer.
  */
-static uint32_t jenkins_one_at_a_time_hash(const uint8_t *key, size_t key_len)
+static uint32_t jenkins_one_at_a_time_hash(const uint8_t *key, size_t key_len, uint64_t seed)
 {
-    size_t i = 0;
-    uint32_t hash = 0;
+    return htable_jenkins_hash(key, key_len, seed);
+}
 
-    while (i != key_len)
-    {
-        hash += key[i++];
-        hash += hash << 10;
-        hash ^= hash >> 6;
-    }
+static uint32_t word_hash(const uint8_t *key, size_t key_len, uint64_t seed)
+{
+    return htable_word_hash(key, key_len, seed);
+}
+
+#ifdef HTABLE_HAVE_CRC32C
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hash(const uint8_t *key, size_t key_len, uint64_t seed)
+{
+    return htable_crc32c_hash(key, key_len, seed);
+}
+#endif
 
-    hash += hash << 3;
-    hash ^= hash >> 11;
-    hash += hash << 15;
-    return hash;
+static inline uint32_t hash_key(const htable_t *ht, const uint8_t *key, size_t key_len)
+{
+    if (ht->hash_func)
+        return ht->hash_func(key, key_len);
+    return ht->seeded_hash_func(key, key_len, ht->seed);
+}
+
+/**
+ * Seed differs between tables and runs: address of table (ASLR), time and number of made seeds.
+ * It's not cryptographic randomness, but enough to make colliding keys not reproducible.
+ */
+static uint64_t random_seed(const void *salt)
+{
+    static uint64_t seeds_count = 0;
+    uint64_t seed = (uint64_t)(uintptr_t)salt ^ ((uint64_t)time(NULL) << 20) ^ (uint64_t)clock();
+    seed += ++seeds_count * HTABLE_WORD_HASH_M1;
+    return htable_fmix64(seed);
+}
+
+static void *default_alloc(size_t size, __attribute__((unused)) void *ctx)
+{
+    return malloc(size);
+}
+
+static void default_free(void *p, __attribute__((unused)) void *ctx)
+{
+    free(p);
+}
+
+static const htable_allocator_t default_allocator = {default_alloc, default_free, NULL};
+
+static inline void *mem_alloc(const htable_t *ht, size_t size)
+{
+    return ht->allocator.alloc(size, ht->allocator.ctx);
+}
+
+static void *mem_calloc(const htable_t *ht, size_t count, size_t size)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(size && count > SIZE_MAX / size, NULL) // overflow control.
+    void *p = mem_alloc(ht, count * size);
+    if (p)
+        memset(p, 0, count * size);
+    return p;
+}
+
+static inline void mem_free(const htable_t *ht, void *p)
+{
+    if (p)
+        (ht->allocator.free)(p, ht->allocator.ctx);  // Parentheses keep free() macros away
 }
 
 static void default_item_destructor(htable_item_base_t *item)
 {
-    if (item)
+    if (item && !(item->flags & HTABLE_ITEM_ARENA))
     {
-        if (item->key)
+        if (item->key && !(item->flags & HTABLE_ITEM_INLINE_KEY))
             free(item->key);
         free(item);
     }
 }
 
+/**
+ * Call item destructor. Instead of default one the item (and key) is released with allocator of table.
+ */
+static void destroy_item(const htable_t *ht, htable_item_base_t *item)
+{
+    if (ht->item_destructor != default_item_destructor)
+    {
+        ht->item_destructor(item);
+        return;
+    }
+
+    if (item && !(item->flags & HTABLE_ITEM_ARENA))
+    {
+        if (item->key && !(item->flags & HTABLE_ITEM_INLINE_KEY))
+            mem_free(ht, item->key);
+        mem_free(ht, item);
+    }
+}
+
+/**
+ * Release copy made by make_item that wasn't stored, item destructor isn't called for it.
+ */
+static void release_item(htable_t *ht, htable_item_base_t *item)
+{
+    if (item && !(item->flags & HTABLE_ITEM_ARENA))
+    {
+        if (!(item->flags & HTABLE_ITEM_INLINE_KEY))
+            mem_free(ht, item->key);
+        mem_free(ht, item);
+    }
+}
+
+static void *arena_alloc(htable_t *ht, size_t size)
+{
+    size = ARENA_ALIGN(size);
+    arena_chunk_t *chunk = ht->arena;
+
+    if (!chunk || chunk->size - chunk->used < size)
+    {
+        size_t chunk_size = (chunk) ? chunk->size << 1 : HTABLE_ARENA_CHUNK_SIZE;
+        if (chunk_size > HTABLE_ARENA_MAX_CHUNK_SIZE)
+            chunk_size = HTABLE_ARENA_MAX_CHUNK_SIZE;
+        if (chunk_size < size)
+            chunk_size = size;
+
+        chunk = mem_alloc(ht, ARENA_HEADER_SIZE + chunk_size);
+        CHECK_AND_EXIT_WITH_VAL_IF(!chunk, NULL)
+        chunk->next = ht->arena;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        ht->arena = chunk;
+    }
+
+    void *p = (uint8_t*)chunk + ARENA_HEADER_SIZE + chunk->used;
+    chunk->used += size;
+    return p;
+}
+
+static void arena_destroy(htable_t *ht)
+{
+    arena_chunk_t *next;
+    while (ht->arena)
+    {
+        next = ht->arena->next;
+        mem_free(ht, ht->arena);
+        ht->arena = next;
+    }
+}
+
+/**
+ * Make copy of item (with key) for storing in hash table.
+ * It returns NULL if memory can't be allocated.
+ */
+static htable_item_base_t *make_item(htable_t *ht, const htable_item_base_t *item, size_t item_size)
+{
+    htable_item_base_t *candidate;
+
+    if (ht->flags & HTABLE_OPT_ARENA)
+    {
+        candidate = arena_alloc(ht, item_size + item->key_len);
+        CHECK_AND_EXIT_WITH_VAL_IF(!candidate, NULL)
+        memcpy(candidate, item, item_size);
+        candidate->key = (uint8_t*)candidate + item_size;
+        candidate->flags = HTABLE_ITEM_INLINE_KEY | HTABLE_ITEM_ARENA;
+    }
+    else
+    {
+        bool inline_key = ht->inline_key_max && item->key_len <= ht->inline_key_max;
+        size_t alloc_size = (inline_key) ? item_size + item->key_len : item_size;
+        candidate = (htable_item_base_t*)mem_calloc(ht, 1, alloc_size);
+        CHECK_AND_EXIT_WITH_VAL_IF(!candidate, NULL)
+
+        memcpy(candidate, item, item_size);
+        if (inline_key)
+        {
+            candidate->key = (uint8_t*)candidate + item_size;
+            candidate->flags = HTABLE_ITEM_INLINE_KEY;
+        }
+        else
+        {
+            candidate->key = mem_calloc(ht, 1, candidate->key_len);
+            candidate->flags = 0;
+            if (!candidate->key)
+            {
+                mem_free(ht, candidate);
+                return NULL;
+            }
+        }
+    }
+
+    memcpy(candidate->key, item->key, candidate->key_len);
+    return candidate;
+}
+
 static bool compare_items_key(const htable_item_base_t *item_first, const htable_item_base_t *item_second)
 {
     if (item_first->key_len != item_second->key_len)
@@ -76,13 +330,313 @@ static bool compare_items_key(const htable_item_base_t *item_first, const htable
     return true;
 }
 
-static void expand(htable_t *ht)
+/**
+ * Returns pointer to the item pointer of full slot: the slot itself or entry of dense array.
+ */
+static inline htable_item_base_t **slot_ref(const htable_t *ht, size_t index)
+{
+    if (ht->flags & HTABLE_OPT_DENSE)
+        return &ht->dense[ht->positions[index] - DENSE_FIRST].item;
+    return &ht->items[index];
+}
+
+/**
+ * The slot (the first slot of group for Swiss layout) where probing for the hash starts.
+ */
+static size_t home_index(const htable_t *ht, uint32_t hash)
+{
+    if (ht->flags & HTABLE_OPT_SWISS)
+        return (H1(hash) & (ht->capacity / SWISS_GROUP_SIZE - 1)) * SWISS_GROUP_SIZE;
+    return hash % ht->capacity;
+}
+
+static bool is_full_slot(const htable_t *ht, size_t index)
+{
+    if (ht->flags & HTABLE_OPT_SWISS)
+        return !(ht->ctrl[index] & CTRL_EMPTY);
+    if (ht->flags & HTABLE_OPT_DENSE)
+        return ht->positions[index] >= DENSE_FIRST;
+    return ht->items[index] && ht->items[index] != marked_as_deleted;
+}
+
+/**
+ * Number of slots (groups for Swiss layout) probed from home slot of hash up to the slot at index.
+ */
+static size_t probe_length(const htable_t *ht, uint32_t hash, size_t index)
+{
+    size_t home = home_index(ht, hash);
+    if (ht->flags & HTABLE_OPT_SWISS)
+    {
+        size_t groups = ht->capacity / SWISS_GROUP_SIZE;
+        return (index / SWISS_GROUP_SIZE + groups - home / SWISS_GROUP_SIZE) % groups + 1;
+    }
+    return (index + ht->capacity - home) % ht->capacity + 1;
+}
+
+static void count_probes(const htable_t *ht, uint64_t *histogram, uint32_t hash, size_t index)
+{
+    size_t probes = probe_length(ht, hash, index);
+    histogram[(probes < HTABLE_PROBE_HISTOGRAM_SIZE) ? probes - 1 : HTABLE_PROBE_HISTOGRAM_SIZE - 1]++;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static const uint32_t bloom_salts[BLOOM_WORDS] = {
+    0x47B6137Bu, 0x44974D91u, 0x8824AD5Bu, 0xA2B7289Du, 0x705495C7u, 0x2DF1424Bu, 0x9EFC4947u, 0x5C6BFB31u
+};
+
+/**
+ * Block of hash: remixed hash selects it (multiply-shift range reduction, no division).
+ * High bits of hash can't be used as they are: in a shard of htable_sharded_t they are the same.
+ */
+static inline uint64_t *bloom_block(const htable_t *ht, uint32_t hash)
+{
+    uint32_t mixed = (uint32_t)htable_fmix64(hash);
+    return ht->bloom + (((uint64_t)mixed * ht->bloom_blocks) >> 32) * BLOOM_WORDS;
+}
+
+static inline void bloom_add(htable_t *ht, uint32_t hash)
+{
+    uint64_t *block = bloom_block(ht, hash);
+    for (size_t i = 0; i < BLOOM_WORDS; i++)
+        block[i] |= (uint64_t)1 << ((hash * bloom_salts[i]) >> 26);
+}
+
+static inline bool bloom_may_contain(const htable_t *ht, uint32_t hash)
+{
+    const uint64_t *block = bloom_block(ht, hash);
+    uint64_t missing = 0;
+    for (size_t i = 0; i < BLOOM_WORDS; i++)
+        missing |= ~block[i] & ((uint64_t)1 << ((hash * bloom_salts[i]) >> 26));
+    return !missing;
+}
+
+/**
+ * Lookup answered by Bloom filter: true if the key is definitely not in the table.
+ */
+static inline bool bloom_rejects(htable_t *ht, uint32_t hash)
+{
+    if (!ht->bloom || bloom_may_contain(ht, hash))
+        return false;
+    if (ht->flags & HTABLE_OPT_STATS)
+        ht->stats.bloom_rejects++;
+    return true;
+}
+
+/**
+ * Build Bloom filter sized for capacity from stored hashes, keys of removed items are dropped.
+ * If memory can't be allocated the old filter is kept, it has all keys and is just more loaded.
+ */
+static bool bloom_rebuild(htable_t *ht)
+{
+    size_t blocks = ht->capacity / BLOOM_SLOTS_PER_BLOCK;
+    if (!blocks)
+        blocks = 1;
+    // Allocator aligns to max_align_t only: one block more is taken, so every block fits one cache line
+    uint8_t *mem = mem_alloc(ht, (blocks + 1) * BLOOM_BLOCK_SIZE - 1);
+    CHECK_AND_EXIT_WITH_VAL_IF(!mem, false)
+    mem_free(ht, ht->bloom_mem);
+    ht->bloom_mem = mem;
+    ht->bloom = (uint64_t*)(mem + (-(uintptr_t)mem & (BLOOM_BLOCK_SIZE - 1)));
+    ht->bloom_blocks = blocks;
+    memset(ht->bloom, 0, blocks * BLOOM_BLOCK_SIZE);
+
+    for (size_t i = 0; i < ht->capacity; i++)
+    {
+        if (is_full_slot(ht, i))
+            bloom_add(ht, ht->hashes[i]);
+    }
+    // Incremental rehashing: items which are not moved yet
+    for (size_t i = ht->migrate_index; i < ht->old_capacity; i++)
+    {
+        if (ht->old_items[i] && ht->old_items[i] != marked_as_deleted)
+            bloom_add(ht, ht->old_hashes[i]);
+    }
+    return true;
+}
+
+/**
+ * Returns bit mask of control bytes in group that are equal to value.
+ */
+static inline uint32_t group_match(const uint8_t *group, uint8_t value)
+{
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)value)));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < SWISS_GROUP_SIZE; i++)
+        mask |= (uint32_t)(group[i] == value) << i;
+    return mask;
+#endif
+}
+
+/**
+ * Returns bit mask of empty or deleted control bytes in group.
+ */
+static inline uint32_t group_match_free(const uint8_t *group)
+{
+#ifdef __SSE2__
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < SWISS_GROUP_SIZE; i++)
+        mask |= (uint32_t)(group[i] >> 7) << i;
+    return mask;
+#endif
+}
+
+static htable_item_base_t **swiss_alloc_slots(const htable_t *ht, size_t capacity)
+{
+    htable_item_base_t **items = mem_calloc(ht, capacity, SWISS_SLOT_SIZE);
+    CHECK_AND_EXIT_WITH_VAL_IF(!items, NULL)
+    memset((uint8_t*)items + capacity * SLOT_SIZE, CTRL_EMPTY, capacity);
+    return items;
+}
+
+static void swiss_rehash(htable_t *ht, size_t new_capacity)
 {
-    size_t new_capacity = ht->capacity << 1;
     CHECK_AND_EXIT_IF(new_capacity < ht->capacity) // overflow control.
 
-    htable_item_base_t **new_items = calloc(new_capacity, sizeof(htable_item_base_t*));
+    htable_item_base_t **new_items = swiss_alloc_slots(ht, new_capacity);
+    CHECK_AND_EXIT_IF(!new_items)
+    uint32_t *new_hashes = (uint32_t*)(new_items + new_capacity);
+    uint8_t *new_ctrl = (uint8_t*)(new_hashes + new_capacity);
+
+    size_t groups_mask = new_capacity / SWISS_GROUP_SIZE - 1;
+    size_t group, index;
+    uint32_t hash, free_mask;
+    for (size_t i = 0; i < ht->capacity; i++)
+    {
+        if (ht->ctrl[i] & CTRL_EMPTY)
+            continue;
+
+        hash = ht->hashes[i];
+        group = H1(hash) & groups_mask;
+        while (!(free_mask = group_match_free(new_ctrl + group * SWISS_GROUP_SIZE)))
+            group = (group + 1) & groups_mask;
+
+        index = group * SWISS_GROUP_SIZE + __builtin_ctz(free_mask);
+        new_items[index] = ht->items[i];
+        new_hashes[index] = hash;
+        new_ctrl[index] = H2(hash);
+    }
+
+    mem_free(ht, ht->items);
+    ht->items = new_items;
+    ht->hashes = new_hashes;
+    ht->ctrl = new_ctrl;
+    ht->capacity = new_capacity;
+    ht->deleted_count = 0;
+}
+
+/**
+ * Probe groups of Swiss table starting from group selected by hash.
+ * Probing stops at the first group having empty slot.
+ * If item isn't found out_index is the first free (empty or deleted) slot of probe sequence.
+ */
+static bool swiss_find(htable_t *ht, const htable_item_base_t *item, uint32_t hash, size_t *out_index)
+{
+    size_t groups = ht->capacity / SWISS_GROUP_SIZE;
+    size_t group = H1(hash) & (groups - 1);
+    uint8_t h2 = H2(hash);
+    bool free_found = false;
+    size_t free_index = 0;
+    const uint8_t *ctrl;
+    uint32_t match, free_mask;
+    size_t base, index;
+
+    for (size_t probe = 0; probe < groups; probe++)
+    {
+        base = group * SWISS_GROUP_SIZE;
+        ctrl = ht->ctrl + base;
+
+        match = group_match(ctrl, h2);
+        while (match)
+        {
+            index = base + __builtin_ctz(match);
+            if (ht->hashes[index] == hash && compare_items_key(ht->items[index], item))
+            {
+                *out_index = index;
+                return true;
+            }
+            match &= match - 1;
+        }
+
+        free_mask = group_match_free(ctrl);
+        if (free_mask && !free_found)
+        {
+            free_found = true;
+            free_index = base + __builtin_ctz(free_mask);
+        }
+
+        if (group_match(ctrl, CTRL_EMPTY))
+            break;
+
+        group = (group + 1) & (groups - 1);
+    }
+
+    SET_HTABLE_ERROR_AND_EXIT_WITH_VAL_IF(!free_found, ht, HTABLE_FULL, false)
+    *out_index = free_index;
+    return false;
+}
+
+static inline size_t probe_distance(uint32_t hash, size_t index, size_t capacity)
+{
+    size_t home = hash % capacity;
+    return (index + capacity - home) % capacity;
+}
+
+/**
+ * Put item at index shifting the following items up to the first empty slot by one.
+ */
+static void robin_hood_shift_insert(htable_item_base_t **items, uint32_t *hashes, size_t capacity,
+                                    size_t index, htable_item_base_t *item, uint32_t hash)
+{
+    htable_item_base_t *displaced_item;
+    uint32_t displaced_hash;
+
+    while (items[index])
+    {
+        displaced_item = items[index];
+        displaced_hash = hashes[index];
+        items[index] = item;
+        hashes[index] = hash;
+        item = displaced_item;
+        hash = displaced_hash;
+        index = (index + 1) % capacity;
+    }
+    items[index] = item;
+    hashes[index] = hash;
+}
+
+/**
+ * Robin Hood insertion: item takes the slot of the first item that is closer to its home slot.
+ */
+static void robin_hood_place(htable_item_base_t **items, uint32_t *hashes, size_t capacity,
+                             htable_item_base_t *item, uint32_t hash)
+{
+    size_t index = hash % capacity;
+    size_t distance = 0;
+
+    while (items[index] && probe_distance(hashes[index], index, capacity) >= distance)
+    {
+        index = (index + 1) % capacity;
+        distance++;
+    }
+    robin_hood_shift_insert(items, hashes, capacity, index, item, hash);
+}
+
+static void rehash(htable_t *ht, size_t new_capacity)
+{
+    htable_item_base_t **new_items = mem_calloc(ht, new_capacity, SLOT_SIZE);
     CHECK_AND_EXIT_IF(!new_items)
+    uint32_t *new_hashes = (uint32_t*)(new_items + new_capacity);
 
     htable_item_base_t *item;
     uint32_t hash;
@@ -92,60 +646,539 @@ static void expand(htable_t *ht)
         item = ht->items[i];
         if (item && item != marked_as_deleted)
         {
-            hash = ht->hash_func(item->key, item->key_len);
+            hash = ht->hashes[i];  // Stored hash, keys aren't rehashed
+            if (ht->flags & HTABLE_OPT_ROBIN_HOOD)
+            {
+                robin_hood_place(new_items, new_hashes, new_capacity, item, hash);
+                continue;
+            }
+
             index = hash % new_capacity;
             while (new_items[index])
                 index++, index %= new_capacity;
             new_items[index] = item;
+            new_hashes[index] = hash;
         }
     }
 
-    free(ht->items);
+    mem_free(ht, ht->items);
     ht->items = new_items;
+    ht->hashes = new_hashes;
     ht->capacity = new_capacity;
+    ht->deleted_count = 0;
 }
 
-static bool find(htable_t *ht, const htable_item_base_t *item, size_t *out_index)
+static void expand(htable_t *ht)
+{
+    size_t new_capacity = ht->capacity << 1;
+    CHECK_AND_EXIT_IF(new_capacity < ht->capacity) // overflow control.
+    rehash(ht, new_capacity);
+}
+
+/**
+ * Probing stops at empty slot or at item that is closer to its home slot than the key would be.
+ * If item isn't found out_index is the slot where it has to be inserted.
+ */
+static bool robin_hood_find(htable_t *ht, const htable_item_base_t *item, uint32_t hash, size_t *out_index)
+{
+    size_t index = hash % ht->capacity;
+    htable_item_base_t *candidate;
+
+    for (size_t distance = 0; distance < ht->capacity; distance++)
+    {
+        candidate = ht->items[index];
+        if (!candidate || probe_distance(ht->hashes[index], index, ht->capacity) < distance)
+        {
+            *out_index = index;
+            return false;
+        }
+
+        if (ht->hashes[index] == hash && compare_items_key(candidate, item))
+        {
+            *out_index = index;
+            return true;
+        }
+        index = (index + 1) % ht->capacity;
+    }
+
+    ht->last_error = HTABLE_FULL;
+    return false;
+}
+
+static bool linear_find(htable_t *ht, const htable_item_base_t *item, uint32_t hash, size_t *out_index)
 {
-    uint32_t hash = ht->hash_func(item->key, item->key_len);
     size_t index = hash % ht->capacity;
 
     if (!ht->items_count)
     {
-        *out_index = index;
-        return false;
+        *out_index = index;
+        return false;
+    }
+
+    htable_item_base_t *candidate = ht->items[index];
+
+    if (!candidate)
+    {
+        *out_index = index;
+        return false;
+    }
+
+    bool first_item_marked_as_deleted = false;
+    size_t index_of_first_item_marked_as_deleted = index;
+    if (candidate == marked_as_deleted)
+        first_item_marked_as_deleted = true;
+
+    size_t stopper = index;
+    while (candidate)
+    {
+        // Stored hash rejects mismatches without touching the item
+        if (ht->hashes[index] == hash && candidate != marked_as_deleted && compare_items_key(candidate, item))
+        {
+            *out_index = index;
+            return true;
+        }
+
+        index++;
+        index %= ht->capacity;
+        candidate = ht->items[index];
+        SET_HTABLE_ERROR_AND_EXIT_WITH_VAL_IF(index == stopper, ht, HTABLE_FULL, false)
+    }
+
+    *out_index = (first_item_marked_as_deleted) ? index_of_first_item_marked_as_deleted: index;
+    return false;
+}
+
+/**
+ * Rebuild slots of dense layout from dense array, removed items are dropped from dense array.
+ * Items keep their insertion order.
+ */
+static void dense_rehash(htable_t *ht, size_t new_capacity)
+{
+    CHECK_AND_EXIT_IF(new_capacity < ht->capacity) // overflow control.
+    CHECK_AND_EXIT_IF(DENSE_CAPACITY(new_capacity) > UINT32_MAX - DENSE_FIRST)
+
+    uint32_t *new_positions = mem_calloc(ht, new_capacity, DENSE_SLOT_SIZE);
+    CHECK_AND_EXIT_IF(!new_positions)
+    dense_entry_t *new_dense = mem_alloc(ht, DENSE_CAPACITY(new_capacity) * sizeof(dense_entry_t));
+    if (!new_dense)
+    {
+        mem_free(ht, new_positions);
+        return;
+    }
+    uint32_t *new_hashes = new_positions + new_capacity;
+
+    size_t count = 0, index;
+    uint32_t hash;
+    for (size_t i = 0; i < ht->dense_count; i++)
+    {
+        if (!ht->dense[i].item)
+            continue;
+
+        hash = ht->dense[i].hash;  // Stored hash, keys aren't rehashed
+        index = hash % new_capacity;
+        while (new_positions[index])
+            index = (index + 1) % new_capacity;
+        new_positions[index] = count + DENSE_FIRST;
+        new_hashes[index] = hash;
+        new_dense[count++] = ht->dense[i];
+    }
+
+    mem_free(ht, ht->positions);
+    mem_free(ht, ht->dense);
+    ht->positions = new_positions;
+    ht->hashes = new_hashes;
+    ht->dense = new_dense;
+    ht->dense_count = count;
+    ht->capacity = new_capacity;
+    ht->deleted_count = 0;
+}
+
+/**
+ * Linear probing over slots of dense layout. Only slots with the same hash touch dense array.
+ * If item isn't found out_index is the first deleted or empty slot of probe sequence.
+ */
+static bool dense_find(htable_t *ht, const htable_item_base_t *item, uint32_t hash, size_t *out_index)
+{
+    size_t index = hash % ht->capacity;
+    bool deleted_found = false;
+    size_t deleted_index = 0;
+    uint32_t position;
+
+    for (size_t probe = 0; probe < ht->capacity; probe++)
+    {
+        position = ht->positions[index];
+        if (position == DENSE_EMPTY)
+            break;
+
+        if (position == DENSE_DELETED)
+        {
+            if (!deleted_found)
+                deleted_index = index;
+            deleted_found = true;
+        }
+        else if (ht->hashes[index] == hash && compare_items_key(ht->dense[position - DENSE_FIRST].item, item))
+        {
+            *out_index = index;
+            return true;
+        }
+        index = (index + 1) % ht->capacity;
+    }
+
+    SET_HTABLE_ERROR_AND_EXIT_WITH_VAL_IF(!deleted_found && ht->positions[index] != DENSE_EMPTY,
+                                          ht, HTABLE_FULL, false)
+    *out_index = (deleted_found) ? deleted_index : index;
+    return false;
+}
+
+/**
+ * Move item from old array (incremental rehashing) to new one
+ */
+static void migrate_item(htable_t *ht, size_t old_index, size_t index)
+{
+    htable_item_base_t *item = ht->old_items[old_index];
+    uint32_t hash = ht->old_hashes[old_index];
+
+    if (ht->items[index] == marked_as_deleted)
+        ht->deleted_count--;
+    ht->items[index] = item;
+    ht->hashes[index] = hash;
+    ht->old_items[old_index] = marked_as_deleted;  // Keep probe chains of old array unbroken
+}
+
+/**
+ * Look for item in old array (incremental rehashing).
+ * Found item is moved to new array at index (where it has to be inserted).
+ */
+static bool find_in_old(htable_t *ht, const htable_item_base_t *item, uint32_t hash, size_t index)
+{
+    size_t old_index = hash % ht->old_capacity;
+    htable_item_base_t *candidate;
+
+    for (size_t i = 0; i < ht->old_capacity; i++)
+    {
+        candidate = ht->old_items[old_index];
+        if (!candidate)
+            break;
+
+        if (ht->old_hashes[old_index] == hash && candidate != marked_as_deleted && compare_items_key(candidate, item))
+        {
+            migrate_item(ht, old_index, index);
+            return true;
+        }
+        old_index = (old_index + 1) % ht->old_capacity;
+    }
+    return false;
+}
+
+/**
+ * Move items from bounded number of slots of old array to new one.
+ */
+static void migrate(htable_t *ht, size_t steps)
+{
+    htable_item_base_t *item;
+    size_t index;
+
+    for (; steps && ht->migrate_index < ht->old_capacity; steps--, ht->migrate_index++)
+    {
+        item = ht->old_items[ht->migrate_index];
+        if (!item || item == marked_as_deleted)
+            continue;
+
+        index = ht->old_hashes[ht->migrate_index] % ht->capacity;
+        while (ht->items[index] && ht->items[index] != marked_as_deleted)
+            index = (index + 1) % ht->capacity;
+        migrate_item(ht, ht->migrate_index, index);
+    }
+
+    if (ht->migrate_index == ht->old_capacity)
+    {
+        mem_free(ht, ht->old_items);
+        ht->old_items = NULL;
+        ht->old_hashes = NULL;
+        ht->old_capacity = 0;
+    }
+}
+
+static void start_migration(htable_t *ht, size_t new_capacity)
+{
+    if (ht->old_items)
+        migrate(ht, SIZE_MAX);  // Previous migration has to be finished
+
+    htable_item_base_t **new_items = mem_calloc(ht, new_capacity, SLOT_SIZE);
+    CHECK_AND_EXIT_IF(!new_items)
+
+    ht->old_items = ht->items;
+    ht->old_hashes = ht->hashes;
+    ht->old_capacity = ht->capacity;
+    ht->migrate_index = 0;
+    ht->items = new_items;
+    ht->hashes = (uint32_t*)(new_items + new_capacity);
+    ht->capacity = new_capacity;
+    ht->deleted_count = 0;
+}
+
+/**
+ * Slot where probing of a miss stops: find returns the first free slot for insertion, but the miss
+ * went on past deleted slots (and full slots after them) up to an empty slot (group having one).
+ * Robin Hood probing stops exactly at the returned slot.
+ */
+static size_t miss_end_index(const htable_t *ht, size_t index)
+{
+    if (ht->flags & HTABLE_OPT_ROBIN_HOOD)
+        return index;
+
+    if (ht->flags & HTABLE_OPT_SWISS)
+    {
+        size_t groups = ht->capacity / SWISS_GROUP_SIZE;
+        size_t group = index / SWISS_GROUP_SIZE;
+        for (size_t probe = 1; probe < groups; probe++)
+        {
+            if (group_match(ht->ctrl + group * SWISS_GROUP_SIZE, CTRL_EMPTY))
+                break;
+            group = (group + 1) & (groups - 1);
+        }
+        return group * SWISS_GROUP_SIZE;
+    }
+
+    // Linear probing of empty table doesn't look past the home slot
+    CHECK_AND_EXIT_WITH_VAL_IF(!(ht->flags & HTABLE_OPT_DENSE) && !ht->items_count, index)
+    for (size_t probe = 1; probe < ht->capacity; probe++)
+    {
+        if ((ht->flags & HTABLE_OPT_DENSE) ? ht->positions[index] == DENSE_EMPTY : !ht->items[index])
+            break;
+        index = (index + 1) % ht->capacity;
+    }
+    return index;
+}
+
+/**
+ * Probe length of lookup: hits stop at the item, misses at the end of probe sequence.
+ */
+static void count_find_probes(htable_t *ht, uint32_t hash, size_t index, bool is_founded)
+{
+    count_probes(ht, ht->stats.find_probes, hash, (is_founded) ? index : miss_end_index(ht, index));
+}
+
+
+static bool find_hashed(htable_t *ht, const htable_item_base_t *item, uint32_t hash, size_t *out_index)
+{
+    if (ht->flags & HTABLE_OPT_SWISS)
+        return swiss_find(ht, item, hash, out_index);
+    if (ht->flags & HTABLE_OPT_ROBIN_HOOD)
+        return robin_hood_find(ht, item, hash, out_index);
+    if (ht->flags & HTABLE_OPT_DENSE)
+        return dense_find(ht, item, hash, out_index);
+
+    bool is_founded = linear_find(ht, item, hash, out_index);
+    if (!is_founded && ht->old_items && ht->last_error != HTABLE_FULL)
+        is_founded = find_in_old(ht, item, hash, *out_index);
+    return is_founded;
+}
+
+static bool filtered_find(htable_t *ht, const htable_item_base_t *item, uint32_t hash, size_t *out_index)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(ht->bloom && !bloom_may_contain(ht, hash), false)
+    return find_hashed(ht, item, hash, out_index);
+}
+
+static bool find(htable_t *ht, const htable_item_base_t *item, size_t *out_index)
+{
+    return filtered_find(ht, item, hash_key(ht, item->key, item->key_len), out_index);
+}
+
+static bool is_overloaded(htable_t *ht)
+{
+    // Evictions leave deleted marks at steady load, they are cleaned up before probes become long
+    if (ht->max_items && ht->deleted_count > (ht->max_items >> 1))
+        return true;
+    if (ht->flags & HTABLE_OPT_SWISS)
+        return ht->items_count + ht->deleted_count >= ht->capacity - (ht->capacity >> 3);
+    if (ht->flags & HTABLE_OPT_DENSE)
+        return ht->dense_count > (ht->capacity >> 1);  // Removed items occupy dense array until rehash
+    return ht->items_count + ht->deleted_count > (ht->capacity >> 1);
+}
+
+/**
+ * New item of dense layout is appended to dense array. It can be full only if the table failed to grow.
+ */
+static bool has_room(const htable_t *ht)
+{
+    return !(ht->flags & HTABLE_OPT_DENSE) || ht->dense_count < DENSE_CAPACITY(ht->capacity);
+}
+
+/**
+ * Whether count items (deleted marks included) fit into capacity slots without growing.
+ */
+static bool fits(const htable_t *ht, size_t capacity, size_t count)
+{
+    if (ht->flags & HTABLE_OPT_SWISS)
+        return count < capacity - (capacity >> 3);
+    return count <= (capacity >> 1);
+}
+
+static void grow(htable_t *ht)
+{
+    uint32_t *hashes = ht->hashes;
+    uint64_t start = (ht->flags & HTABLE_OPT_STATS) ? now_ns() : 0;
+
+    // Table is full of deleted slots - just clean them up
+    bool cleanup_only = ht->deleted_count > ht->items_count;
+
+    if (ht->flags & HTABLE_OPT_DENSE)
+        cleanup_only = ht->dense_count - ht->items_count > ht->items_count;
+
+    // Bounded table stops growing when it has room for deleted marks of evicted items too
+    if (ht->max_items && ht->max_items <= SIZE_MAX / 2 &&
+        fits(ht, ht->capacity, ht->max_items + (ht->max_items >> 1)))
+        cleanup_only = true;
+
+    if (ht->flags & HTABLE_OPT_SWISS)
+        swiss_rehash(ht, (cleanup_only) ? ht->capacity : ht->capacity << 1);
+    else if (ht->flags & HTABLE_OPT_DENSE)
+        dense_rehash(ht, (cleanup_only) ? ht->capacity : ht->capacity << 1);
+    else if (ht->flags & HTABLE_OPT_INCREMENTAL)
+        start_migration(ht, (cleanup_only || ht->capacity << 1 < ht->capacity) ? ht->capacity : ht->capacity << 1);
+    else if (cleanup_only)
+        rehash(ht, ht->capacity);
+    else
+        expand(ht);
+
+    // Every rebuild allocates new slot array, failed one leaves the table unchanged
+    CHECK_AND_EXIT_IF(ht->hashes == hashes)
+    if (ht->bloom)
+        bloom_rebuild(ht);
+    if (ht->flags & HTABLE_OPT_STATS)
+    {
+        ht->stats.resize_count++;
+        ht->stats.resize_ns += now_ns() - start;
+    }
+}
+
+/**
+ * Put new item to the slot found by find_hashed.
+ */
+static void insert_slot(htable_t *ht, size_t index, htable_item_base_t *item, uint32_t hash)
+{
+    if (ht->bloom)
+        bloom_add(ht, hash);
+    if (ht->flags & HTABLE_OPT_SWISS)
+    {
+        if (ht->ctrl[index] == CTRL_DELETED)
+            ht->deleted_count--;
+        ht->ctrl[index] = H2(hash);
+    }
+    else if (ht->flags & HTABLE_OPT_ROBIN_HOOD)
+    {
+        robin_hood_shift_insert(ht->items, ht->hashes, ht->capacity, index, item, hash);
+        return;
+    }
+    else if (ht->flags & HTABLE_OPT_DENSE)
+    {
+        if (ht->positions[index] == DENSE_DELETED)
+            ht->deleted_count--;
+        ht->dense[ht->dense_count] = (dense_entry_t){item, hash};
+        ht->positions[index] = ht->dense_count++ + DENSE_FIRST;
+        ht->hashes[index] = hash;
+        return;
+    }
+    else if (ht->items[index] == marked_as_deleted)
+    {
+        ht->deleted_count--;
+    }
+    ht->items[index] = item;
+    ht->hashes[index] = hash;
+}
+
+static void clear_slot(htable_t *ht, size_t index)
+{
+    if (ht->flags & HTABLE_OPT_SWISS)
+    {
+        // No probe goes through a group with empty slot, so deleted mark isn't needed there
+        if (group_match(ht->ctrl + (index & ~(size_t)(SWISS_GROUP_SIZE - 1)), CTRL_EMPTY))
+        {
+            ht->ctrl[index] = CTRL_EMPTY;
+        }
+        else
+        {
+            ht->ctrl[index] = CTRL_DELETED;
+            ht->deleted_count++;
+        }
+        ht->items[index] = NULL;
+    }
+    else if (ht->flags & HTABLE_OPT_ROBIN_HOOD)
+    {
+        // Backward shift deletion: following items move closer to their home slots, no deleted marks
+        size_t next = (index + 1) % ht->capacity;
+        while (ht->items[next] && probe_distance(ht->hashes[next], next, ht->capacity) > 0)
+        {
+            ht->items[index] = ht->items[next];
+            ht->hashes[index] = ht->hashes[next];
+            index = next;
+            next = (next + 1) % ht->capacity;
+        }
+        ht->items[index] = NULL;
+    }
+    else if (ht->flags & HTABLE_OPT_DENSE)
+    {
+        // Entry of dense array stays as a hole until rehash, so positions of other items don't change
+        *slot_ref(ht, index) = NULL;
+        ht->positions[index] = DENSE_DELETED;
+        ht->deleted_count++;
     }
-
-    htable_item_base_t *candidate = ht->items[index];
-
-    if (!candidate)
+    else
     {
-        *out_index = index;
-        return false;
+        ht->items[index] = marked_as_deleted;
+        ht->deleted_count++;
     }
+}
 
-    bool first_item_marked_as_deleted = false;
-    size_t index_of_first_item_marked_as_deleted = index;
-    if (candidate == marked_as_deleted)
-        first_item_marked_as_deleted = true;
+/**
+ * CLOCK eviction: the hand walks over slots clearing reference marks and evicts the first item
+ * without the mark, so it stops in two rounds at most. The table must not be empty.
+ */
+static void evict(htable_t *ht)
+{
+    if (ht->old_items)
+        migrate(ht, SIZE_MAX);
 
-    size_t stopper = index;
-    while (candidate)
+    size_t index;
+    htable_item_base_t **slot_item;
+    for (;;)
     {
-        if (candidate != marked_as_deleted && compare_items_key(candidate, item))
+        index = ht->clock_hand % ht->capacity;
+        ht->clock_hand = index + 1;
+        if (!is_full_slot(ht, index))
+            continue;
+        slot_item = slot_ref(ht, index);
+        if ((*slot_item)->flags & HTABLE_ITEM_REFERENCED)
         {
-            *out_index = index;
-            return true;
+            (*slot_item)->flags &= ~HTABLE_ITEM_REFERENCED;
+            continue;
         }
-
-        index++;
-        index %= ht->capacity;
-        candidate = ht->items[index];
-        SET_HTABLE_ERROR_AND_EXIT_WITH_VAL_IF(index == stopper, ht, HTABLE_FULL, false)
+        destroy_item(ht, *slot_item);
+        clear_slot(ht, index);
+        ht->items_count--;
+        ht->stats.evictions++;
+        return;
     }
+}
 
-    *out_index = (first_item_marked_as_deleted) ? index_of_first_item_marked_as_deleted: index;
-    return false;
+/**
+ * Lookup of bounded table: found item is marked for CLOCK, hits and misses are counted.
+ */
+static inline void count_lookup(htable_t *ht, htable_item_base_t *found_item)
+{
+    if (!ht->max_items)
+        return;
+    if (found_item)
+    {
+        found_item->flags |= HTABLE_ITEM_REFERENCED;
+        ht->stats.hits++;
+    }
+    else
+    {
+        ht->stats.misses++;
+    }
 }
 
 inline htable_status_t htable_status(htable_t *ht)
@@ -169,24 +1202,125 @@ item_destructor_t htable_set_item_destructor(htable_t *ht, item_destructor_t new
     return current_item_destructor;
 }
 
+size_t htable_set_inline_key_max(htable_t *ht, size_t inline_key_max)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, 0)
+    size_t current_inline_key_max = ht->inline_key_max;
+    ht->inline_key_max = inline_key_max;
+    return current_inline_key_max;
+}
+
+bool htable_set_max_items(htable_t *ht, size_t max_items)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, false)
+    CHECK_AND_EXIT_WITH_VAL_IF(ht->flags & HTABLE_OPT_ARENA, false)
+    ht->max_items = max_items;
+    while (max_items && ht->items_count > max_items)
+        evict(ht);
+    return true;
+}
+
 htable_t* htable_make(size_t init_len, uint32_t (*hash_func)(const uint8_t *key, size_t key_len))
 {
-    struct htable_t *htable = malloc(sizeof(struct htable_t));
+    htable_options_t options = {init_len, hash_func, 0, HTABLE_HASH_WORD, 0};
+    return htable_make_ex(&options);
+}
+
+htable_t* htable_make_ex(const htable_options_t *options)
+{
+    return htable_make_alloc(options, &default_allocator);
+}
+
+htable_t* htable_make_alloc(const htable_options_t *options, const htable_allocator_t *allocator)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!options, NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF(!allocator || !allocator->alloc || !allocator->free, NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF((options->flags & HTABLE_OPT_SWISS) && (options->flags & HTABLE_OPT_ROBIN_HOOD), NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF((options->flags & HTABLE_OPT_INCREMENTAL) &&
+                               (options->flags & (HTABLE_OPT_SWISS | HTABLE_OPT_ROBIN_HOOD)), NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF((options->flags & HTABLE_OPT_DENSE) &&
+                               (options->flags & (HTABLE_OPT_SWISS | HTABLE_OPT_ROBIN_HOOD | HTABLE_OPT_INCREMENTAL)), NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF(options->hash > HTABLE_HASH_JENKINS, NULL)
+    struct htable_t *htable = allocator->alloc(sizeof(struct htable_t), allocator->ctx);
     CHECK_AND_EXIT_WITH_VAL_IF(!htable, NULL)
+    htable->allocator = *allocator;
 
+    size_t init_len = options->init_len;
+    hash_func_t hash_func = options->hash_func;
     size_t capacity = (init_len < 8) ? 8 : init_len;
-    htable->items = calloc(capacity, sizeof(htable_item_base_t*));
-    if ( !htable->items )
+    htable->items = NULL;
+    htable->positions = NULL;
+    htable->dense = NULL;
+    if (options->flags & HTABLE_OPT_SWISS)
+    {
+        // Capacity of Swiss table is power of two and consists of whole groups
+        capacity = SWISS_GROUP_SIZE;
+        while (capacity < init_len && capacity <= SIZE_MAX / (SWISS_SLOT_SIZE << 1))
+            capacity <<= 1;
+        htable->items = swiss_alloc_slots(htable, capacity);
+    }
+    else if (options->flags & HTABLE_OPT_DENSE)
+    {
+        if (DENSE_CAPACITY(capacity) <= UINT32_MAX - DENSE_FIRST)
+            htable->positions = mem_calloc(htable, capacity, DENSE_SLOT_SIZE);
+        if (htable->positions)
+            htable->dense = mem_alloc(htable, DENSE_CAPACITY(capacity) * sizeof(dense_entry_t));
+        if (!htable->dense)
+        {
+            mem_free(htable, htable->positions);
+            mem_free(htable, htable);
+            return NULL;
+        }
+    }
+    else
+    {
+        htable->items = mem_calloc(htable, capacity, SLOT_SIZE);
+    }
+
+    if ( !htable->items && !htable->positions )
     {
-        free(htable);
+        mem_free(htable, htable);
         return NULL;
     }
+    if (htable->positions)
+        htable->hashes = htable->positions + capacity;
+    else
+        htable->hashes = (uint32_t*)(htable->items + capacity);
+    htable->ctrl = (options->flags & HTABLE_OPT_SWISS) ? (uint8_t*)(htable->hashes + capacity) : NULL;
 
-    htable->hash_func = (hash_func) ? hash_func : jenkins_one_at_a_time_hash;
+    htable->hash_func = hash_func;
+    htable->seeded_hash_func = word_hash;
+#ifdef HTABLE_HAVE_CRC32C
+    if (options->hash == HTABLE_HASH_CRC32C && htable_crc32c_supported())
+        htable->seeded_hash_func = crc32c_hash;
+#endif
+    if (options->hash == HTABLE_HASH_JENKINS)
+        htable->seeded_hash_func = jenkins_one_at_a_time_hash;
+    htable->seed = (options->flags & HTABLE_OPT_RANDOM_SEED) ? random_seed(htable) : options->seed;
     htable->item_destructor = default_item_destructor;
     htable->capacity = capacity;
     htable->items_count = 0;
+    htable->deleted_count = 0;
+    htable->dense_count = 0;
+    htable->old_items = NULL;
+    htable->old_hashes = NULL;
+    htable->old_capacity = 0;
+    htable->migrate_index = 0;
+    htable->inline_key_max = 0;
+    htable->flags = options->flags;
+    htable->arena = NULL;
+    htable->bloom = NULL;
+    htable->bloom_mem = NULL;
+    htable->bloom_blocks = 0;
+    htable->max_items = 0;
+    htable->clock_hand = 0;
+    memset(&htable->stats, 0, sizeof(htable->stats));
     htable->last_error = HTABLE_OK;
+    if ((options->flags & HTABLE_OPT_BLOOM) && !bloom_rebuild(htable))
+    {
+        htable_destroy(htable);
+        return NULL;
+    }
     return htable;
 }
 
@@ -195,105 +1329,386 @@ void htable_destroy(htable_t *ht)
     CHECK_AND_EXIT_IF(!ht)
     htable_item_base_t *item;
 
-    for (size_t i = 0; i < ht->capacity; i++)
+    // Arena items don't need default destructor, the arena is released at once
+    bool need_destruct = !(ht->flags & HTABLE_OPT_ARENA) || ht->item_destructor != default_item_destructor;
+    bool dense = ht->flags & HTABLE_OPT_DENSE;
+    size_t count = (dense) ? ht->dense_count : ht->capacity;
+    for (size_t i = 0; need_destruct && i < count; i++)
     {
-        item = ht->items[i];
+        item = (dense) ? ht->dense[i].item : ht->items[i];
+        if (item && item != marked_as_deleted)
+            destroy_item(ht, item);
+    }
+
+    for (size_t i = 0; need_destruct && i < ht->old_capacity; i++)
+    {
+        item = ht->old_items[i];
         if (item && item != marked_as_deleted)
-            ht->item_destructor(ht->items[i]);
+            destroy_item(ht, ht->old_items[i]);
     }
 
-    free(ht->items);
-    free(ht);
+    arena_destroy(ht);
+    mem_free(ht, ht->bloom_mem);
+    mem_free(ht, ht->old_items);
+    if (dense)
+    {
+        mem_free(ht, ht->positions);
+        mem_free(ht, ht->dense);
+    }
+    else
+    {
+        mem_free(ht, ht->items);
+    }
+    mem_free(ht, ht);
 }
 
 void htable_set(htable_t *ht, const htable_item_base_t *item, size_t item_size)
+{
+    CHECK_AND_EXIT_IF(!ht)
+    CHECK_AND_EXIT_IF(!item)
+    CHECK_AND_EXIT_IF(!item->key)
+    htable_set_hashed(ht, item, item_size, hash_key(ht, item->key, item->key_len));
+}
+
+void htable_set_hashed(htable_t *ht, const htable_item_base_t *item, size_t item_size, uint32_t hash)
 {
     CHECK_AND_EXIT_IF(!ht)
     CHECK_AND_EXIT_IF(!item)
     CHECK_AND_EXIT_IF(!item->key)
     CHECK_AND_EXIT_IF(item_size < sizeof(htable_item_base_t))
 
-    if (ht->items_count > (ht->capacity >> 1))
-        expand(ht);  // Expand && Rehash all items
+    if (ht->old_items)
+        migrate(ht, HTABLE_MIGRATE_STEP);
+
+    if (is_overloaded(ht))
+        grow(ht);  // Expand && Rehash all items
 
     size_t index;
-    bool is_founded = find(ht, item, &index);
-    CHECK_AND_EXIT_IF(ht->last_error == HTABLE_FULL)
+    bool is_founded = find_hashed(ht, item, hash, &index);
+    htable_item_base_t *candidate = NULL;
+    if (!is_founded && ht->max_items && ht->items_count >= ht->max_items)
+    {
+        // Nothing is evicted if the new item can't be made
+        candidate = make_item(ht, item, item_size);
+        SET_HTABLE_ERROR_AND_EXIT_IF(!candidate, ht, HTABLE_MEM_ERROR)
+        evict(ht);  // Slots may be shifted, find the slot again
+        is_founded = find_hashed(ht, item, hash, &index);
+    }
+    if (ht->last_error == HTABLE_FULL || (!is_founded && !has_room(ht)))
+    {
+        release_item(ht, candidate);
+        ht->last_error = HTABLE_FULL;
+        return;
+    }
 
-    htable_item_base_t *candidate = (htable_item_base_t*)calloc(1, item_size);
+    if (!candidate)
+        candidate = make_item(ht, item, item_size);
     SET_HTABLE_ERROR_AND_EXIT_IF(!candidate, ht, HTABLE_MEM_ERROR)
 
-    memcpy(candidate, item, item_size);
-    candidate->key = calloc(1, candidate->key_len);
-    if (!candidate->key)
+    if (is_founded)
     {
-        free(candidate);
-        ht->last_error = HTABLE_MEM_ERROR;
-        return;
+        htable_item_base_t **slot_item = slot_ref(ht, index);
+        destroy_item(ht, *slot_item);
+        *slot_item = candidate;  // Replaced item keeps its position in dense layout
     }
+    else
+    {
+        if (ht->flags & HTABLE_OPT_STATS)
+            count_probes(ht, ht->stats.insert_probes, hash, index);
+        insert_slot(ht, index, candidate, hash);
+        ht->items_count++;
+    }
+    ht->last_error = HTABLE_OK;
+}
 
-    if (is_founded)
+htable_item_base_t *htable_upsert(htable_t *ht, const htable_item_base_t *item, size_t item_size, bool *inserted)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF(!item, NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF(!item->key, NULL)
+    return htable_upsert_hashed(ht, item, item_size, hash_key(ht, item->key, item->key_len), inserted);
+}
+
+htable_item_base_t *htable_upsert_hashed(htable_t *ht, const htable_item_base_t *item, size_t item_size,
+                                         uint32_t hash, bool *inserted)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF(!item, NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF(!item->key, NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF(item_size < sizeof(htable_item_base_t), NULL)
+
+    if (ht->old_items)
+        migrate(ht, HTABLE_MIGRATE_STEP);
+
+    size_t index;
+    bool is_founded = find_hashed(ht, item, hash, &index);
+    if (!is_founded && is_overloaded(ht))
+    {
+        grow(ht);  // Expand && Rehash all items, then find the slot again
+        is_founded = find_hashed(ht, item, hash, &index);
+    }
+    htable_item_base_t *candidate = NULL;
+    if (!is_founded && ht->max_items && ht->items_count >= ht->max_items)
+    {
+        // Nothing is evicted if the new item can't be made
+        candidate = make_item(ht, item, item_size);
+        SET_HTABLE_ERROR_AND_EXIT_WITH_VAL_IF(!candidate, ht, HTABLE_MEM_ERROR, NULL)
+        evict(ht);
+        is_founded = find_hashed(ht, item, hash, &index);
+    }
+    if (ht->last_error == HTABLE_FULL || (!is_founded && !has_room(ht)))
     {
-       ht->item_destructor(ht->items[index]);
-       ht->items_count--;
+        release_item(ht, candidate);
+        ht->last_error = HTABLE_FULL;
+        return NULL;
     }
 
-    memcpy(candidate->key, item->key, candidate->key_len);
-    ht->items[index] = candidate;
-    ht->items_count++;
+    if (inserted)
+        *inserted = !is_founded;
     ht->last_error = HTABLE_OK;
+    count_lookup(ht, (is_founded) ? *slot_ref(ht, index) : NULL);
+    if (is_founded)
+        return *slot_ref(ht, index);
+
+    if (!candidate)
+        candidate = make_item(ht, item, item_size);
+    SET_HTABLE_ERROR_AND_EXIT_WITH_VAL_IF(!candidate, ht, HTABLE_MEM_ERROR, NULL)
+
+    if (ht->flags & HTABLE_OPT_STATS)
+        count_probes(ht, ht->stats.insert_probes, hash, index);
+    insert_slot(ht, index, candidate, hash);
+    ht->items_count++;
+    return candidate;
 }
 
-void htable_enumerate_items(htable_t *ht, int (*callback)(htable_item_base_t *item))
+/**
+ * Call callback (or callback_ex with ctx) for every item.
+ */
+static bool enumerate(htable_t *ht, int (*callback)(htable_item_base_t *item),
+                      int (*callback_ex)(htable_item_base_t *item, void *ctx), void *ctx)
 {
-    CHECK_AND_EXIT_IF(!ht)
-    CHECK_AND_EXIT_IF(!callback)
     int callback_result;
     htable_item_base_t *item;
 
-    for (size_t i = 0; i < ht->capacity; i++)
+    if (ht->old_items)
+        migrate(ht, SIZE_MAX);
+
+    // Dense layout: only dense array is walked, items come in insertion order
+    bool dense = ht->flags & HTABLE_OPT_DENSE;
+    size_t count = (dense) ? ht->dense_count : ht->capacity;
+    for (size_t i = 0; i < count; i++)
     {
-        item = ht->items[i];
+        item = (dense) ? ht->dense[i].item : ht->items[i];
         if (item && item != marked_as_deleted)
         {
-            callback_result = callback(ht->items[i]);
+            callback_result = (callback) ? callback(item) : callback_ex(item, ctx);
             if( !callback_result )
-                break;
+                return false;
+        }
+    }
+    return true;
+}
+
+bool htable_enumerate_items(htable_t *ht, int (*callback)(htable_item_base_t *item))
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, true)
+    CHECK_AND_EXIT_WITH_VAL_IF(!callback, true)
+    return enumerate(ht, callback, NULL, NULL);
+}
+
+bool htable_enumerate_items_ex(htable_t *ht, int (*callback)(htable_item_base_t *item, void *ctx), void *ctx)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, true)
+    CHECK_AND_EXIT_WITH_VAL_IF(!callback, true)
+    return enumerate(ht, NULL, callback, ctx);
+}
+
+uint64_t htable_random_seed(void)
+{
+    uint8_t salt;  // Address of stack variable is randomized too
+    return random_seed(&salt);
+}
+
+uint32_t htable_hash(const htable_t *ht, const uint8_t *key, size_t key_len)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, 0)
+    CHECK_AND_EXIT_WITH_VAL_IF(!key, 0)
+    return hash_key(ht, key, key_len);
+}
+
+size_t htable_find_batch(htable_t *ht, const htable_item_base_t * const *items, size_t count,
+                         htable_item_base_t **out_items)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, 0)
+    CHECK_AND_EXIT_WITH_VAL_IF(!items, 0)
+    CHECK_AND_EXIT_WITH_VAL_IF(!out_items, 0)
+
+    uint32_t hashes[HTABLE_BATCH_SIZE];
+    size_t homes[HTABLE_BATCH_SIZE];
+    bool rejected[HTABLE_BATCH_SIZE] = { false };
+    size_t found_count = 0, batch, index;
+    const htable_item_base_t *item;
+    htable_item_base_t *candidate;
+    uint32_t match;
+
+    for (size_t first = 0; first < count; first += batch)
+    {
+        batch = (count - first < HTABLE_BATCH_SIZE) ? count - first : HTABLE_BATCH_SIZE;
+        if (ht->old_items)
+            migrate(ht, HTABLE_MIGRATE_STEP);
+
+        // Stage 1: hash all keys and prefetch their home slots (or Bloom filter blocks)
+        for (size_t i = 0; i < batch; i++)
+        {
+            item = items[first + i];
+            if (!item || !item->key)
+                continue;
+            hashes[i] = hash_key(ht, item->key, item->key_len);
+            homes[i] = home_index(ht, hashes[i]);
+            if (ht->bloom)
+            {
+                __builtin_prefetch(bloom_block(ht, hashes[i]));
+                continue;
+            }
+            if (ht->positions)
+                __builtin_prefetch(&ht->positions[homes[i]]);
+            else
+                __builtin_prefetch(&ht->items[homes[i]]);
+            __builtin_prefetch(&ht->hashes[homes[i]]);
+            if (ht->ctrl)
+                __builtin_prefetch(&ht->ctrl[homes[i]]);
+        }
+
+        // Stage 1a: Bloom filter answers definite misses, home slots are prefetched for the rest
+        for (size_t i = 0; ht->bloom && i < batch; i++)
+        {
+            item = items[first + i];
+            if (!item || !item->key)
+                continue;
+            rejected[i] = bloom_rejects(ht, hashes[i]);
+            if (rejected[i])
+                continue;
+            if (ht->positions)
+                __builtin_prefetch(&ht->positions[homes[i]]);
+            else
+                __builtin_prefetch(&ht->items[homes[i]]);
+            __builtin_prefetch(&ht->hashes[homes[i]]);
+            if (ht->ctrl)
+                __builtin_prefetch(&ht->ctrl[homes[i]]);
+        }
+
+        // Stage 2: prefetch items which keys will be compared first
+        for (size_t i = 0; i < batch; i++)
+        {
+            item = items[first + i];
+            if (!item || !item->key || rejected[i])
+                continue;
+            index = homes[i];
+            if (ht->positions)
+            {
+                if (ht->positions[index] >= DENSE_FIRST)
+                    __builtin_prefetch(&ht->dense[ht->positions[index] - DENSE_FIRST]);
+                continue;
+            }
+            if (ht->ctrl)
+            {
+                match = group_match(ht->ctrl + index, H2(hashes[i]));
+                if (!match)
+                    continue;  // The key is not in home group or the group is full
+                index += __builtin_ctz(match);
+            }
+            candidate = ht->items[index];
+            if (candidate && candidate != marked_as_deleted)
+                __builtin_prefetch(candidate);
+        }
+
+        // Stage 3: probe, slots and items are in cache (or on the way) by now
+        for (size_t i = 0; i < batch; i++)
+        {
+            item = items[first + i];
+            out_items[first + i] = NULL;
+            if (!item || !item->key)
+                continue;
+            if (rejected[i])
+            {
+                count_lookup(ht, NULL);
+                continue;
+            }
+            if (find_hashed(ht, item, hashes[i], &index))
+            {
+                out_items[first + i] = *slot_ref(ht, index);
+                found_count++;
+            }
+            count_lookup(ht, out_items[first + i]);
+            if ((ht->flags & HTABLE_OPT_STATS) && ht->last_error != HTABLE_FULL)
+                count_find_probes(ht, hashes[i], index, out_items[first + i] != NULL);
         }
     }
+    return found_count;
 }
 
 bool htable_find(htable_t *ht, const htable_item_base_t *item, htable_item_base_t **out_item)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, false)
+    CHECK_AND_EXIT_WITH_VAL_IF(!item, false)
+    CHECK_AND_EXIT_WITH_VAL_IF(!item->key, false)
+    return htable_find_hashed(ht, item, hash_key(ht, item->key, item->key_len), out_item);
+}
+
+bool htable_find_hashed(htable_t *ht, const htable_item_base_t *item, uint32_t hash, htable_item_base_t **out_item)
 {
     CHECK_AND_EXIT_WITH_VAL_IF(!ht, false)
     CHECK_AND_EXIT_WITH_VAL_IF(!item, false)
     CHECK_AND_EXIT_WITH_VAL_IF(!item->key, false)
 
+    if (ht->old_items)
+        migrate(ht, HTABLE_MIGRATE_STEP);
+
     size_t index;
-    bool is_founded = find(ht, item, &index);
+    if (bloom_rejects(ht, hash))
+    {
+        count_lookup(ht, NULL);
+        return false;
+    }
+    bool is_founded = find_hashed(ht, item, hash, &index);
+
+    if ((ht->flags & HTABLE_OPT_STATS) && ht->last_error != HTABLE_FULL)
+        count_find_probes(ht, hash, index, is_founded);
 
+    count_lookup(ht, (is_founded) ? *slot_ref(ht, index) : NULL);
     if (is_founded)
     {
         if (out_item)
-            *out_item = ht->items[index];
+            *out_item = *slot_ref(ht, index);
         return true;
     }
     return false;
 }
 
 bool htable_remove(htable_t *ht, const htable_item_base_t *item)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, false)
+    CHECK_AND_EXIT_WITH_VAL_IF(!item, false)
+    CHECK_AND_EXIT_WITH_VAL_IF(!item->key, false)
+    return htable_remove_hashed(ht, item, hash_key(ht, item->key, item->key_len));
+}
+
+bool htable_remove_hashed(htable_t *ht, const htable_item_base_t *item, uint32_t hash)
 {
     CHECK_AND_EXIT_WITH_VAL_IF(!ht, false)
     CHECK_AND_EXIT_WITH_VAL_IF(!item, false)
     CHECK_AND_EXIT_WITH_VAL_IF(!item->key, false)
 
+    if (ht->old_items)
+        migrate(ht, HTABLE_MIGRATE_STEP);
+
     size_t index;
-    bool is_founded = find(ht, item, &index);
+    bool is_founded = filtered_find(ht, item, hash, &index);
     if (!is_founded)
         return false;
 
-    ht->item_destructor(ht->items[index]);
-    ht->items[index] = marked_as_deleted;
+    destroy_item(ht, *slot_ref(ht, index));
+    clear_slot(ht, index);
     ht->last_error = HTABLE_OK;
     ht->items_count--;
     return true;
@@ -305,14 +1720,217 @@ htable_item_base_t *htable_pop(htable_t *ht, const htable_item_base_t *item)
     CHECK_AND_EXIT_WITH_VAL_IF(!item, NULL)
     CHECK_AND_EXIT_WITH_VAL_IF(!item->key, NULL)
 
+    if (ht->old_items)
+        migrate(ht, HTABLE_MIGRATE_STEP);
+
     size_t index;
     bool is_founded = find(ht, item, &index);
     if (!is_founded)
         return NULL;
 
-    htable_item_base_t *res = ht->items[index];
-    ht->items[index] = marked_as_deleted;
+    htable_item_base_t *res = *slot_ref(ht, index);
+    clear_slot(ht, index);
     ht->last_error = HTABLE_OK;
     ht->items_count--;
     return res;
 }
+
+/**
+ * Make room for items_count + count items, so they are inserted without growing.
+ * Slot array is rebuilt at most once, deleted marks are dropped by the rebuild.
+ */
+static bool reserve(htable_t *ht, size_t count)
+{
+    if (ht->old_items)
+        migrate(ht, SIZE_MAX);
+
+    size_t used = (ht->flags & HTABLE_OPT_DENSE) ? ht->dense_count : ht->items_count + ht->deleted_count;
+    CHECK_AND_EXIT_WITH_VAL_IF(count > SIZE_MAX - used, false)
+    CHECK_AND_EXIT_WITH_VAL_IF(fits(ht, ht->capacity, used + count), true)
+
+    size_t new_capacity = ht->capacity;
+    count += ht->items_count;
+    while (!fits(ht, new_capacity, count))
+    {
+        CHECK_AND_EXIT_WITH_VAL_IF(new_capacity << 1 < new_capacity, false) // overflow control.
+        new_capacity <<= 1;
+    }
+
+    uint32_t *hashes = ht->hashes;
+    uint64_t start = (ht->flags & HTABLE_OPT_STATS) ? now_ns() : 0;
+    if (ht->flags & HTABLE_OPT_SWISS)
+        swiss_rehash(ht, new_capacity);
+    else if (ht->flags & HTABLE_OPT_DENSE)
+        dense_rehash(ht, new_capacity);
+    else
+        rehash(ht, new_capacity);  // Incremental layout is rebuilt at once too, migration is finished above
+
+    // Every rebuild allocates new slot array, failed one leaves the table unchanged
+    CHECK_AND_EXIT_WITH_VAL_IF(ht->hashes == hashes, false)
+    if (ht->bloom)
+        bloom_rebuild(ht);
+    if (ht->flags & HTABLE_OPT_STATS)
+    {
+        ht->stats.resize_count++;
+        ht->stats.resize_ns += now_ns() - start;
+    }
+    return true;
+}
+
+/**
+ * Put item of another table into reserved table.
+ */
+static void merge_item(htable_t *dst, htable_item_base_t *item, uint32_t hash, item_combine_t combine)
+{
+    size_t index;
+    if (find_hashed(dst, item, hash, &index))
+    {
+        htable_item_base_t **slot_item = slot_ref(dst, index);
+        if (combine)
+        {
+            combine(*slot_item, item);
+            destroy_item(dst, item);
+        }
+        else
+        {
+            destroy_item(dst, *slot_item);
+            *slot_item = item;
+        }
+        return;
+    }
+
+    if (dst->flags & HTABLE_OPT_STATS)
+        count_probes(dst, dst->stats.insert_probes, hash, index);
+    insert_slot(dst, index, item, hash);
+    dst->items_count++;
+}
+
+bool htable_merge(htable_t *dst, htable_t *src, item_combine_t combine)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!dst, false)
+    CHECK_AND_EXIT_WITH_VAL_IF(!src, false)
+    CHECK_AND_EXIT_WITH_VAL_IF(dst == src, false)
+    CHECK_AND_EXIT_WITH_VAL_IF(dst->max_items, false)  // Reserved room would exceed the limit
+    // Moved items are released by dst, so they have to be allocated and destroyed the same way
+    CHECK_AND_EXIT_WITH_VAL_IF(dst->allocator.alloc != src->allocator.alloc ||
+                               dst->allocator.free != src->allocator.free ||
+                               dst->allocator.ctx != src->allocator.ctx, false)
+    CHECK_AND_EXIT_WITH_VAL_IF(dst->item_destructor != src->item_destructor, false)
+    // Arena table with default destructor doesn't destroy items one by one, heap items would leak
+    CHECK_AND_EXIT_WITH_VAL_IF((dst->flags & HTABLE_OPT_ARENA) && !(src->flags & HTABLE_OPT_ARENA) &&
+                               dst->item_destructor == default_item_destructor, false)
+
+    if (src->old_items)
+        migrate(src, SIZE_MAX);
+    SET_HTABLE_ERROR_AND_EXIT_WITH_VAL_IF(!reserve(dst, src->items_count), dst, HTABLE_MEM_ERROR, false)
+
+    bool same_hash = dst->hash_func == src->hash_func &&
+                     (dst->hash_func || (dst->seeded_hash_func == src->seeded_hash_func && dst->seed == src->seed));
+    htable_item_base_t *item;
+    uint32_t hash;
+
+    // Dense layout: items are walked in insertion order and keep it in dense dst
+    bool dense = src->flags & HTABLE_OPT_DENSE;
+    size_t count = (dense) ? src->dense_count : src->capacity;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (dense)
+        {
+            item = src->dense[i].item;
+            hash = src->dense[i].hash;
+        }
+        else
+        {
+            item = (is_full_slot(src, i)) ? src->items[i] : NULL;
+            hash = src->hashes[i];
+        }
+        if (!item)
+            continue;
+        merge_item(dst, item, (same_hash) ? hash : hash_key(dst, item->key, item->key_len), combine);
+    }
+
+    // Chunks of src go after the current chunk of dst, so dst keeps allocating from it
+    if (src->arena)
+    {
+        arena_chunk_t **tail = &dst->arena;
+        while (*tail)
+            tail = &(*tail)->next;
+        *tail = src->arena;
+        src->arena = NULL;
+    }
+
+    if (dense)
+    {
+        memset(src->positions, DENSE_EMPTY, src->capacity * sizeof(uint32_t));
+        src->dense_count = 0;
+    }
+    else
+    {
+        memset(src->items, 0, src->capacity * sizeof(htable_item_base_t*));
+    }
+    if (src->ctrl)
+        memset(src->ctrl, CTRL_EMPTY, src->capacity);
+    if (src->bloom)
+        memset(src->bloom, 0, src->bloom_blocks * BLOOM_BLOCK_SIZE);
+    src->items_count = 0;
+    src->deleted_count = 0;
+    src->last_error = HTABLE_OK;
+    dst->last_error = HTABLE_OK;
+    return true;
+}
+
+bool htable_stats(htable_t *ht, htable_stats_t *stats)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, false)
+    CHECK_AND_EXIT_WITH_VAL_IF(!stats, false)
+
+    if (ht->old_items)
+        migrate(ht, SIZE_MAX);
+
+    // Items per home slot (per home group for Swiss layout)
+    size_t home_size = (ht->flags & HTABLE_OPT_SWISS) ? SWISS_GROUP_SIZE : 1;
+    size_t homes_count = ht->capacity / home_size;
+    uint32_t *home_items = mem_calloc(ht, homes_count, sizeof(uint32_t));
+    SET_HTABLE_ERROR_AND_EXIT_WITH_VAL_IF(!home_items, ht, HTABLE_MEM_ERROR, false)
+
+    memset(stats, 0, sizeof(*stats));
+    stats->items_count = ht->items_count;
+    stats->capacity = ht->capacity;
+    stats->deleted_count = ht->deleted_count;
+    stats->load_factor = (double)ht->items_count / ht->capacity;
+    stats->resize_count = ht->stats.resize_count;
+    stats->resize_ns = ht->stats.resize_ns;
+    memcpy(stats->find_probes, ht->stats.find_probes, sizeof(stats->find_probes));
+    memcpy(stats->insert_probes, ht->stats.insert_probes, sizeof(stats->insert_probes));
+    stats->hits = ht->stats.hits;
+    stats->misses = ht->stats.misses;
+    stats->evictions = ht->stats.evictions;
+    stats->bloom_rejects = ht->stats.bloom_rejects;
+
+    size_t count = 0, probes, total_probes = 0;
+    for (size_t i = 0; i < ht->capacity; i++)
+    {
+        if (!is_full_slot(ht, i))
+            continue;
+        probes = probe_length(ht, ht->hashes[i], i);
+        total_probes += probes;
+        if (probes > stats->max_probes)
+            stats->max_probes = probes;
+        home_items[home_index(ht, ht->hashes[i]) / home_size]++;
+        count++;
+    }
+
+    double squares = 0;
+    for (size_t i = 0; i < homes_count; i++)
+        squares += (double)home_items[i] * home_items[i];
+    mem_free(ht, home_items);
+
+    if (count)
+    {
+        // Items of uniform hash are Poisson distributed over home slots: variance equals mean
+        double mean = (double)count / homes_count;
+        stats->mean_probes = (double)total_probes / count;
+        stats->hash_dispersion = (squares / homes_count - mean * mean) / mean;
+    }
+    return true;
+}
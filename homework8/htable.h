@@ -11,8 +11,13 @@ typedef struct
 {
     uint8_t *key;           // Pointer to a buffer with key
     size_t key_len;         // length of key's buffer
+    uint32_t flags;         // Set by hash table (see HTABLE_ITEM_* flags). Must not be changed!
 } htable_item_base_t;
 
+#define HTABLE_ITEM_INLINE_KEY 0x1  // The key is stored in the same allocation right after the item
+#define HTABLE_ITEM_ARENA      0x2  // The item (and key) is allocated from arena owned by hash table
+#define HTABLE_ITEM_REFERENCED 0x4  // The item was found since eviction hand passed it (bounded table only)
+
 typedef uint32_t (*hash_func_t)(const uint8_t *key, size_t key_len);
 typedef void (*item_destructor_t)(htable_item_base_t *item);
 
@@ -27,10 +32,108 @@ typedef void (*item_destructor_t)(htable_item_base_t *item);
  *
  *   \details The hash function takes a pointer to a key buffer, the length of the buffer,
  *   and returns the computed hash value for specified key.
- *   If NULL specified for the hashfunc parameter the default hash function will be used.
+ *   If NULL specified for the hashfunc parameter the default hash function (HTABLE_HASH_WORD with zero seed)
+ *   will be used.
  */
 htable_t* htable_make(size_t init_len, hash_func_t hash_func);
 
+#define HTABLE_OPT_ARENA 0x1  // Items and keys are allocated from arenas owned by hash table
+#define HTABLE_OPT_SWISS 0x2  // Swiss table layout: slots have control bytes probed by groups
+#define HTABLE_OPT_ROBIN_HOOD 0x4  // Robin Hood probing with backward shift deletion (no deleted marks)
+#define HTABLE_OPT_INCREMENTAL 0x8 // Incremental rehashing: no long stalls when table grows
+#define HTABLE_OPT_RANDOM_SEED 0x10 // Seed of built-in hash function is chosen randomly
+#define HTABLE_OPT_DENSE 0x20       // Items are kept in insertion order in dense array, slots are indices
+#define HTABLE_OPT_STATS 0x40       // Resizes and probe lengths are counted (see htable_stats)
+#define HTABLE_OPT_BLOOM 0x80       // Bloom filter answers lookups of missing keys without probing slots
+
+#define HTABLE_HASH_WORD    0  // 64-bit word-at-a-time hash (default)
+#define HTABLE_HASH_CRC32C  1  // SSE4.2 CRC32C hash (HTABLE_HASH_WORD if CPU doesn't support SSE4.2)
+#define HTABLE_HASH_JENKINS 2  // Jenkins one-at-a-time hash
+
+typedef struct
+{
+    size_t init_len;        // The initial number of items in the hash table
+    hash_func_t hash_func;  // The Pointer to your own hash function or NULL
+    uint32_t flags;         // Combination of HTABLE_OPT_* flags
+    uint32_t hash;          // Built-in hash function (HTABLE_HASH_*), used if hash_func is NULL
+    uint64_t seed;          // Seed of built-in hash function
+} htable_options_t;
+
+/**
+ *   Make a hash table with specified options
+ *
+ *   \param [in] options - The pointer to options of hash table
+ *
+ *   \return It returns pointer to the instance of hash table or NULL if error happened
+ *
+ *   \details Fields init_len and hash_func have the same meaning as parameters of htable_make.
+ *   HTABLE_OPT_ARENA - items and keys are allocated from big chunks owned by hash table,
+ *   so htable_set is just a pointer bump and htable_destroy releases few chunks instead of
+ *   every item (when default item destructor is used). Memory of removed or replaced items
+ *   is reclaimed by htable_destroy only. Such items have HTABLE_ITEM_ARENA flag.
+ *   HTABLE_OPT_SWISS - every slot has a control byte (empty, deleted or 7 bits of hash).
+ *   Control bytes are grouped by 16 and one SSE2 compare finds candidates in the whole group,
+ *   so the table can be loaded up to 7/8 of capacity. Capacity is rounded up to power of two.
+ *   HTABLE_OPT_ROBIN_HOOD - an item being inserted takes the slot of an item that is closer to
+ *   its home slot, and removal shifts following items back instead of leaving deleted marks,
+ *   so probe length stays bounded under steady insert/remove churn. It can't be combined with
+ *   HTABLE_OPT_SWISS (NULL is returned).
+ *   HTABLE_OPT_INCREMENTAL - when table grows the old slot array is kept alongside the new one,
+ *   and every htable_set, htable_find, htable_remove, htable_pop call moves a bounded number
+ *   of slots to the new array. Lookups check both arrays until migration finishes
+ *   (htable_enumerate_items finishes it at once). It can't be combined with HTABLE_OPT_SWISS
+ *   or HTABLE_OPT_ROBIN_HOOD (NULL is returned).
+ *   If hash_func is NULL the built-in hash function selected by hash field is used with the seed.
+ *   HTABLE_HASH_WORD reads keys by 8 bytes and is the default one. HTABLE_HASH_CRC32C is the fastest
+ *   on x86-64 with SSE4.2, but CRC is linear, so the seed doesn't make collisions hard to guess.
+ *   HTABLE_HASH_JENKINS with zero seed is the hash function used by previous versions.
+ *   HTABLE_OPT_RANDOM_SEED - the seed field is ignored and the seed is chosen at creation, so keys
+ *   colliding in one table (or run) don't collide in another. Use it for input you don't control.
+ *   Unknown hash field makes NULL returned.
+ *   HTABLE_OPT_DENSE - items are kept in a dense array in insertion order and every slot keeps
+ *   32-bit position in it (and the hash), so slots take 8 bytes instead of 12. htable_enumerate_items
+ *   and htable_destroy walk only the dense array, and items are enumerated in insertion order
+ *   (a replaced item keeps its position). Removed items leave holes which are squeezed out when
+ *   the table grows. It can't be combined with HTABLE_OPT_SWISS, HTABLE_OPT_ROBIN_HOOD or
+ *   HTABLE_OPT_INCREMENTAL (NULL is returned).
+ *   HTABLE_OPT_STATS - resizes (number and time) and probe lengths of finds and inserts are counted
+ *   for htable_stats. Without it every operation just skips one flag test.
+ *   HTABLE_OPT_BLOOM - a blocked Bloom filter (about 2 bytes per slot) is kept next to the slots:
+ *   every key sets 8 bits in one 64-byte block, so htable_find, htable_find_batch, htable_remove and
+ *   htable_pop reject most missing keys after reading one cache line, without probing slots or
+ *   comparing keys. It pays off when most lookups miss (e.g. a table used as a set of exceptions),
+ *   for hit-heavy lookups it is one more cache line per lookup. HTABLE_OPT_SWISS rejects missing keys
+ *   by control bytes of one group already, so the filter only slows it down. The filter is rebuilt from stored
+ *   hashes when the slot array is rebuilt, so bits of removed (or evicted) keys stay set until then.
+ *   It can be combined with any layout.
+ */
+htable_t* htable_make_ex(const htable_options_t *options);
+
+typedef struct
+{
+    void *(*alloc)(size_t size, void *ctx);  // Returns NULL if memory can't be allocated
+    void (*free)(void *p, void *ctx);        // Never called with NULL
+    void *ctx;                               // Passed to alloc and free as is
+} htable_allocator_t;
+
+/**
+ *   Make a hash table which allocates memory with specified allocator
+ *
+ *   \param [in] options - The pointer to options of hash table (see htable_make_ex)
+ *
+ *   \param [in] allocator - The pointer to allocator, it's copied so it can be a temporary one
+ *
+ *   \return It returns pointer to the instance of hash table or NULL if error happened
+ *
+ *   \details The table itself, slot arrays, items, keys and arena chunks are allocated by alloc and
+ *   released by free of allocator, e.g. per-thread arenas, NUMA-local pools or counting allocators.
+ *   Memory returned by alloc has to be aligned as malloc does. NULL is returned if alloc or free is NULL.
+ *   Default item destructor releases items with the allocator too, but your own item destructor and
+ *   the caller of htable_pop have to release items with it themselves (unless HTABLE_ITEM_ARENA is set).
+ *   htable_make_ex is the same as this function with the allocator calling malloc and free.
+ */
+htable_t* htable_make_alloc(const htable_options_t *options, const htable_allocator_t *allocator);
+
 
 /**
  *  Destroy the hash table
@@ -59,6 +162,25 @@ void htable_destroy(htable_t *ht);
  */
 void htable_set(htable_t *ht, const htable_item_base_t *item, size_t item_size);
 
+/**
+ *  Find item or insert it if it isn't in the hash table
+ *
+ *  \param [in] ht - The instance of hash table
+ *
+ *  \param [in] item - Pointer to a htable_item_base_t structure (or compatible structure)
+ *
+ *  \param [in] item_size - Size of item
+ *
+ *  \param [out] inserted - The pointer where true is returned if new item was inserted (can be NULL)
+ *
+ *  \return It returns pointer to the item stored in hash table or NULL if error happened.
+ *
+ *  \details The key is hashed and probed only once. If the key of item is in the hash table the stored item is
+ *  returned and nothing is changed. Otherwise a copy of item is inserted (like htable_set does), so item is
+ *  the initial value of new item. Fields key, key_len of returned item must not be changed!!
+ */
+htable_item_base_t *htable_upsert(htable_t *ht, const htable_item_base_t *item, size_t item_size, bool *inserted);
+
 /**
  *  Remove item from the hashtable
  *
@@ -84,10 +206,37 @@ bool htable_remove(htable_t *ht, const htable_item_base_t *item);
  *
  *  \details This function doesn't call htable_item_destructor for removed item just returns it.
  *  (see htable_set_item_destructor function description). You must free item itself and all
- *  associated resources yourself.
+ *  associated resources yourself. Don't free the key if HTABLE_ITEM_INLINE_KEY flag is set for item.
+ *  Don't free item at all if HTABLE_ITEM_ARENA flag is set, it stays valid until htable_destroy is called.
+ *  Use free of allocator if the table was made by htable_make_alloc.
  */
  htable_item_base_t *htable_pop(htable_t *ht, const htable_item_base_t *item);
 
+typedef void (*item_combine_t)(htable_item_base_t *dst_item, const htable_item_base_t *src_item);
+
+/**
+ *  Move all items from one hash table to another
+ *
+ *  \param [in] dst - The instance of hash table items are moved to
+ *
+ *  \param [in] src - The instance of hash table items are moved from, it's empty after the call
+ *
+ *  \param [in] combine - The pointer to function that is called if key is in both tables (can be NULL)
+ *
+ *  \return It returns true if items were moved or false if error happened (nothing is moved then).
+ *
+ *  \details Items are moved without copying items and keys: item pointers are put into slots of dst,
+ *  arena chunks of src are handed over to dst. Stored hashes are reused if both tables have the same
+ *  hash function (and seed), keys are rehashed otherwise. Slot array of dst is grown once for all items.
+ *  If key is in both tables combine gets both items and has to fold value of src_item into dst_item,
+ *  then src_item is released with item destructor. Without combine src_item replaces dst_item (like htable_set).
+ *  src keeps its capacity and can be filled again. Tables must use the same allocator and item destructor,
+ *  src must use arena if dst does (HTABLE_OPT_ARENA) and dst can't be bounded (see htable_set_max_items),
+ *  otherwise false is returned.
+ *  The merge of per-thread tables: htable_merge(total, partial, add_counts) for each of them.
+ */
+bool htable_merge(htable_t *dst, htable_t *src, item_combine_t combine);
+
 /**
  *  Find and return item
  *
@@ -104,6 +253,27 @@ bool htable_remove(htable_t *ht, const htable_item_base_t *item);
  */
 bool htable_find(htable_t *ht, const htable_item_base_t *item, htable_item_base_t **out_item);
 
+/**
+ *  Find many items at once
+ *
+ *  \param [in] ht - The instance of hash table
+ *
+ *  \param [in] items - The array of pointers to htable_item_base_t structures (or compatible)
+ *
+ *  \param [in] count - The number of items
+ *
+ *  \param [out] out_items - The array where pointers to found items (or NULL) are returned
+ *
+ *  \return It returns the number of found items.
+ *
+ *  \details Keys are processed in batches: all keys of a batch are hashed and their slots are
+ *  prefetched first, then items in home slots are prefetched, and only then the keys are probed.
+ *  So cache misses of independent lookups overlap instead of going one by one. It's the same as
+ *  htable_find called for every item, but faster for big tables. NULL items are not found.
+ */
+size_t htable_find_batch(htable_t *ht, const htable_item_base_t * const *items, size_t count,
+                         htable_item_base_t **out_items);
+
 /**
  * Enumerate keys of hash table
  *
@@ -111,11 +281,28 @@ bool htable_find(htable_t *ht, const htable_item_base_t *item, htable_item_base_
  *
  * \param [in] callback - The pointer to function that will be called for each item in hash table
  *
+ * \return It returns false if enumeration was stopped by callback, true otherwise.
+ *
  * \details The callback function can return zero to stop enumeration.
  * In other cases it has to return non-zero value.
  * Fields key, key_len of out_item structure must not be changed!!
  */
-void htable_enumerate_items(htable_t *ht, int (*callback)(htable_item_base_t *item));
+bool htable_enumerate_items(htable_t *ht, int (*callback)(htable_item_base_t *item));
+
+/**
+ * Enumerate keys of hash table passing context to callback
+ *
+ * \param [in] ht - The instance of hash table
+ *
+ * \param [in] callback - The pointer to function that will be called for each item in hash table
+ *
+ * \param [in] ctx - The pointer passed to callback
+ *
+ * \return It returns false if enumeration was stopped by callback, true otherwise.
+ *
+ * \details See htable_enumerate_items.
+ */
+bool htable_enumerate_items_ex(htable_t *ht, int (*callback)(htable_item_base_t *item, void *ctx), void *ctx);
 
 /**
  *  Set your own function that will be called when htable needs to delete item.
@@ -129,10 +316,133 @@ void htable_enumerate_items(htable_t *ht, int (*callback)(htable_item_base_t *it
  *  \details The function can be called from htable_set, htable_remove, htable_destroy functions.
  *  You have to take care of releasing resources associated with item correctly and the item as well.
  *  By default the hash table just releases key buffer of item and releases item itself.
+ *  The key buffer must not be released if HTABLE_ITEM_INLINE_KEY flag is set for item.
+ *  Neither item nor key must be released if HTABLE_ITEM_ARENA flag is set for item,
+ *  the destructor has to release associated resources only.
  *  Set item_destructor parameter to NULL to get back default item destructor
+ *  (it releases items with allocator of table, see htable_make_alloc).
  */
 item_destructor_t htable_set_item_destructor(htable_t *ht, item_destructor_t new_item_destructor);
 
+/**
+ *  Set maximum length of keys that are stored inline
+ *
+ *  \param [in] ht - The instance of hash table
+ *
+ *  \param [in] inline_key_max - Keys with length up to this value will be stored inline
+ *
+ *  \returns This function returns value set by previous call
+ *
+ *  \details Inline key is stored in the same allocation as the item (right after item_size bytes),
+ *  so htable_set makes one allocation per item instead of two. Such items have HTABLE_ITEM_INLINE_KEY flag.
+ *  Set inline_key_max parameter to 0 to disable inline keys (default).
+ *  It can be changed at any time, items already stored keep their layout.
+ */
+size_t htable_set_inline_key_max(htable_t *ht, size_t inline_key_max);
+
+/**
+ *  Limit the number of items (cache mode)
+ *
+ *  \param [in] ht - The instance of hash table
+ *
+ *  \param [in] max_items - The maximum number of items, 0 - unbounded table (default)
+ *
+ *  \return It returns true if the limit was set or false if ht is NULL or the table uses arena.
+ *
+ *  \details When a new key is inserted into the full table an item is evicted by CLOCK algorithm:
+ *  lookups mark found items as referenced (HTABLE_ITEM_REFERENCED), the eviction hand walks over slots
+ *  clearing the marks and evicts the first item without the mark. New items aren't marked, so keys seen
+ *  once leave the table before keys found again. Evicted items are released with item destructor.
+ *  Slot array grows until it has room for 1.5 * max_items, then deleted marks are cleaned up instead,
+ *  so memory stays flat for any number of distinct keys. The limit can be changed at any time,
+ *  extra items are evicted at once (slot array isn't shrunk). Arena tables can't be bounded:
+ *  memory of evicted items would return to the arena only by htable_destroy.
+ *  Hits, misses (htable_find, htable_find_batch, htable_upsert) and evictions are counted, see htable_stats.
+ */
+bool htable_set_max_items(htable_t *ht, size_t max_items);
+
+/**
+ *  Compute hash of key with hash function of the hash table
+ *
+ *  \param [in] ht - The instance of hash table
+ *
+ *  \param [in] key - Pointer to a buffer with key
+ *
+ *  \param [in] key_len - Length of key's buffer
+ *
+ *  \return It returns the same hash value as hash table computes for the key (0 if ht or key is NULL).
+ */
+uint32_t htable_hash(const htable_t *ht, const uint8_t *key, size_t key_len);
+
+/**
+ *  Make a random seed
+ *
+ *  \return It returns the seed HTABLE_OPT_RANDOM_SEED would set, it differs between calls and runs.
+ *
+ *  \details Use it to give the same random seed to tables which must hash keys in the same way.
+ */
+uint64_t htable_random_seed(void);
+
+/**
+ *  Same as htable_set, htable_upsert, htable_find, htable_remove, but the hash of key is passed by caller
+ *
+ *  \param [in] hash - The hash of item's key, it must be equal to htable_hash(ht, item->key, item->key_len)
+ *
+ *  \details These functions let a caller which already hashed the key (e.g. to select a table) not to hash
+ *  it again. Other parameters and return values are the same as of functions without _hashed suffix.
+ */
+void htable_set_hashed(htable_t *ht, const htable_item_base_t *item, size_t item_size, uint32_t hash);
+
+htable_item_base_t *htable_upsert_hashed(htable_t *ht, const htable_item_base_t *item, size_t item_size,
+                                         uint32_t hash, bool *inserted);
+
+bool htable_find_hashed(htable_t *ht, const htable_item_base_t *item, uint32_t hash, htable_item_base_t **out_item);
+
+bool htable_remove_hashed(htable_t *ht, const htable_item_base_t *item, uint32_t hash);
+
+#define HTABLE_PROBE_HISTOGRAM_SIZE 16  // Probe lengths 1..15, the last bucket counts longer probes
+
+typedef struct
+{
+    size_t items_count;
+    size_t capacity;            // Number of slots
+    size_t deleted_count;       // Slots marked as deleted (tombstones), probing goes through them
+    double load_factor;         // items_count / capacity
+    size_t resize_count;        // Rebuilds of slot array: growth or cleanup of deleted marks (*)
+    uint64_t resize_ns;         // Total time of rebuilds (*)
+    uint64_t find_probes[HTABLE_PROBE_HISTOGRAM_SIZE];    // Probe lengths of lookups, misses to empty slot (*)
+    uint64_t insert_probes[HTABLE_PROBE_HISTOGRAM_SIZE];  // Probe lengths of inserted items (*)
+    uint64_t hits;              // Lookups that found the key (**)
+    uint64_t misses;            // Lookups that didn't find the key (**)
+    uint64_t evictions;         // Items evicted to keep the limit (**)
+    uint64_t bloom_rejects;     // Lookups answered by Bloom filter (HTABLE_OPT_BLOOM) (*)
+    double mean_probes;         // Mean probe length of stored items (1 - item is in its home slot)
+    size_t max_probes;          // The longest probe length of stored items
+    double hash_dispersion;     // Variance to mean ratio of items per home slot
+} htable_stats_t;
+
+/**
+ *  Get statistics of the hash table
+ *
+ *  \param [in] ht - The instance of hash table
+ *
+ *  \param [out] stats - The pointer where statistics are returned
+ *
+ *  \return It returns true if statistics were collected or false if error happened.
+ *
+ *  \details Fields marked with (*) are counted only if the table was made with HTABLE_OPT_STATS,
+ *  they are zero otherwise. Fields marked with (**) are counted only while the number of items is limited
+ *  (see htable_set_max_items). Probe length is the number of slots (groups for Swiss layout) from
+ *  the home slot of key up to the slot where probing found the key or where a missing key would be
+ *  inserted. Histograms are counted by htable_find, htable_find_batch (lookups) and by htable_set,
+ *  htable_upsert when they insert a new key.
+ *  Other fields are computed by the call from stored hashes: it walks the whole slot array and
+ *  allocates a counter per home slot, so it takes O(capacity) time. hash_dispersion is about 1 for
+ *  hash function spreading keys uniformly, much bigger values mean that keys cluster in few home slots
+ *  (e.g. hash function ignores a part of key). Incremental rehashing is finished by this call.
+ */
+bool htable_stats(htable_t *ht, htable_stats_t *stats);
+
 typedef enum
 {
     HTABLE_OK,
@@ -0,0 +1,1520 @@
+/**
+ * Hash table benchmarks (make bench8).
+ *
+ * Every output line is a record: its type followed by key=value fields, so results can be
+ * compared with grep/awk or loaded as a table. Times are nanoseconds per operation (_ns) unless
+ * the field says otherwise. Records: table (layouts at load factors), sharded, readers, snapshot,
+ * stats, merge (combining per-thread tables), bloom (miss-heavy lookups), pages (huge pages and NUMA
+ * placement), words (hash functions), gen (generated table), cache (bounded table), intern (string
+ * interner) and sweep (table sizes, key sizes, hash functions, compact table and sorted array baseline).
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "htable.h"
+#include "htable_sharded.h"
+#include "htable_lf.h"
+#include "htable_snapshot.h"
+#include "htable_compact.h"
+#include "htable_u64.h"
+#include "htable_mmap.h"
+#include "htable_intern.h"
+#include "htable_gen.h"
+#include "htable_hash.h"
+
+#define KEY_LEN 12
+#define BATCH_LEN 256
+
+struct item
+{
+    htable_item_base_t base;
+    size_t val;
+};
+
+struct layout
+{
+    const char *name;
+    uint32_t flags;
+    double max_load;   // The table grows above this load factor
+};
+
+static const struct layout layouts[] = {
+    {"linear", HTABLE_OPT_ARENA, 0.5},
+    {"swiss", HTABLE_OPT_ARENA | HTABLE_OPT_SWISS, 0.875},
+    {"robin_hood", HTABLE_OPT_ARENA | HTABLE_OPT_ROBIN_HOOD, 0.5},
+    {"incremental", HTABLE_OPT_ARENA | HTABLE_OPT_INCREMENTAL, 0.5},
+    {"dense", HTABLE_OPT_ARENA | HTABLE_OPT_DENSE, 0.5},
+};
+
+// Baseline of sweep: htable_t with default options allocates every item and its key
+static const struct layout malloc_layout = {"linear_malloc", 0, 0.5};
+
+static const double loads[] = {0.25, 0.45, 0.6, 0.75, 0.85};
+
+struct hash
+{
+    const char *name;
+    uint32_t hash;
+};
+
+static const struct hash hashes[] = {
+    {"jenkins", HTABLE_HASH_JENKINS},
+    {"word", HTABLE_HASH_WORD},
+    {"crc32c", HTABLE_HASH_CRC32C},
+};
+
+#define WORDS_COUNT 1000000
+#define LONG_KEY_LEN 64
+
+struct word
+{
+    const uint8_t *p;
+    size_t len;
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Keys [0, count) are inserted, keys [count, 2 * count) are used for misses and churn.
+ */
+static uint8_t *make_keys(size_t count)
+{
+    uint8_t *keys = malloc(count * KEY_LEN + 1);
+    if (!keys)
+        return NULL;
+    for (size_t i = 0; i < count; i++)
+        snprintf((char*)keys + i * KEY_LEN, KEY_LEN + 1, "key-%08x", (unsigned)(uint32_t)(i * 2654435761u));
+    return keys;
+}
+
+static int sum_values(htable_item_base_t *item, void *ctx)
+{
+    *(size_t*)ctx += ((struct item*)item)->val;
+    return 1;
+}
+
+/**
+ * Fill table growing from the minimal size, returns the longest htable_set call in seconds.
+ */
+static double grow_max_latency(const struct layout *layout, size_t count, const uint8_t *keys)
+{
+    htable_options_t options = {0, NULL, layout->flags, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    if (!ht)
+        return -1;
+
+    struct item item = {0};
+    item.base.key_len = KEY_LEN;
+    double max_latency = 0, start, latency;
+    for (size_t i = 0; i < count; i++)
+    {
+        item.base.key = (uint8_t*)keys + i * KEY_LEN;
+        start = now();
+        htable_set(ht, (htable_item_base_t*)&item, sizeof(item));
+        latency = now() - start;
+        if (latency > max_latency)
+            max_latency = latency;
+    }
+
+    if (htable_status(ht) != HTABLE_OK)
+        max_latency = -1;
+    htable_destroy(ht);
+    return max_latency;
+}
+
+static bool run_case(const struct layout *layout, size_t capacity, double load, const uint8_t *keys)
+{
+    size_t count = (size_t)(capacity * load);
+    htable_options_t options = {capacity, NULL, layout->flags, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    if (!ht)
+    {
+        perror("Can't create hash table");
+        return false;
+    }
+
+    struct item item = {0};
+    item.base.key_len = KEY_LEN;
+
+    double start = now();
+    for (size_t i = 0; i < count; i++)
+    {
+        item.base.key = (uint8_t*)keys + i * KEY_LEN;
+        item.val = i;
+        htable_set(ht, (htable_item_base_t*)&item, sizeof(item));
+    }
+    double insert_time = now() - start;
+
+    size_t found = 0;
+    start = now();
+    for (size_t i = 0; i < count; i++)
+    {
+        item.base.key = (uint8_t*)keys + i * KEY_LEN;
+        found += htable_find(ht, (htable_item_base_t*)&item, NULL);
+    }
+    double hit_time = now() - start;
+
+    // The same lookups by batches (join-style workload)
+    struct item batch_items[BATCH_LEN];
+    const htable_item_base_t *batch[BATCH_LEN];
+    htable_item_base_t *batch_out[BATCH_LEN];
+    size_t batch_found = 0;
+    for (size_t j = 0; j < BATCH_LEN; j++)
+    {
+        batch_items[j].base.key_len = KEY_LEN;
+        batch[j] = (htable_item_base_t*)&batch_items[j];
+    }
+    start = now();
+    for (size_t i = 0; i < count; i += BATCH_LEN)
+    {
+        size_t len = (count - i < BATCH_LEN) ? count - i : BATCH_LEN;
+        for (size_t j = 0; j < len; j++)
+            batch_items[j].base.key = (uint8_t*)keys + (i + j) * KEY_LEN;
+        batch_found += htable_find_batch(ht, batch, len, batch_out);
+    }
+    double batch_hit_time = now() - start;
+
+    start = now();
+    for (size_t i = count; i < 2 * count; i++)
+    {
+        item.base.key = (uint8_t*)keys + i * KEY_LEN;
+        found += htable_find(ht, (htable_item_base_t*)&item, NULL);
+    }
+    double miss_time = now() - start;
+
+    // Churn: remove the oldest key and insert a new one, the number of items stays the same
+    start = now();
+    for (size_t i = 0; i < count; i++)
+    {
+        item.base.key = (uint8_t*)keys + i * KEY_LEN;
+        htable_remove(ht, (htable_item_base_t*)&item);
+        item.base.key = (uint8_t*)keys + (count + i) * KEY_LEN;
+        item.val = i;
+        htable_set(ht, (htable_item_base_t*)&item, sizeof(item));
+    }
+    double churn_time = now() - start;
+
+    // Enumeration after churn, when slot array has many deleted marks
+    size_t sum = 0;
+    start = now();
+    htable_enumerate_items_ex(ht, sum_values, &sum);
+    double enum_time = now() - start;
+
+    bool ok = htable_status(ht) == HTABLE_OK && found == count && batch_found == count &&
+              sum == count * (count - 1) / 2;
+    htable_destroy(ht);
+    double grow_max = grow_max_latency(layout, count, keys);
+    ok = ok && grow_max >= 0;
+    if (!ok)
+    {
+        fprintf(stderr, "Hash table error: layout=%s load=%.2f\n", layout->name, load);
+        return false;
+    }
+
+    printf("table layout=%s capacity=%zu load=%.2f items=%zu insert_ns=%.1f hit_ns=%.1f batch_hit_ns=%.1f miss_ns=%.1f "
+           "churn_ns=%.1f enum_ns=%.1f grow_max_us=%.1f\n",
+           layout->name, capacity, load, count,
+           insert_time * 1e9 / count, hit_time * 1e9 / count, batch_hit_time * 1e9 / count,
+           miss_time * 1e9 / count, churn_time * 1e9 / count, enum_time * 1e9 / count, grow_max * 1e6);
+    return true;
+}
+
+/**
+ * Words like homework8 input (see test.py): a letter repeated 1..14 times.
+ */
+static struct word *make_words(size_t count, uint8_t *buffer)
+{
+    static const char symbols[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    struct word *words = malloc(count * sizeof(struct word));
+    if (!words)
+        return NULL;
+
+    srand(8);
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t len = 1 + rand() % 14;
+        memset(buffer, symbols[rand() % (sizeof(symbols) - 1)], len);
+        words[i].p = buffer;
+        words[i].len = len;
+        buffer += len;
+    }
+    return words;
+}
+
+/**
+ * Count words like homework8 does (one htable_upsert per word), then find every word once more.
+ */
+static bool run_hash_case(const struct hash *hash, const char *keys_name, const struct word *words, size_t count)
+{
+    htable_options_t options = {512, NULL, HTABLE_OPT_ARENA | HTABLE_OPT_RANDOM_SEED, hash->hash, 0};
+    htable_t *ht = htable_make_ex(&options);
+    if (!ht)
+    {
+        perror("Can't create hash table");
+        return false;
+    }
+
+    struct item item = {0}, *counter;
+    bool ok = true;
+    double start = now();
+    for (size_t i = 0; ok && i < count; i++)
+    {
+        item.base.key = (uint8_t*)words[i].p;
+        item.base.key_len = words[i].len;
+        counter = (struct item*)htable_upsert(ht, (htable_item_base_t*)&item, sizeof(item), NULL);
+        ok = counter != NULL;
+        if (ok)
+            counter->val++;
+    }
+    double count_time = now() - start;
+
+    size_t found = 0;
+    start = now();
+    for (size_t i = 0; i < count; i++)
+    {
+        item.base.key = (uint8_t*)words[i].p;
+        item.base.key_len = words[i].len;
+        found += htable_find(ht, (htable_item_base_t*)&item, NULL);
+    }
+    double hit_time = now() - start;
+
+    ok = ok && htable_status(ht) == HTABLE_OK && found == count;
+    htable_destroy(ht);
+    if (!ok)
+    {
+        fprintf(stderr, "Hash table error: hash=%s keys=%s\n", hash->name, keys_name);
+        return false;
+    }
+
+    printf("words hash=%s keys=%s count=%zu upsert_ns=%.1f hit_ns=%.1f\n",
+           hash->name, keys_name, count, count_time * 1e9 / count, hit_time * 1e9 / count);
+    return true;
+}
+
+/// --------------------- GENERATED HASH TABLE --------------------
+
+static inline uint32_t hash_word(struct word word)
+{
+    return htable_word_hash(word.p, word.len, 0);
+}
+
+static inline bool equal_words(struct word word1, struct word word2)
+{
+    return word1.len == word2.len && 0 == memcmp(word1.p, word2.p, word1.len);
+}
+
+HTABLE_GEN(counter, struct word, size_t, hash_word, equal_words)
+
+/**
+ * Count words with generic API (layout of homework8) and find every word once more.
+ */
+static bool run_generic_counter(const struct word *words, size_t count, double *count_time, double *hit_time)
+{
+    htable_options_t options = {512, NULL, HTABLE_OPT_ARENA | HTABLE_OPT_DENSE, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    struct item item = {0}, *counter;
+    bool ok = ht != NULL;
+
+    double start = now();
+    for (size_t i = 0; ok && i < count; i++)
+    {
+        item.base.key = (uint8_t*)words[i].p;
+        item.base.key_len = words[i].len;
+        counter = (struct item*)htable_upsert(ht, (htable_item_base_t*)&item, sizeof(item), NULL);
+        ok = counter != NULL;
+        if (ok)
+            counter->val++;
+    }
+    *count_time = now() - start;
+
+    size_t found = 0;
+    start = now();
+    for (size_t i = 0; ok && i < count; i++)
+    {
+        item.base.key = (uint8_t*)words[i].p;
+        item.base.key_len = words[i].len;
+        found += htable_find(ht, (htable_item_base_t*)&item, NULL);
+    }
+    *hit_time = now() - start;
+
+    htable_destroy(ht);
+    return ok && found == count;
+}
+
+/**
+ * The same with hash table generated for word keys.
+ */
+static bool run_generated_counter(const struct word *words, size_t count, double *count_time, double *hit_time)
+{
+    counter_t *ht = counter_make(512);
+    counter_entry_t *entry;
+    bool ok = ht != NULL;
+
+    double start = now();
+    for (size_t i = 0; ok && i < count; i++)
+    {
+        entry = counter_upsert(ht, words[i], NULL);
+        ok = entry != NULL;
+        if (ok)
+            entry->val++;
+    }
+    *count_time = now() - start;
+
+    size_t found = 0;
+    start = now();
+    for (size_t i = 0; ok && i < count; i++)
+        found += counter_find(ht, words[i]) != NULL;
+    *hit_time = now() - start;
+
+    counter_destroy(ht);
+    return ok && found == count;
+}
+
+static bool run_gen_case(const char *keys_name, const struct word *words, size_t count)
+{
+    double count_time, hit_time;
+    for (int generated = 0; generated < 2; generated++)
+    {
+        bool ok = (generated) ? run_generated_counter(words, count, &count_time, &hit_time)
+                              : run_generic_counter(words, count, &count_time, &hit_time);
+        if (!ok)
+        {
+            fprintf(stderr, "Hash table error: generated=%d keys=%s\n", generated, keys_name);
+            return false;
+        }
+        printf("gen table=%s keys=%s count=%zu upsert_ns=%.1f hit_ns=%.1f\n", (generated) ? "generated" : "generic",
+               keys_name, count, count_time * 1e9 / count, hit_time * 1e9 / count);
+    }
+    return true;
+}
+
+static bool run_hash_cases(size_t capacity)
+{
+    uint8_t *buffer = malloc(WORDS_COUNT * 14);
+    struct word *words = buffer ? make_words(WORDS_COUNT, buffer) : NULL;
+    uint8_t *long_keys = malloc(capacity * LONG_KEY_LEN);
+    struct word *long_words = malloc(capacity * sizeof(struct word));
+    bool ok = words && long_keys && long_words;
+
+    for (size_t i = 0; ok && i < capacity; i++)
+    {
+        memset(long_keys + i * LONG_KEY_LEN, 'k', LONG_KEY_LEN);
+        snprintf((char*)long_keys + i * LONG_KEY_LEN, LONG_KEY_LEN, "%08zx", i);
+        long_words[i].p = long_keys + i * LONG_KEY_LEN;
+        long_words[i].len = LONG_KEY_LEN;
+    }
+
+    for (size_t h = 0; ok && h < sizeof(hashes) / sizeof(hashes[0]); h++)
+    {
+        ok = run_hash_case(&hashes[h], "words", words, WORDS_COUNT) &&
+             run_hash_case(&hashes[h], "long", long_words, capacity);
+    }
+    ok = ok && run_gen_case("words", words, WORDS_COUNT) && run_gen_case("long", long_words, capacity);
+
+    if (!words || !long_keys || !long_words)
+        perror("Can't allocate keys");
+    free(long_words);
+    free(long_keys);
+    free(words);
+    free(buffer);
+    return ok;
+}
+
+/// --------------------- SHARDED HASH TABLE --------------------
+
+#define THREADS_MAX 16
+
+struct worker
+{
+    pthread_t thread;
+    htable_sharded_t *sht;
+    const uint8_t *keys;
+    size_t keys_count;
+    size_t first;
+    size_t count;
+    bool mixed;
+};
+
+static void increment(htable_item_base_t *item, __attribute__((unused)) bool inserted,
+                      __attribute__((unused)) void *ctx)
+{
+    ((struct item*)item)->val++;
+}
+
+/**
+ * Insert workload: every thread inserts its own keys.
+ * Mixed workload: 50% upserts, 40% finds, 10% removes over all keys.
+ */
+static void *run_worker(void *arg)
+{
+    struct worker *w = arg;
+    struct item item = {0};
+    item.base.key_len = KEY_LEN;
+
+    for (size_t i = 0; i < w->count; i++)
+    {
+        size_t k = w->mixed ? (size_t)((w->first + i) * 2654435761u) % w->keys_count : w->first + i;
+        item.base.key = (uint8_t*)w->keys + k * KEY_LEN;
+        if (!w->mixed || i % 10 < 5)
+            htable_sharded_upsert(w->sht, (htable_item_base_t*)&item, sizeof(item), increment, NULL);
+        else if (i % 10 < 9)
+            htable_sharded_find(w->sht, (htable_item_base_t*)&item, NULL);
+        else
+            htable_sharded_remove(w->sht, (htable_item_base_t*)&item);
+    }
+    return NULL;
+}
+
+static bool run_sharded_case(size_t shards, size_t threads, bool mixed, size_t count, const uint8_t *keys)
+{
+    htable_options_t options = {0, NULL, HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    htable_sharded_t *sht = htable_sharded_make(shards, sizeof(struct item), &options);
+    if (!sht)
+    {
+        perror("Can't create hash table");
+        return false;
+    }
+
+    struct worker workers[THREADS_MAX];
+    size_t started = 0;
+    double start = now();
+    for (; started < threads; started++)
+    {
+        workers[started] = (struct worker){0, sht, keys, count, started * (count / threads), count / threads, mixed};
+        if (pthread_create(&workers[started].thread, NULL, run_worker, &workers[started]))
+            break;
+    }
+    for (size_t i = 0; i < started; i++)
+        pthread_join(workers[i].thread, NULL);
+    double elapsed = now() - start;
+    htable_sharded_destroy(sht);
+
+    if (started != threads)
+    {
+        perror("Can't start thread");
+        return false;
+    }
+
+    size_t ops = threads * (count / threads);
+    printf("sharded workload=%s shards=%zu threads=%zu ops=%zu mops=%.2f\n",
+           mixed ? "mixed" : "insert", shards, threads, ops, ops / elapsed * 1e-6);
+    return true;
+}
+
+static bool run_sharded_cases(size_t count, const uint8_t *keys)
+{
+    const size_t shards[] = {1, 64};
+    bool ok = true;
+    for (int mixed = 0; ok && mixed < 2; mixed++)
+        for (size_t s = 0; ok && s < sizeof(shards) / sizeof(shards[0]); s++)
+            for (size_t threads = 1; ok && threads <= THREADS_MAX; threads <<= 1)
+                ok = run_sharded_case(shards[s], threads, mixed, count, keys);
+    return ok;
+}
+
+/// --------------------- LOCK-FREE READERS --------------------
+
+struct reader
+{
+    pthread_t thread;
+    htable_sharded_t *sht;
+    htable_lf_t *lf;
+    const uint8_t *keys;
+    size_t count;
+    size_t found;
+};
+
+static void *run_reader(void *arg)
+{
+    struct reader *r = arg;
+    htable_lf_reader_t *lf_reader = r->lf ? htable_lf_reader_register(r->lf) : NULL;
+    struct item item = {0};
+    item.base.key_len = KEY_LEN;
+
+    for (size_t i = 0; i < r->count; i++)
+    {
+        item.base.key = (uint8_t*)r->keys + (size_t)(i * 2654435761u) % r->count * KEY_LEN;
+        if (lf_reader)
+        {
+            htable_lf_read_lock(lf_reader);
+            r->found += htable_lf_find(r->lf, (htable_item_base_t*)&item, NULL);
+            htable_lf_read_unlock(lf_reader);
+        }
+        else
+        {
+            r->found += htable_sharded_find(r->sht, (htable_item_base_t*)&item, NULL);
+        }
+    }
+    htable_lf_reader_unregister(lf_reader);
+    return NULL;
+}
+
+/**
+ * Read-only workload: every thread finds all keys.
+ */
+static bool run_readers_case(bool lock_free, size_t threads, size_t count, const uint8_t *keys)
+{
+    htable_options_t options = {count, NULL, lock_free ? 0 : HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    htable_sharded_t *sht = lock_free ? NULL : htable_sharded_make(64, sizeof(struct item), &options);
+    htable_lf_t *lf = lock_free ? htable_lf_make(&options) : NULL;
+    if (!sht && !lf)
+    {
+        perror("Can't create hash table");
+        return false;
+    }
+
+    struct item item = {0};
+    item.base.key_len = KEY_LEN;
+    for (size_t i = 0; i < count; i++)
+    {
+        item.base.key = (uint8_t*)keys + i * KEY_LEN;
+        if (lf)
+            htable_lf_set(lf, (htable_item_base_t*)&item, sizeof(item));
+        else
+            htable_sharded_set(sht, (htable_item_base_t*)&item, sizeof(item));
+    }
+
+    struct reader readers[THREADS_MAX];
+    size_t started = 0, found = 0;
+    double start = now();
+    for (; started < threads; started++)
+    {
+        readers[started] = (struct reader){0, sht, lf, keys, count, 0};
+        if (pthread_create(&readers[started].thread, NULL, run_reader, &readers[started]))
+            break;
+    }
+    for (size_t i = 0; i < started; i++)
+    {
+        pthread_join(readers[i].thread, NULL);
+        found += readers[i].found;
+    }
+    double elapsed = now() - start;
+    htable_sharded_destroy(sht);
+    htable_lf_destroy(lf);
+
+    if (started != threads || found != threads * count)
+    {
+        fprintf(stderr, "Readers error: lock_free=%d threads=%zu\n", lock_free, threads);
+        return false;
+    }
+
+    printf("readers table=%s threads=%zu ops=%zu mops=%.2f\n",
+           lock_free ? "lock_free" : "sharded_64", threads, threads * count, threads * count / elapsed * 1e-6);
+    return true;
+}
+
+static bool run_readers_cases(size_t count, const uint8_t *keys)
+{
+    bool ok = true;
+    for (int lock_free = 0; ok && lock_free < 2; lock_free++)
+        for (size_t threads = 1; ok && threads <= THREADS_MAX; threads <<= 1)
+            ok = run_readers_case(lock_free, threads, count, keys);
+    return ok;
+}
+
+/// --------------------- SNAPSHOT --------------------
+
+#define SNAPSHOT_PATH "htable_bench.snap"
+
+/**
+ * Build table from keys against save and open its snapshot, then find all keys in the snapshot.
+ */
+static bool run_snapshot_case(size_t count, const uint8_t *keys)
+{
+    htable_options_t options = {0, NULL, HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    struct item item = {0};
+    item.base.key_len = KEY_LEN;
+
+    double start = now();
+    htable_t *ht = htable_make_ex(&options);
+    for (size_t i = 0; ht && i < count; i++)
+    {
+        item.base.key = (uint8_t*)keys + i * KEY_LEN;
+        item.val = i;
+        htable_set(ht, (htable_item_base_t*)&item, sizeof(item));
+    }
+    double build = now() - start;
+
+    start = now();
+    bool ok = ht && htable_snapshot_save(ht, sizeof(item), SNAPSHOT_PATH);
+    double save = now() - start;
+    htable_destroy(ht);
+
+    start = now();
+    htable_snapshot_t *snap = ok ? htable_snapshot_open(SNAPSHOT_PATH) : NULL;
+    double open = now() - start;
+
+    size_t found = 0;
+    const size_t *val;
+    start = now();
+    for (size_t i = 0; snap && i < count; i++)
+    {
+        item.base.key = (uint8_t*)keys + (size_t)(i * 2654435761u) % count * KEY_LEN;
+        val = htable_snapshot_find(snap, (htable_item_base_t*)&item);
+        found += val && *val < count;
+    }
+    double find = now() - start;
+    htable_snapshot_close(snap);
+    remove(SNAPSHOT_PATH);
+
+    if (!snap || found != count)
+    {
+        perror("Snapshot error");
+        return false;
+    }
+
+    printf("snapshot items=%zu build_ms=%.2f save_ms=%.2f open_ms=%.3f find_ns=%.1f\n",
+           count, build * 1e3, save * 1e3, open * 1e3, find / count * 1e9);
+    return true;
+}
+
+/// --------------------- STATS --------------------
+
+/**
+ * Hash which low 4 bits are zero (like address of aligned object): only every 16th slot is home slot.
+ */
+static uint32_t clustering_hash(const uint8_t *key, size_t key_len)
+{
+    return htable_word_hash(key, key_len, 0) << 4;
+}
+
+/**
+ * Insert and find count keys in table growing from the minimal size, returns false on error.
+ */
+static bool fill_and_find(htable_t *ht, size_t count, const uint8_t *keys, double *insert_time, double *hit_time)
+{
+    struct item item = {0};
+    item.base.key_len = KEY_LEN;
+
+    double start = now();
+    for (size_t i = 0; i < count; i++)
+    {
+        item.base.key = (uint8_t*)keys + i * KEY_LEN;
+        htable_set(ht, (htable_item_base_t*)&item, sizeof(item));
+    }
+    *insert_time = now() - start;
+
+    size_t found = 0;
+    start = now();
+    for (size_t i = 0; i < count; i++)
+    {
+        item.base.key = (uint8_t*)keys + i * KEY_LEN;
+        found += htable_find(ht, (htable_item_base_t*)&item, NULL);
+    }
+    *hit_time = now() - start;
+    return htable_status(ht) == HTABLE_OK && found == count;
+}
+
+/**
+ * Cost of HTABLE_OPT_STATS counters and what htable_stats shows for good and clustering hash.
+ */
+static bool run_stats_case(const struct layout *layout, hash_func_t hash_func, size_t count, const uint8_t *keys)
+{
+    double insert_time[2], hit_time[2];
+    htable_stats_t stats;
+    bool ok = true;
+    for (int with_stats = 0; ok && with_stats < 2; with_stats++)
+    {
+        uint32_t flags = (with_stats) ? layout->flags | HTABLE_OPT_STATS : layout->flags;
+        htable_options_t options = {0, hash_func, flags, HTABLE_HASH_WORD, 0};
+        htable_t *ht = htable_make_ex(&options);
+        ok = ht && fill_and_find(ht, count, keys, &insert_time[with_stats], &hit_time[with_stats]) &&
+             htable_stats(ht, &stats);
+        htable_destroy(ht);
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "Hash table error: stats layout=%s\n", layout->name);
+        return false;
+    }
+
+    printf("stats layout=%s hash=%s items=%zu insert_ns=%.1f stats_insert_ns=%.1f hit_ns=%.1f stats_hit_ns=%.1f "
+           "resizes=%zu resize_ms=%.2f mean_probes=%.2f max_probes=%zu dispersion=%.2f find_probes=",
+           layout->name, (hash_func) ? "clustering" : "word", count,
+           insert_time[0] * 1e9 / count, insert_time[1] * 1e9 / count, hit_time[0] * 1e9 / count,
+           hit_time[1] * 1e9 / count, stats.resize_count, stats.resize_ns * 1e-6,
+           stats.mean_probes, stats.max_probes, stats.hash_dispersion);
+    for (size_t i = 0; i < HTABLE_PROBE_HISTOGRAM_SIZE; i++)
+        printf((i) ? ",%llu" : "%llu", (unsigned long long)stats.find_probes[i]);
+    printf("\n");
+    return true;
+}
+
+static bool run_stats_cases(size_t count, const uint8_t *keys)
+{
+    bool ok = true;
+    for (size_t l = 0; ok && l < sizeof(layouts) / sizeof(layouts[0]); l++)
+    {
+        ok = run_stats_case(&layouts[l], NULL, count, keys) &&
+             run_stats_case(&layouts[l], clustering_hash, count, keys);
+    }
+    return ok;
+}
+
+/// --------------------- MERGE --------------------
+
+#define MERGE_PARTS 4  // Per-thread tables, neighbour parts share half of their keys
+
+static void add_vals(htable_item_base_t *dst_item, const htable_item_base_t *src_item)
+{
+    ((struct item*)dst_item)->val += ((const struct item*)src_item)->val;
+}
+
+static int upsert_into(htable_item_base_t *item, void *ctx)
+{
+    bool inserted;
+    htable_item_base_t *total_item = htable_upsert(ctx, item, sizeof(struct item), &inserted);
+    if (!total_item)
+        return 0;
+    if (inserted)
+        ((struct item*)total_item)->val = 0;
+    add_vals(total_item, item);
+    return 1;
+}
+
+/**
+ * Parts of count keys are combined into the total table by enumeration with htable_upsert
+ * (keys are hashed and copied again) and by htable_merge. Only combining is timed.
+ */
+static bool run_merge_case(const struct layout *layout, size_t count, const uint8_t *keys)
+{
+    htable_options_t options = {0, NULL, layout->flags, HTABLE_HASH_WORD, 0};
+    htable_t *parts[MERGE_PARTS] = {NULL};
+    double times[2] = {0, 0};
+    size_t part_len = count / MERGE_PARTS, totals[2] = {0, 0}, distinct[2] = {0, 0};
+    struct item item = {0};
+    item.base.key_len = KEY_LEN;
+    item.val = 1;
+
+    bool ok = true;
+    for (int use_merge = 0; ok && use_merge < 2; use_merge++)
+    {
+        htable_t *total = htable_make_ex(&options);
+        ok = total != NULL;
+        for (size_t p = 0; ok && p < MERGE_PARTS; p++)
+        {
+            parts[p] = htable_make_ex(&options);
+            for (size_t i = 0; parts[p] && i < part_len; i++)
+            {
+                item.base.key = (uint8_t*)keys + (p * part_len / 2 + i) * KEY_LEN;
+                htable_set(parts[p], (htable_item_base_t*)&item, sizeof(item));
+            }
+            ok = parts[p] && htable_status(parts[p]) == HTABLE_OK;
+        }
+
+        double start = now();
+        for (size_t p = 0; ok && p < MERGE_PARTS; p++)
+        {
+            ok = (use_merge) ? htable_merge(total, parts[p], add_vals)
+                             : htable_enumerate_items_ex(parts[p], upsert_into, total);
+        }
+        times[use_merge] = now() - start;
+
+        htable_stats_t stats;
+        ok = ok && htable_stats(total, &stats) && htable_enumerate_items_ex(total, sum_values, &totals[use_merge]);
+        distinct[use_merge] = (ok) ? stats.items_count : 0;
+        for (size_t p = 0; p < MERGE_PARTS; p++)
+            htable_destroy(parts[p]);
+        htable_destroy(total);
+    }
+
+    if (!ok || totals[0] != part_len * MERGE_PARTS || totals[1] != totals[0] || distinct[1] != distinct[0])
+    {
+        fprintf(stderr, "Hash table error: merge layout=%s\n", layout->name);
+        return false;
+    }
+    printf("merge layout=%s parts=%d items=%zu distinct=%zu upsert_ns=%.1f merge_ns=%.1f\n", layout->name,
+           MERGE_PARTS, part_len * MERGE_PARTS, distinct[0], times[0] * 1e9 / (part_len * MERGE_PARTS),
+           times[1] * 1e9 / (part_len * MERGE_PARTS));
+    return true;
+}
+
+static bool run_merge_cases(size_t count, const uint8_t *keys)
+{
+    bool ok = true;
+    for (size_t l = 0; ok && l < sizeof(layouts) / sizeof(layouts[0]); l++)
+        ok = run_merge_case(&layouts[l], count, keys);
+    return ok;
+}
+
+/// --------------------- BLOOM --------------------
+
+#define BLOOM_MISS_PERCENT 90
+
+/**
+ * Lookups of count keys where BLOOM_MISS_PERCENT of them are absent, without and with HTABLE_OPT_BLOOM.
+ * False positive rate is the share of absent keys the filter let through to probing.
+ */
+static bool run_bloom_case(const struct layout *layout, size_t count, const uint8_t *keys)
+{
+    double times[2] = {0, 0};
+    size_t found[2] = {0, 0}, misses = 0;
+    htable_stats_t stats;
+    struct item item = {0};
+    item.base.key_len = KEY_LEN;
+
+    bool ok = true;
+    for (int with_bloom = 0; ok && with_bloom < 2; with_bloom++)
+    {
+        uint32_t flags = (with_bloom) ? layout->flags | HTABLE_OPT_BLOOM : layout->flags;
+        htable_options_t options = {0, NULL, flags | HTABLE_OPT_STATS, HTABLE_HASH_WORD, 0};
+        htable_t *ht = htable_make_ex(&options);
+        for (size_t i = 0; ht && i < count; i++)
+        {
+            item.base.key = (uint8_t*)keys + i * KEY_LEN;
+            htable_set(ht, (htable_item_base_t*)&item, sizeof(item));
+        }
+        ok = ht && htable_status(ht) == HTABLE_OK;
+
+        // Last 10 of every 100 lookups hit, absent keys are [count, 2 * count)
+        misses = 0;
+        double start = now();
+        for (size_t i = 0; ok && i < count; i++)
+        {
+            bool hit = i % 100 >= BLOOM_MISS_PERCENT;
+            item.base.key = (uint8_t*)keys + ((hit) ? i : count + i) * KEY_LEN;
+            found[with_bloom] += htable_find(ht, (htable_item_base_t*)&item, NULL);
+            misses += !hit;
+        }
+        times[with_bloom] = now() - start;
+        ok = ok && htable_stats(ht, &stats);
+        htable_destroy(ht);
+    }
+
+    if (!ok || found[0] != count - misses || found[1] != found[0])
+    {
+        fprintf(stderr, "Hash table error: bloom layout=%s\n", layout->name);
+        return false;
+    }
+    printf("bloom layout=%s items=%zu miss_percent=%d find_ns=%.1f bloom_find_ns=%.1f false_positive_rate=%.5f\n",
+           layout->name, count, BLOOM_MISS_PERCENT, times[0] * 1e9 / count, times[1] * 1e9 / count,
+           (double)(misses - stats.bloom_rejects) / misses);
+    return true;
+}
+
+static bool run_bloom_cases(size_t count, const uint8_t *keys)
+{
+    bool ok = true;
+    for (size_t l = 0; ok && l < sizeof(layouts) / sizeof(layouts[0]); l++)
+        ok = run_bloom_case(&layouts[l], count, keys);
+    return ok;
+}
+
+/// --------------------- PAGES --------------------
+
+struct pages_mode
+{
+    const char *name;
+    uint32_t pages;
+    uint32_t numa;
+    bool use_mmap;
+};
+
+static const struct pages_mode pages_modes[] = {
+    {"malloc", HTABLE_PAGES_REGULAR, HTABLE_NUMA_DEFAULT, false},
+    {"regular", HTABLE_PAGES_REGULAR, HTABLE_NUMA_DEFAULT, true},
+    {"thp", HTABLE_PAGES_THP, HTABLE_NUMA_DEFAULT, true},
+    {"hugetlb", HTABLE_PAGES_HUGETLB, HTABLE_NUMA_DEFAULT, true},
+    {"thp_interleave", HTABLE_PAGES_THP, HTABLE_NUMA_INTERLEAVE, true},
+};
+
+/**
+ * Hits in table of count keys with slot array and arena chunks mapped by htable_mmap allocator.
+ * Counters show which pages really backed the mappings (huge pages fall back quietly).
+ */
+static bool run_pages_case(const struct pages_mode *mode, size_t count, const uint8_t *keys)
+{
+    htable_mmap_t mm;
+    htable_allocator_t allocator = {htable_mmap_alloc, htable_mmap_free, &mm};
+    htable_options_t options = {0, NULL, HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    double insert_time, hit_time;
+
+    bool ok = htable_mmap_init(&mm, mode->pages, mode->numa, 0);
+    htable_t *ht = (mode->use_mmap) ? htable_make_alloc(&options, &allocator) : htable_make_ex(&options);
+    ok = ok && ht && fill_and_find(ht, count, keys, &insert_time, &hit_time);
+    htable_destroy(ht);
+    if (!ok)
+    {
+        fprintf(stderr, "Hash table error: pages mode=%s\n", mode->name);
+        return false;
+    }
+    printf("pages mode=%s items=%zu insert_ns=%.1f hit_ns=%.1f hugetlb_maps=%zu thp_maps=%zu regular_maps=%zu "
+           "numa_failures=%zu\n", mode->name, count, insert_time * 1e9 / count, hit_time * 1e9 / count,
+           mm.hugetlb_count, mm.thp_count, mm.regular_count, mm.numa_failures);
+    return true;
+}
+
+static bool run_pages_cases(size_t count, const uint8_t *keys)
+{
+    bool ok = true;
+    for (size_t m = 0; ok && m < sizeof(pages_modes) / sizeof(pages_modes[0]); m++)
+        ok = run_pages_case(&pages_modes[m], count, keys);
+    return ok;
+}
+
+/// --------------------- SWEEP --------------------
+
+#define SWEEP_MIN_ITEMS 1000
+#define SWEEP_MAX_ITEMS 100000000  // Sizes are 1k, 10k, ... up to max_items argument (1M by default)
+
+static const size_t key_lens[] = {8, 16, 64};
+
+/**
+ * Bytes allocated by malloc (0 if it's unknown).
+ */
+static size_t heap_used(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Keys of key_len bytes: hex digits of multiplicative hash of index padded with 'k' on the left.
+ * Keys [0, count) are inserted, keys [count, 2 * count) are used for misses and churn.
+ */
+static uint8_t *make_sized_keys(size_t count, size_t key_len)
+{
+    char digits[17];
+    uint8_t *keys = malloc(2 * count * key_len);
+    if (!keys)
+        return NULL;
+    for (size_t i = 0; i < 2 * count; i++)
+    {
+        uint64_t x = i * 0x9E3779B97F4A7C15ull;
+        size_t len = (key_len < 16) ? key_len : 16;
+        snprintf(digits, sizeof(digits), "%016llx", (unsigned long long)x);
+        memset(keys + i * key_len, 'k', key_len - len);
+        memcpy(keys + i * key_len + key_len - len, digits + 16 - len, len);
+    }
+    return keys;
+}
+
+struct sweep_result
+{
+    double insert_time, hit_time, miss_time, churn_time, remove_time;
+    size_t bytes;
+    double load;
+};
+
+static void print_sweep(const char *impl, const char *hash, size_t key_len, size_t count, const struct sweep_result *r)
+{
+    printf("sweep impl=%s hash=%s key_len=%zu items=%zu", impl, hash, key_len, count);
+    if (r->load >= 0)
+        printf(" load=%.2f", r->load);
+    printf(" bytes_per_item=%.1f insert_ns=%.1f hit_ns=%.1f miss_ns=%.1f", (double)r->bytes / count,
+           r->insert_time * 1e9 / count, r->hit_time * 1e9 / count, r->miss_time * 1e9 / count);
+    // Sorted array and compact table can't remove keys, churn and remove aren't measured for them
+    if (r->churn_time >= 0)
+        printf(" churn_ns=%.1f remove_ns=%.1f", r->churn_time * 1e9 / count, r->remove_time * 1e9 / count);
+    printf("\n");
+}
+
+/**
+ * Table grows from the minimal size while count keys are inserted. Memory per item is measured
+ * after inserts and includes slots, items and their copies of keys.
+ */
+static bool run_sweep_table(const struct layout *layout, const struct hash *hash, size_t key_len,
+                            size_t count, const uint8_t *keys)
+{
+    struct sweep_result r = {0};
+    htable_options_t options = {0, NULL, layout->flags, hash->hash, 0};
+    struct item item = {0};
+    item.base.key_len = key_len;
+
+    size_t heap = heap_used();
+    htable_t *ht = htable_make_ex(&options);
+    if (!ht)
+    {
+        perror("Can't create hash table");
+        return false;
+    }
+
+    double start = now();
+    for (size_t i = 0; i < count; i++)
+    {
+        item.base.key = (uint8_t*)keys + i * key_len;
+        item.val = i;
+        htable_set(ht, (htable_item_base_t*)&item, sizeof(item));
+    }
+    r.insert_time = now() - start;
+    r.bytes = heap_used() - heap;
+
+    size_t found = 0;
+    start = now();
+    for (size_t i = 0; i < count; i++)
+    {
+        item.base.key = (uint8_t*)keys + i * key_len;
+        found += htable_find(ht, (htable_item_base_t*)&item, NULL);
+    }
+    r.hit_time = now() - start;
+
+    start = now();
+    for (size_t i = count; i < 2 * count; i++)
+    {
+        item.base.key = (uint8_t*)keys + i * key_len;
+        found += htable_find(ht, (htable_item_base_t*)&item, NULL);
+    }
+    r.miss_time = now() - start;
+
+    htable_stats_t stats;
+    htable_stats(ht, &stats);
+    r.load = stats.load_factor;
+
+    start = now();
+    for (size_t i = 0; i < count; i++)
+    {
+        item.base.key = (uint8_t*)keys + i * key_len;
+        htable_remove(ht, (htable_item_base_t*)&item);
+        item.base.key = (uint8_t*)keys + (count + i) * key_len;
+        htable_set(ht, (htable_item_base_t*)&item, sizeof(item));
+    }
+    r.churn_time = now() - start;
+
+    size_t removed = 0;
+    start = now();
+    for (size_t i = count; i < 2 * count; i++)
+    {
+        item.base.key = (uint8_t*)keys + i * key_len;
+        removed += htable_remove(ht, (htable_item_base_t*)&item);
+    }
+    r.remove_time = now() - start;
+
+    bool ok = htable_status(ht) == HTABLE_OK && found == count && removed == count;
+    htable_destroy(ht);
+    if (!ok)
+    {
+        fprintf(stderr, "Hash table error: sweep layout=%s hash=%s\n", layout->name, hash->name);
+        return false;
+    }
+    print_sweep(layout->name, hash->name, key_len, count, &r);
+    return true;
+}
+
+struct sorted_entry
+{
+    const uint8_t *key;
+    size_t key_len;
+    size_t val;
+};
+
+static int compare_entries(const void *a, const void *b)
+{
+    const struct sorted_entry *e1 = a, *e2 = b;
+    size_t len = (e1->key_len < e2->key_len) ? e1->key_len : e2->key_len;
+    int result = memcmp(e1->key, e2->key, len);
+    if (result)
+        return result;
+    return (e1->key_len > e2->key_len) - (e1->key_len < e2->key_len);
+}
+
+/**
+ * Baseline: keys are copied to one buffer and sorted array of entries is searched by bsearch.
+ * Insert time is the time of building the array: copying keys and sorting.
+ */
+static bool run_sweep_sorted(size_t key_len, size_t count, const uint8_t *keys)
+{
+    struct sweep_result r = {0};
+    r.churn_time = r.remove_time = -1;
+    r.load = 1;
+
+    size_t heap = heap_used();
+    double start = now();
+    struct sorted_entry *entries = malloc(count * sizeof(struct sorted_entry));
+    uint8_t *pool = malloc(count * key_len);
+    if (!entries || !pool)
+    {
+        free(entries);
+        free(pool);
+        perror("Can't allocate sorted array");
+        return false;
+    }
+    memcpy(pool, keys, count * key_len);
+    for (size_t i = 0; i < count; i++)
+        entries[i] = (struct sorted_entry){pool + i * key_len, key_len, i};
+    qsort(entries, count, sizeof(struct sorted_entry), compare_entries);
+    r.insert_time = now() - start;
+    r.bytes = heap_used() - heap;
+
+    struct sorted_entry key = {NULL, key_len, 0};
+    size_t found = 0;
+    start = now();
+    for (size_t i = 0; i < count; i++)
+    {
+        key.key = keys + i * key_len;
+        found += bsearch(&key, entries, count, sizeof(struct sorted_entry), compare_entries) != NULL;
+    }
+    r.hit_time = now() - start;
+
+    start = now();
+    for (size_t i = count; i < 2 * count; i++)
+    {
+        key.key = keys + i * key_len;
+        found += bsearch(&key, entries, count, sizeof(struct sorted_entry), compare_entries) != NULL;
+    }
+    r.miss_time = now() - start;
+
+    free(entries);
+    free(pool);
+    if (found != count)
+    {
+        fprintf(stderr, "Sorted array error\n");
+        return false;
+    }
+    print_sweep("sorted_array", "none", key_len, count, &r);
+    return true;
+}
+
+/**
+ * Compact table: keys with values appended to one pool, slots are 32-bit offsets.
+ */
+static bool run_sweep_compact(size_t key_len, size_t count, const uint8_t *keys)
+{
+    struct sweep_result r = {0};
+    r.churn_time = r.remove_time = r.load = -1;
+
+    size_t heap = heap_used();
+    htable_compact_t *ht = htable_compact_make(0, sizeof(size_t), 0);
+    if (!ht)
+    {
+        perror("Can't create compact hash table");
+        return false;
+    }
+
+    size_t *val;
+    bool ok = true;
+    double start = now();
+    for (size_t i = 0; ok && i < count; i++)
+    {
+        val = htable_compact_upsert(ht, keys + i * key_len, key_len, NULL);
+        ok = val != NULL;
+        if (ok)
+            *val = i;
+    }
+    r.insert_time = now() - start;
+    r.bytes = heap_used() - heap;
+
+    size_t found = 0;
+    start = now();
+    for (size_t i = 0; i < count; i++)
+        found += htable_compact_find(ht, keys + i * key_len, key_len) != NULL;
+    r.hit_time = now() - start;
+
+    start = now();
+    for (size_t i = count; i < 2 * count; i++)
+        found += htable_compact_find(ht, keys + i * key_len, key_len) != NULL;
+    r.miss_time = now() - start;
+
+    htable_compact_destroy(ht);
+    if (!ok || found != count)
+    {
+        fprintf(stderr, "Compact hash table error\n");
+        return false;
+    }
+    print_sweep("compact", "word", key_len, count, &r);
+    return true;
+}
+
+/**
+ * Integer-key table: 8-byte keys are loaded as 64-bit integers and kept inline in slots.
+ */
+static bool run_sweep_u64(size_t count, const uint8_t *keys)
+{
+    struct sweep_result r = {0};
+    r.load = -1;
+
+    size_t heap = heap_used();
+    htable_u64_t *ht = htable_u64_make(0, 0);
+    if (!ht)
+    {
+        perror("Can't create u64 hash table");
+        return false;
+    }
+
+    uint64_t *val;
+    bool ok = true;
+    double start = now();
+    for (size_t i = 0; ok && i < count; i++)
+    {
+        val = htable_u64_upsert(ht, htable_load_word(keys + i * 8), NULL);
+        ok = val != NULL;
+        if (ok)
+            *val = i;
+    }
+    r.insert_time = now() - start;
+    r.bytes = heap_used() - heap;
+
+    size_t found = 0;
+    start = now();
+    for (size_t i = 0; i < count; i++)
+        found += htable_u64_find(ht, htable_load_word(keys + i * 8)) != NULL;
+    r.hit_time = now() - start;
+
+    start = now();
+    for (size_t i = count; i < 2 * count; i++)
+        found += htable_u64_find(ht, htable_load_word(keys + i * 8)) != NULL;
+    r.miss_time = now() - start;
+
+    start = now();
+    for (size_t i = 0; ok && i < count; i++)
+    {
+        htable_u64_remove(ht, htable_load_word(keys + i * 8));
+        ok = htable_u64_upsert(ht, htable_load_word(keys + (count + i) * 8), NULL) != NULL;
+    }
+    r.churn_time = now() - start;
+
+    size_t removed = 0;
+    start = now();
+    for (size_t i = count; i < 2 * count; i++)
+        removed += htable_u64_remove(ht, htable_load_word(keys + i * 8));
+    r.remove_time = now() - start;
+
+    htable_u64_destroy(ht);
+    if (!ok || found != count || removed != count)
+    {
+        fprintf(stderr, "U64 hash table error\n");
+        return false;
+    }
+    print_sweep("u64", "multiply_shift", 8, count, &r);
+    return true;
+}
+
+/**
+ * Every table size and key size: all layouts with the default hash function,
+ * all hash functions with linear layout, linear layout without arena, compact table, integer-key table (8-byte keys)
+ * and the sorted array baseline.
+ */
+static bool run_sweep_cases(size_t max_items)
+{
+    bool ok = true;
+    for (size_t count = SWEEP_MIN_ITEMS; ok && count <= max_items; count *= 10)
+    {
+        for (size_t k = 0; ok && k < sizeof(key_lens) / sizeof(key_lens[0]); k++)
+        {
+            uint8_t *keys = make_sized_keys(count, key_lens[k]);
+            if (!keys)
+            {
+                perror("Can't allocate keys");
+                return false;
+            }
+            for (size_t h = 0; ok && h < sizeof(hashes) / sizeof(hashes[0]); h++)
+            {
+                for (size_t l = 0; ok && l < sizeof(layouts) / sizeof(layouts[0]); l++)
+                {
+                    if (l == 0 || hashes[h].hash == HTABLE_HASH_WORD)
+                        ok = run_sweep_table(&layouts[l], &hashes[h], key_lens[k], count, keys);
+                }
+                if (hashes[h].hash == HTABLE_HASH_WORD)
+                    ok = ok && run_sweep_table(&malloc_layout, &hashes[h], key_lens[k], count, keys);
+            }
+            ok = ok && run_sweep_compact(key_lens[k], count, keys);
+            if (key_lens[k] == 8)
+                ok = ok && run_sweep_u64(count, keys);
+            ok = ok && run_sweep_sorted(key_lens[k], count, keys);
+            free(keys);
+        }
+    }
+    return ok;
+}
+
+/// --------------------- CACHE --------------------
+
+#define CACHE_KEY_LEN 16
+#define CACHE_STREAM_FACTOR 8  // Stream has 8 times more lookups than keys fitting the cache
+
+/**
+ * Cache of max_items keys under skewed stream of 2 * CACHE_STREAM_FACTOR * max_items distinct keys
+ * (index is cube of uniform random, so small indices are hot): find, insert on miss.
+ * Heap is measured in the middle and at the end of the stream, it doesn't grow for bounded table.
+ */
+static bool run_cache_case(const struct layout *layout, size_t max_items, const uint8_t *keys, size_t keys_count)
+{
+    htable_options_t options = {0, NULL, layout->flags & ~HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    size_t stream_len = CACHE_STREAM_FACTOR * max_items, heap = heap_used(), middle_heap = 0;
+    struct item item = {0};
+    item.base.key_len = CACHE_KEY_LEN;
+    htable_stats_t stats;
+    uint64_t x = 88172645463325252ull;
+
+    htable_t *ht = htable_make_ex(&options);
+    bool ok = ht && htable_set_max_items(ht, max_items);
+    double start = now();
+    for (size_t i = 0; ok && i < stream_len; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        double u = (double)(x >> 11) / (double)(1ull << 53);
+        item.base.key = (uint8_t*)keys + (size_t)(u * u * u * keys_count) * CACHE_KEY_LEN;
+        if (!htable_find(ht, (htable_item_base_t*)&item, NULL))
+            htable_set(ht, (htable_item_base_t*)&item, sizeof(item));
+        ok = htable_status(ht) == HTABLE_OK;
+        if (i == stream_len / 2)
+            middle_heap = heap_used() - heap;
+    }
+    double time = now() - start;
+    ok = ok && htable_stats(ht, &stats);
+    size_t end_heap = heap_used() - heap;
+    htable_destroy(ht);
+    if (!ok)
+    {
+        fprintf(stderr, "Hash table error: cache layout=%s\n", layout->name);
+        return false;
+    }
+
+    printf("cache layout=%s max_items=%zu keys=%zu lookups=%zu lookup_ns=%.1f hit_ratio=%.3f evictions=%llu "
+           "middle_bytes=%zu end_bytes=%zu\n", layout->name, max_items, keys_count, stream_len,
+           time * 1e9 / stream_len, (double)stats.hits / stream_len, (unsigned long long)stats.evictions,
+           middle_heap, end_heap);
+    return true;
+}
+
+static bool run_cache_cases(size_t max_items)
+{
+    size_t keys_count = 2 * CACHE_STREAM_FACTOR * max_items;
+    uint8_t *keys = make_sized_keys(keys_count / 2, CACHE_KEY_LEN);
+    if (!keys)
+    {
+        perror("Can't allocate keys");
+        return false;
+    }
+    bool ok = true;
+    for (size_t l = 0; ok && l < sizeof(layouts) / sizeof(layouts[0]); l++)
+        ok = run_cache_case(&layouts[l], max_items, keys, keys_count);
+    free(keys);
+    return ok;
+}
+
+/// --------------------- INTERN --------------------
+
+#define INTERN_REPEATS 8  // Every distinct string comes 8 times on average
+
+/**
+ * Stream of count strings drawn uniformly from count / INTERN_REPEATS distinct ones is interned
+ * one by one and by htable_intern_bulk; heap is measured after the stream.
+ */
+static bool run_intern_case(size_t count, const uint8_t *keys)
+{
+    size_t distinct = count / INTERN_REPEATS, heap = 0, interned = 0;
+    const uint8_t **strs = malloc(count * sizeof(uint8_t*));
+    size_t *lens = malloc(count * sizeof(size_t));
+    uint32_t *ids = malloc(count * sizeof(uint32_t));
+    uint64_t x = 88172645463325252ull, sums[2] = {0, 0};
+    double times[2] = {0, 0};
+    bool ok = strs && lens && ids;
+    for (size_t i = 0; ok && i < count; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        strs[i] = keys + (x % distinct) * KEY_LEN;
+        lens[i] = KEY_LEN;
+    }
+
+    for (int bulk = 0; ok && bulk < 2; bulk++)
+    {
+        size_t start_heap = heap_used();
+        htable_intern_t *in = htable_intern_make(0);
+        double start = now();
+        if (bulk)
+            ok = in && htable_intern_bulk(in, strs, lens, count, ids) == count;
+        for (size_t i = 0; ok && !bulk && i < count; i++)
+        {
+            ids[i] = htable_intern(in, strs[i], lens[i]);
+            ok = ids[i] != HTABLE_INTERN_NONE;
+        }
+        times[bulk] = now() - start;
+        for (size_t i = 0; ok && i < count; i++)
+            sums[bulk] += ids[i];
+        interned = htable_intern_count(in);
+        ok = ok && interned <= distinct;
+        if (bulk)
+            heap = heap_used() - start_heap;
+        htable_intern_destroy(in);
+    }
+    free(strs);
+    free(lens);
+    free(ids);
+    if (!ok || sums[0] != sums[1])
+    {
+        fprintf(stderr, "Hash table error: intern\n");
+        return false;
+    }
+    printf("intern strings=%zu distinct=%zu intern_ns=%.1f bulk_ns=%.1f bytes_per_string=%.1f\n", count,
+           interned, times[0] * 1e9 / count, times[1] * 1e9 / count, (double)heap / interned);
+    return true;
+}
+
+void print_usage(const char *name)
+{
+    printf("Usage: %s [capacity [max_items]]\n", name);
+    printf("    capacity - capacity of tables in layout, concurrency and snapshot cases (2097152 by default)\n");
+    printf("    max_items - the biggest table of sweep: 1000 .. %d (1000000 by default)\n", SWEEP_MAX_ITEMS);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t capacity = 1 << 21;
+    size_t max_items = 1000000;
+    if (argc > 3)
+    {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (argc >= 2)
+        capacity = strtoull(argv[1], NULL, 10);
+    if (argc == 3)
+        max_items = strtoull(argv[2], NULL, 10);
+    if (max_items < SWEEP_MIN_ITEMS || max_items > SWEEP_MAX_ITEMS)
+    {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    uint8_t *keys = make_keys(2 * capacity);
+    if (!keys)
+    {
+        perror("Can't allocate keys");
+        exit(EXIT_FAILURE);
+    }
+
+    bool ok = true;
+    for (size_t l = 0; ok && l < sizeof(layouts) / sizeof(layouts[0]); l++)
+    {
+        for (size_t i = 0; ok && i < sizeof(loads) / sizeof(loads[0]); i++)
+        {
+            if (loads[i] < layouts[l].max_load)
+                ok = run_case(&layouts[l], capacity, loads[i], keys);
+        }
+    }
+
+    ok = ok && run_sharded_cases(capacity, keys);
+    ok = ok && run_readers_cases(capacity, keys);
+    ok = ok && run_snapshot_case(capacity, keys);
+    ok = ok && run_stats_cases(capacity / 2, keys);
+    ok = ok && run_merge_cases(capacity / 2, keys);
+    ok = ok && run_bloom_cases(capacity, keys);
+    ok = ok && run_pages_cases(2 * capacity, keys);
+    ok = ok && run_intern_case(2 * capacity, keys);
+    free(keys);
+    ok = ok && run_hash_cases(capacity / 4);
+    ok = ok && run_cache_cases(capacity / 16);
+    ok = ok && run_sweep_cases(max_items);
+    exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
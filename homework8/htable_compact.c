@@ -0,0 +1,267 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "htable_compact.h"
+#include "htable_hash.h"
+
+#define CHECK_AND_EXIT_WITH_VAL_IF(cond, v)       if (cond)  return v;
+#define CHECK_AND_EXIT_IF(cond)                   if (cond)  return;
+
+#define COMPACT_MIN_CAPACITY 16
+#define COMPACT_MAX_CAPACITY ((size_t)1 << 31)
+#define COMPACT_MAX_UNIT 8                              // Records are aligned to unit, offsets are in units
+#define COMPACT_MAX_POOL(unit) ((size_t)UINT32_MAX * (unit))
+#define COMPACT_MIN_POOL 4096
+#define COMPACT_EMPTY 0                                 // The first unit of pool is reserved, so 0 is empty slot
+#define ALIGN_UNIT(ht, size) (((size) + (ht)->unit - 1) & ~((ht)->unit - 1))
+#define VARINT_MAX_LEN 10
+
+struct htable_compact_t
+{
+    uint32_t *slots;        // Offsets of records in units
+    uint32_t *hashes;       // Hashes of keys, the array follows slots array in the same allocation
+    size_t capacity;        // Power of two
+    size_t count;
+    uint8_t *pool;          // Records: value, varint key length, key, padding to unit
+    size_t pool_size;
+    size_t pool_capacity;
+    size_t value_size;
+    size_t unit;            // Alignment values need: the lowest set bit of value_size, up to COMPACT_MAX_UNIT
+    unsigned unit_shift;    // log2(unit)
+    uint64_t seed;
+};
+
+static size_t put_varint(uint8_t *p, size_t value)
+{
+    size_t len = 0;
+    while (value >= 0x80)
+    {
+        p[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    p[len++] = (uint8_t)value;
+    return len;
+}
+
+static const uint8_t *get_varint(const uint8_t *p, size_t *value)
+{
+    size_t shift = 0;
+    *value = 0;
+    while (*p & 0x80)
+    {
+        *value |= (size_t)(*p++ & 0x7F) << shift;
+        shift += 7;
+    }
+    *value |= (size_t)*p++ << shift;
+    return p;
+}
+
+static inline uint8_t *record(const htable_compact_t *ht, uint32_t offset)
+{
+    return ht->pool + ((size_t)offset << ht->unit_shift);
+}
+
+/**
+ * Returns slot of key or empty slot where it has to be inserted.
+ */
+static size_t probe(const htable_compact_t *ht, const uint8_t *key, size_t key_len, uint32_t hash, bool *found)
+{
+    size_t mask = ht->capacity - 1;
+    size_t index = hash & mask;
+    size_t len;
+    const uint8_t *stored_key;
+
+    while (ht->slots[index] != COMPACT_EMPTY)
+    {
+        // Stored hash rejects mismatches without touching the pool
+        if (ht->hashes[index] == hash)
+        {
+            stored_key = get_varint(record(ht, ht->slots[index]) + ht->value_size, &len);
+            if (len == key_len && (!key_len || 0 == memcmp(stored_key, key, key_len)))  // Empty key may be NULL
+            {
+                *found = true;
+                return index;
+            }
+        }
+        index = (index + 1) & mask;
+    }
+    *found = false;
+    return index;
+}
+
+static bool alloc_slots(htable_compact_t *ht, size_t capacity)
+{
+    uint32_t *slots = calloc(capacity, 2 * sizeof(uint32_t));
+    CHECK_AND_EXIT_WITH_VAL_IF(!slots, false)
+    ht->slots = slots;
+    ht->hashes = slots + capacity;
+    ht->capacity = capacity;
+    return true;
+}
+
+static bool grow(htable_compact_t *ht)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(ht->capacity >= COMPACT_MAX_CAPACITY, false)
+
+    uint32_t *old_slots = ht->slots, *old_hashes = ht->hashes;
+    size_t old_capacity = ht->capacity;
+    CHECK_AND_EXIT_WITH_VAL_IF(!alloc_slots(ht, old_capacity << 1), false)
+
+    size_t mask = ht->capacity - 1, index;
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        if (old_slots[i] == COMPACT_EMPTY)
+            continue;
+        for (index = old_hashes[i] & mask; ht->slots[index] != COMPACT_EMPTY; index = (index + 1) & mask)
+            ;
+        ht->slots[index] = old_slots[i];
+        ht->hashes[index] = old_hashes[i];
+    }
+    free(old_slots);
+    return true;
+}
+
+/**
+ * Append record of key to the pool, returns its offset or COMPACT_EMPTY if memory can't be allocated.
+ */
+static uint32_t append_record(htable_compact_t *ht, const uint8_t *key, size_t key_len)
+{
+    size_t max_pool = COMPACT_MAX_POOL(ht->unit);
+    CHECK_AND_EXIT_WITH_VAL_IF(key_len > max_pool, COMPACT_EMPTY)
+    size_t size = ALIGN_UNIT(ht, ht->value_size + VARINT_MAX_LEN + key_len);
+    CHECK_AND_EXIT_WITH_VAL_IF(size > max_pool - ht->pool_size, COMPACT_EMPTY)
+
+    if (ht->pool_capacity - ht->pool_size < size)
+    {
+        // Big pools are moved by mremap without copying, so growing by half keeps less slack than doubling
+        size_t new_capacity = ht->pool_capacity + (ht->pool_capacity >> 1);
+        if (new_capacity - ht->pool_size < size)
+            new_capacity = ht->pool_size + size;
+        if (new_capacity > max_pool)
+            new_capacity = max_pool;
+        uint8_t *new_pool = realloc(ht->pool, new_capacity);
+        CHECK_AND_EXIT_WITH_VAL_IF(!new_pool, COMPACT_EMPTY)
+        ht->pool = new_pool;
+        ht->pool_capacity = new_capacity;
+    }
+
+    uint8_t *p = ht->pool + ht->pool_size;
+    memset(p, 0, ht->value_size);
+    size_t len = put_varint(p + ht->value_size, key_len);
+    if (key_len)
+        memcpy(p + ht->value_size + len, key, key_len);
+
+    uint32_t offset = (uint32_t)(ht->pool_size >> ht->unit_shift);
+    ht->pool_size += ALIGN_UNIT(ht, ht->value_size + len + key_len);
+    return offset;
+}
+
+htable_compact_t *htable_compact_make(size_t init_len, size_t value_size, uint64_t seed)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(value_size > COMPACT_MAX_POOL(1) / 2, NULL)
+    htable_compact_t *ht = malloc(sizeof(htable_compact_t));
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, NULL)
+
+    size_t capacity = COMPACT_MIN_CAPACITY;
+    while (capacity - (capacity >> 2) < init_len && capacity < COMPACT_MAX_CAPACITY)
+        capacity <<= 1;
+
+    ht->pool = malloc(COMPACT_MIN_POOL);
+    if (!ht->pool || !alloc_slots(ht, capacity))
+    {
+        free(ht->pool);
+        free(ht);
+        return NULL;
+    }
+    // Alignment of any type divides its size, so records of keys without values aren't aligned at all
+    ht->unit = (value_size) ? value_size & -value_size : 1;
+    if (ht->unit > COMPACT_MAX_UNIT)
+        ht->unit = COMPACT_MAX_UNIT;
+    ht->unit_shift = __builtin_ctzll(ht->unit);
+    ht->count = 0;
+    ht->pool_size = ht->unit;  // Reserved, so no record has offset COMPACT_EMPTY
+    ht->pool_capacity = COMPACT_MIN_POOL;
+    ht->value_size = value_size;
+    ht->seed = seed;
+    return ht;
+}
+
+void htable_compact_destroy(htable_compact_t *ht)
+{
+    CHECK_AND_EXIT_IF(!ht)
+    free(ht->slots);
+    free(ht->pool);
+    free(ht);
+}
+
+void *htable_compact_upsert(htable_compact_t *ht, const uint8_t *key, size_t key_len, bool *inserted)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF(!key && key_len, NULL)
+
+    bool found;
+    uint32_t hash = htable_word_hash(key, key_len, ht->seed);
+    size_t index = probe(ht, key, key_len, hash, &found);
+    if (inserted)
+        *inserted = false;
+    if (found)
+        return record(ht, ht->slots[index]);
+
+    // Slots grow first: if the pool can't take the record nothing is changed
+    if (ht->count + 1 > ht->capacity - (ht->capacity >> 2))
+    {
+        CHECK_AND_EXIT_WITH_VAL_IF(!grow(ht), NULL)
+        index = probe(ht, key, key_len, hash, &found);
+    }
+    uint32_t offset = append_record(ht, key, key_len);
+    CHECK_AND_EXIT_WITH_VAL_IF(offset == COMPACT_EMPTY, NULL)
+
+    ht->slots[index] = offset;
+    ht->hashes[index] = hash;
+    ht->count++;
+    if (inserted)
+        *inserted = true;
+    return record(ht, offset);
+}
+
+void *htable_compact_find(const htable_compact_t *ht, const uint8_t *key, size_t key_len)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF(!key && key_len, NULL)
+
+    bool found;
+    size_t index = probe(ht, key, key_len, htable_word_hash(key, key_len, ht->seed), &found);
+    return (found) ? record(ht, ht->slots[index]) : NULL;
+}
+
+size_t htable_compact_count(const htable_compact_t *ht)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, 0)
+    return ht->count;
+}
+
+size_t htable_compact_memory(const htable_compact_t *ht)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, 0)
+    return sizeof(htable_compact_t) + ht->capacity * 2 * sizeof(uint32_t) + ht->pool_capacity;
+}
+
+bool htable_compact_enumerate(const htable_compact_t *ht,
+                              int (*callback)(const uint8_t *key, size_t key_len, void *value, void *ctx), void *ctx)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, true)
+    CHECK_AND_EXIT_WITH_VAL_IF(!callback, true)
+
+    // Records follow each other in insertion order
+    uint8_t *p = ht->pool + ht->unit, *end = ht->pool + ht->pool_size;
+    const uint8_t *key;
+    size_t key_len;
+    while (p < end)
+    {
+        key = get_varint(p + ht->value_size, &key_len);
+        if (!callback(key, key_len, p, ctx))
+            return false;
+        p += ALIGN_UNIT(ht, (size_t)(key - p) + key_len);
+    }
+    return true;
+}
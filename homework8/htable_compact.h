@@ -0,0 +1,110 @@
+#ifndef _H_TABLE_COMPACT_H
+#define _H_TABLE_COMPACT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct htable_compact_t htable_compact_t;
+
+/**
+ *   Make a compact hash table
+ *
+ *   \param [in] init_len - The initial number of keys in the hash table
+ *
+ *   \param [in] value_size - Size of value stored with every key (can be 0)
+ *
+ *   \param [in] seed - Seed of hash function (see htable_word_hash)
+ *
+ *   \return It returns pointer to the instance of hash table or NULL if error happened
+ *
+ *   \details Keys and values are appended to one contiguous pool as records: value, key length
+ *   (1 byte for keys shorter than 128 bytes) and key. Records are aligned only as much as values need:
+ *   to the lowest set bit of value_size up to 8 bytes, records of keys without values are packed.
+ *   Every slot keeps 32-bit offset of record (in units of that alignment) and 32-bit hash of key,
+ *   so there are no per-key allocations and no pointers. Slot array is loaded up to 3/4 and grows
+ *   without touching the pool (stored hashes are used). Counting words (8-byte keys and values) it takes
+ *   less than half of memory of htable_t made with default options, which allocates every item and its
+ *   key: 47 against 105 bytes per key (htable_bench lines "sweep impl=linear_malloc key_len=8" and
+ *   "sweep impl=compact key_len=8"), 37 bytes with 4-byte values. Against htable_t with arena 8-byte
+ *   keys take about 1/3 of memory without value, 1/2 with 4-byte and 2/3 with 8-byte value; 64-byte
+ *   keys save from 1/3 to nothing. Keys can't be removed. The pool can be up to 4 GiB times the alignment,
+ *   the number of keys up to 2^31.
+ */
+htable_compact_t *htable_compact_make(size_t init_len, size_t value_size, uint64_t seed);
+
+/**
+ *  Destroy the compact hash table
+ *
+ *  \param [in] ht - The instance of hash table
+ */
+void htable_compact_destroy(htable_compact_t *ht);
+
+/**
+ *  Find value of key or insert the key if it isn't in the hash table
+ *
+ *  \param [in] ht - The instance of hash table
+ *
+ *  \param [in] key - Pointer to a buffer with key
+ *
+ *  \param [in] key_len - Length of key's buffer
+ *
+ *  \param [out] inserted - The pointer where true is returned if key was inserted (can be NULL)
+ *
+ *  \return It returns pointer to the value of key (zeroed for inserted key) or NULL if memory
+ *  can't be allocated. The pointer is aligned to the lowest set bit of value_size (up to 8 bytes)
+ *  and valid until the next insert.
+ *
+ *  \details The key is copied to the pool.
+ */
+void *htable_compact_upsert(htable_compact_t *ht, const uint8_t *key, size_t key_len, bool *inserted);
+
+/**
+ *  Find value of key
+ *
+ *  \param [in] ht - The instance of hash table
+ *
+ *  \param [in] key - Pointer to a buffer with key
+ *
+ *  \param [in] key_len - Length of key's buffer
+ *
+ *  \return It returns pointer to the value of key (valid until the next insert) or NULL if key isn't found.
+ */
+void *htable_compact_find(const htable_compact_t *ht, const uint8_t *key, size_t key_len);
+
+/**
+ *  Get the number of keys in the compact hash table
+ *
+ *  \param [in] ht - The instance of hash table
+ *
+ *  \return It returns the number of keys.
+ */
+size_t htable_compact_count(const htable_compact_t *ht);
+
+/**
+ *  Get memory used by the compact hash table
+ *
+ *  \param [in] ht - The instance of hash table
+ *
+ *  \return It returns allocated bytes: slot array, pool (with reserved space) and the table itself.
+ */
+size_t htable_compact_memory(const htable_compact_t *ht);
+
+/**
+ * Enumerate keys of the compact hash table in insertion order
+ *
+ * \param [in] ht - The instance of hash table
+ *
+ * \param [in] callback - The pointer to function that will be called for each key with its value
+ *
+ * \param [in] ctx - The pointer passed to callback
+ *
+ * \return It returns false if enumeration was stopped by callback, true otherwise.
+ *
+ * \details The callback function can return zero to stop enumeration. The key must not be changed
+ * and keys must not be inserted while enumerating. Only the pool is read, slots are not touched.
+ */
+bool htable_compact_enumerate(const htable_compact_t *ht,
+                              int (*callback)(const uint8_t *key, size_t key_len, void *value, void *ctx), void *ctx);
+
+#endif // _H_TABLE_COMPACT_H
@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "htable_compact.h"
+#include "htable_test_system.h"
+
+/// TEST CASES
+#define KEYS_COUNT 10000
+
+static char keys[KEYS_COUNT][TEST_KEY_SIZE];
+
+struct enumerated
+{
+    size_t count;
+    size_t sum;
+    bool ordered;
+    size_t stop_after;
+};
+
+static int enum_callback(const uint8_t *key, size_t key_len, void *value, void *ctx)
+{
+    struct enumerated *e = ctx;
+    size_t i = *(size_t*)value;
+    e->ordered = e->ordered && i == e->count && key_len == strlen(keys[i]) && !memcmp(key, keys[i], key_len);
+    e->sum += i;
+    e->count++;
+    return e->count != e->stop_after;
+}
+
+char *test_wrong_params()
+{
+    htable_compact_t *ht = htable_compact_make(0, sizeof(size_t), 0);
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
+    ASSERTION(htable_compact_upsert(NULL, (uint8_t*)"key", 3, NULL) == NULL, "Expected: NULL!")
+    ASSERTION(htable_compact_upsert(ht, NULL, 3, NULL) == NULL, "Expected: NULL!")
+    ASSERTION(htable_compact_find(NULL, (uint8_t*)"key", 3) == NULL, "Expected: NULL!")
+    ASSERTION(htable_compact_find(ht, NULL, 3) == NULL, "Expected: NULL!")
+    ASSERTION(htable_compact_count(NULL) == 0, "Expected: 0!")
+    ASSERTION(htable_compact_memory(NULL) == 0, "Expected: 0!")
+    ASSERTION(htable_compact_enumerate(NULL, enum_callback, NULL), "Expected: true!")
+    ASSERTION(htable_compact_enumerate(ht, NULL, NULL), "Expected: true!")
+    ASSERTION(htable_compact_count(ht) == 0, "Expected: Nothing was inserted!")
+    htable_compact_destroy(NULL);
+    htable_compact_destroy(ht);
+    return NULL;
+}
+
+char *test_functional()
+{
+    htable_compact_t *ht = htable_compact_make(0, sizeof(size_t), 42);
+    bool inserted;
+    size_t *value;
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
+
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        value = htable_compact_upsert(ht, (uint8_t*)keys[i], strlen(keys[i]), &inserted);
+        ASSERTION(value != NULL && inserted, "Expected: Key was inserted!")
+        ASSERTION(((uintptr_t)value & 7) == 0, "Expected: Value is aligned!")
+        ASSERTION(*value == 0, "Expected: Value of new key is zeroed!")
+        *value = i;
+    }
+    ASSERTION(htable_compact_count(ht) == KEYS_COUNT, "Expected: All keys were inserted!")
+
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        value = htable_compact_upsert(ht, (uint8_t*)keys[i], strlen(keys[i]), &inserted);
+        ASSERTION(value != NULL && !inserted && *value == i, "Expected: Value of existing key!")
+        value = htable_compact_find(ht, (uint8_t*)keys[i], strlen(keys[i]));
+        ASSERTION(value != NULL && *value == i, "Expected: Key was found!")
+    }
+    ASSERTION(htable_compact_count(ht) == KEYS_COUNT, "Expected: Nothing was inserted!")
+    ASSERTION(htable_compact_find(ht, (uint8_t*)"missing", 7) == NULL, "Expected: NULL!")
+    ASSERTION(htable_compact_find(ht, (uint8_t*)keys[1], 1) == NULL, "Expected: Prefix is another key!")
+
+    struct enumerated e = {0, 0, true, 0};
+    ASSERTION(htable_compact_enumerate(ht, enum_callback, &e), "Expected: Enumeration wasn't stopped!")
+    ASSERTION(e.count == KEYS_COUNT && e.sum == (size_t)KEYS_COUNT * (KEYS_COUNT - 1) / 2, "Expected: All keys!")
+    ASSERTION(e.ordered, "Expected: Keys are enumerated in insertion order!")
+
+    e = (struct enumerated){0, 0, true, 10};
+    ASSERTION(!htable_compact_enumerate(ht, enum_callback, &e), "Expected: Enumeration was stopped!")
+    ASSERTION(e.count == 10, "Expected: Callback was called 10 times!")
+
+    htable_compact_destroy(ht);
+    return NULL;
+}
+
+char *test_key_lengths()
+{
+    htable_compact_t *ht = htable_compact_make(4, 1, 0);
+    static uint8_t long_key[100000];
+    bool inserted;
+    uint8_t *value;
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
+
+    // Empty key, key lengths with 1, 2 and 3 bytes of varint
+    const size_t lens[5] = {0, 127, 128, 16384, sizeof(long_key)};
+    for (size_t i = 0; i < sizeof(long_key); i++)
+        long_key[i] = (uint8_t)(i * 31);
+    for (size_t i = 0; i < 5; i++)
+    {
+        value = htable_compact_upsert(ht, long_key, lens[i], &inserted);
+        ASSERTION(value != NULL && inserted, "Expected: Key was inserted!")
+        *value = (uint8_t)i + 1;
+    }
+    ASSERTION(htable_compact_upsert(ht, NULL, 0, &inserted) != NULL && !inserted, "Expected: Empty key was found!")
+    for (size_t i = 0; i < 5; i++)
+    {
+        value = htable_compact_find(ht, long_key, lens[i]);
+        ASSERTION(value != NULL && *value == i + 1, "Expected: Key was found!")
+    }
+    ASSERTION(htable_compact_count(ht) == 5, "Expected: 5 keys!")
+    htable_compact_destroy(ht);
+    return NULL;
+}
+
+char *test_memory()
+{
+    htable_compact_t *ht = htable_compact_make(KEYS_COUNT, sizeof(size_t), 0);
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
+    size_t memory = htable_compact_memory(ht);
+
+    // Presized table doesn't grow, only the pool does
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+        ASSERTION(htable_compact_upsert(ht, (uint8_t*)keys[i], strlen(keys[i]), NULL), "Expected: Key was inserted!")
+    ASSERTION(htable_compact_memory(ht) > memory, "Expected: Pool grew!")
+    ASSERTION(htable_compact_memory(ht) < KEYS_COUNT * 64, "Expected: Less than 64 bytes per key!")
+    htable_compact_destroy(ht);
+    return NULL;
+}
+
+static int count_callback(const uint8_t *key, size_t key_len, __attribute__((unused)) void *value, void *ctx)
+{
+    struct enumerated *e = ctx;
+    e->ordered = e->ordered && key_len == strlen(keys[e->count]) && !memcmp(key, keys[e->count], key_len);
+    e->count++;
+    return 1;
+}
+
+char *test_value_alignment()
+{
+    // Values are aligned to the lowest set bit of their size (up to 8), keys without values are packed
+    const size_t value_sizes[] = {0, 1, 2, 4, 12, 8, 24};
+    size_t packed_memory = 0;
+    uint8_t *value;
+
+    for (size_t v = 0; v < sizeof(value_sizes) / sizeof(value_sizes[0]); v++)
+    {
+        size_t size = value_sizes[v];
+        size_t align = (size & -size) < 8 ? (size & -size) : 8;
+        htable_compact_t *ht = htable_compact_make(0, size, 0);
+        ASSERTION(ht != NULL, "Expected: Hash table was created!")
+        for (size_t i = 0; i < KEYS_COUNT; i++)
+        {
+            value = htable_compact_upsert(ht, (uint8_t*)keys[i], strlen(keys[i]), NULL);
+            ASSERTION(value != NULL, "Expected: Key was inserted!")
+            ASSERTION(!size || ((uintptr_t)value & (align - 1)) == 0, "Expected: Value is aligned!")
+            memset(value, (int)i, size);
+        }
+        for (size_t i = 0; i < KEYS_COUNT; i++)
+        {
+            value = htable_compact_find(ht, (uint8_t*)keys[i], strlen(keys[i]));
+            ASSERTION(value != NULL && (!size || (value[0] == (uint8_t)i && value[size - 1] == (uint8_t)i)),
+                      "Expected: Value of key!")
+        }
+
+        struct enumerated e = {0, 0, true, 0};
+        htable_compact_enumerate(ht, count_callback, &e);
+        ASSERTION(e.count == KEYS_COUNT && e.ordered, "Expected: Records follow each other!")
+        if (!size)
+            packed_memory = htable_compact_memory(ht);
+        else if (size == 8)
+            ASSERTION(packed_memory + KEYS_COUNT * 8 < htable_compact_memory(ht), "Expected: Packed records!")
+        htable_compact_destroy(ht);
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    make_test_keys(keys, KEYS_COUNT, "");
+
+    struct test_case test_cases[] = {
+        {"Test compact wrong params", test_wrong_params},
+        {"Test compact functional", test_functional},
+        {"Test compact key lengths", test_key_lengths},
+        {"Test compact memory", test_memory},
+        {"Test compact value alignment", test_value_alignment},
+        {0, 0},
+    };
+
+    return run_tests(test_cases);
+}
@@ -0,0 +1,221 @@
+#ifndef _H_TABLE_GEN_H
+#define _H_TABLE_GEN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "htable_hash.h"
+
+#define HTABLE_GEN_MIN_CAPACITY 8
+#define HTABLE_GEN_MAX_CAPACITY ((size_t)1 << 31)  // Slot index fits the bits of hash under HTABLE_GEN_USED
+#define HTABLE_GEN_USED 0x80000000u                 // Set in stored hash of full slot, 0 is empty slot
+
+/**
+ *   Generate hash table specialized for key and value types (like C++ template)
+ *
+ *   \param name - Prefix of generated types and functions
+ *
+ *   \param key_t - Type of key, keys are stored by value
+ *
+ *   \param val_t - Type of value, values are stored by value next to keys
+ *
+ *   \param hash_func - Function or macro: uint32_t hash_func(key_t key). Low bits select slot,
+ *   so they have to depend on the whole key (see htable_word_hash and htable_fmix64)
+ *
+ *   \param equal_func - Function or macro: bool equal_func(key_t key1, key_t key2)
+ *
+ *   \details Generated code is static inline, so hash and equality functions are inlined,
+ *   and key/value pairs are copied by assignment instead of memcpy of item_size bytes.
+ *   Pairs are kept in place in one array, hashes in the parallel array (linear probing,
+ *   load factor <= 1/2, capacity is power of two). Removal shifts following pairs back,
+ *   so there are no deleted marks. The table doesn't own what keys and values point to.
+ *
+ *   Generated API (pointers to pairs are valid until the next upsert or remove):
+ *   name_t, name_entry_t { key_t key; val_t val; }
+ *   name_t *name_make(size_t init_len) - NULL if memory can't be allocated
+ *   void name_destroy(name_t *ht)
+ *   name_entry_t *name_find(name_t *ht, key_t key) - NULL if key isn't found
+ *   name_entry_t *name_upsert(name_t *ht, key_t key, bool *inserted) - the pair of key, new pair
+ *   has zeroed value. Key of new pair may be replaced with an equal one (e.g. its copy).
+ *   NULL if memory can't be allocated
+ *   bool name_remove(name_t *ht, key_t key) - false if key isn't found
+ *   size_t name_count(const name_t *ht)
+ *   name_entry_t *name_next(name_t *ht, size_t *iter) - next pair starting from *iter
+ *   (set it to 0 first) or NULL at the end. Don't change the table while iterating
+ */
+#define HTABLE_GEN(name, key_t, val_t, hash_func, equal_func)                                  \
+                                                                                                \
+typedef struct                                                                                  \
+{                                                                                               \
+    key_t key;                                                                                  \
+    val_t val;                                                                                  \
+} name##_entry_t;                                                                               \
+                                                                                                \
+typedef struct                                                                                  \
+{                                                                                               \
+    name##_entry_t *entries;                                                                    \
+    uint32_t *hashes;                                                                           \
+    size_t capacity;                                                                            \
+    size_t count;                                                                               \
+} name##_t;                                                                                     \
+                                                                                                \
+/* Table is changed only if both arrays are allocated */                                        \
+static inline bool name##_alloc_(name##_t *ht, size_t capacity)                                 \
+{                                                                                               \
+    name##_entry_t *entries = malloc(capacity * sizeof(name##_entry_t));                        \
+    uint32_t *hashes = calloc(capacity, sizeof(uint32_t));                                      \
+    if (!entries || !hashes)                                                                    \
+    {                                                                                           \
+        free(entries);                                                                          \
+        free(hashes);                                                                           \
+        return false;                                                                           \
+    }                                                                                           \
+    ht->entries = entries;                                                                      \
+    ht->hashes = hashes;                                                                        \
+    ht->capacity = capacity;                                                                    \
+    return true;                                                                                \
+}                                                                                               \
+                                                                                                \
+static inline name##_t *name##_make(size_t init_len)                                            \
+{                                                                                               \
+    size_t capacity = HTABLE_GEN_MIN_CAPACITY;                                                  \
+    while (capacity < init_len && capacity < HTABLE_GEN_MAX_CAPACITY)                           \
+        capacity <<= 1;                                                                         \
+                                                                                                \
+    name##_t *ht = malloc(sizeof(name##_t));                                                    \
+    if (!ht)                                                                                    \
+        return NULL;                                                                            \
+    if (!name##_alloc_(ht, capacity))                                                           \
+    {                                                                                           \
+        free(ht);                                                                               \
+        return NULL;                                                                            \
+    }                                                                                           \
+    ht->count = 0;                                                                              \
+    return ht;                                                                                  \
+}                                                                                               \
+                                                                                                \
+static inline void name##_destroy(name##_t *ht)                                                 \
+{                                                                                               \
+    if (!ht)                                                                                    \
+        return;                                                                                 \
+    free(ht->entries);                                                                          \
+    free(ht->hashes);                                                                           \
+    free(ht);                                                                                   \
+}                                                                                               \
+                                                                                                \
+/* Returns slot of key or empty slot where it has to be inserted */                             \
+static inline size_t name##_probe_(const name##_t *ht, key_t key, uint32_t hash, bool *found)   \
+{                                                                                               \
+    size_t mask = ht->capacity - 1;                                                             \
+    size_t index = hash & mask;                                                                 \
+    while (ht->hashes[index])                                                                   \
+    {                                                                                           \
+        if (ht->hashes[index] == hash && equal_func(ht->entries[index].key, key))               \
+        {                                                                                       \
+            *found = true;                                                                      \
+            return index;                                                                       \
+        }                                                                                       \
+        index = (index + 1) & mask;                                                             \
+    }                                                                                           \
+    *found = false;                                                                             \
+    return index;                                                                               \
+}                                                                                               \
+                                                                                                \
+static inline bool name##_grow_(name##_t *ht)                                                   \
+{                                                                                               \
+    if (ht->capacity >= HTABLE_GEN_MAX_CAPACITY)                                                \
+        return false;                                                                           \
+                                                                                                \
+    name##_t old = *ht;                                                                         \
+    if (!name##_alloc_(ht, old.capacity << 1))                                                  \
+        return false;                                                                           \
+                                                                                                \
+    size_t mask = ht->capacity - 1, index;                                                      \
+    for (size_t i = 0; i < old.capacity; i++)                                                   \
+    {                                                                                           \
+        if (!old.hashes[i])                                                                     \
+            continue;                                                                           \
+        for (index = old.hashes[i] & mask; ht->hashes[index]; index = (index + 1) & mask)       \
+            ;                                                                                   \
+        ht->hashes[index] = old.hashes[i];                                                      \
+        ht->entries[index] = old.entries[i];                                                    \
+    }                                                                                           \
+    free(old.entries);                                                                          \
+    free(old.hashes);                                                                           \
+    return true;                                                                                \
+}                                                                                               \
+                                                                                                \
+static inline name##_entry_t *name##_find(name##_t *ht, key_t key)                              \
+{                                                                                               \
+    bool found;                                                                                 \
+    size_t index = name##_probe_(ht, key, (uint32_t)(hash_func(key)) | HTABLE_GEN_USED, &found); \
+    return (found) ? &ht->entries[index] : NULL;                                                \
+}                                                                                               \
+                                                                                                \
+static inline name##_entry_t *name##_upsert(name##_t *ht, key_t key, bool *inserted)            \
+{                                                                                               \
+    bool found;                                                                                 \
+    uint32_t hash = (uint32_t)(hash_func(key)) | HTABLE_GEN_USED;                               \
+    size_t index = name##_probe_(ht, key, hash, &found);                                        \
+    if (inserted)                                                                               \
+        *inserted = false;                                                                      \
+    if (found)                                                                                  \
+        return &ht->entries[index];                                                             \
+                                                                                                \
+    if ((ht->count + 1) << 1 > ht->capacity)                                                    \
+    {                                                                                           \
+        if (!name##_grow_(ht))                                                                  \
+            return NULL;                                                                        \
+        index = name##_probe_(ht, key, hash, &found);                                           \
+    }                                                                                           \
+    ht->hashes[index] = hash;                                                                   \
+    ht->entries[index].key = key;                                                               \
+    memset(&ht->entries[index].val, 0, sizeof(val_t));                                          \
+    ht->count++;                                                                                \
+    if (inserted)                                                                               \
+        *inserted = true;                                                                       \
+    return &ht->entries[index];                                                                 \
+}                                                                                               \
+                                                                                                \
+static inline bool name##_remove(name##_t *ht, key_t key)                                       \
+{                                                                                               \
+    bool found;                                                                                 \
+    size_t index = name##_probe_(ht, key, (uint32_t)(hash_func(key)) | HTABLE_GEN_USED, &found); \
+    if (!found)                                                                                 \
+        return false;                                                                           \
+                                                                                                \
+    /* Backward shift: a pair moves to the freed slot if its home slot is not after the slot */ \
+    size_t mask = ht->capacity - 1, next = index, home;                                         \
+    for (next = (next + 1) & mask; ht->hashes[next]; next = (next + 1) & mask)                  \
+    {                                                                                           \
+        home = ht->hashes[next] & mask;                                                         \
+        if (((next - home) & mask) >= ((next - index) & mask))                                  \
+        {                                                                                       \
+            ht->hashes[index] = ht->hashes[next];                                               \
+            ht->entries[index] = ht->entries[next];                                             \
+            index = next;                                                                       \
+        }                                                                                       \
+    }                                                                                           \
+    ht->hashes[index] = 0;                                                                      \
+    ht->count--;                                                                                \
+    return true;                                                                                \
+}                                                                                               \
+                                                                                                \
+static inline size_t name##_count(const name##_t *ht)                                           \
+{                                                                                               \
+    return ht->count;                                                                           \
+}                                                                                               \
+                                                                                                \
+static inline name##_entry_t *name##_next(name##_t *ht, size_t *iter)                           \
+{                                                                                               \
+    for (; *iter < ht->capacity; (*iter)++)                                                     \
+    {                                                                                           \
+        if (ht->hashes[*iter])                                                                  \
+            return &ht->entries[(*iter)++];                                                     \
+    }                                                                                           \
+    return NULL;                                                                                \
+}                                                                                               \
+
+#endif // _H_TABLE_GEN_H
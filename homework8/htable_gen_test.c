@@ -0,0 +1,243 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t allocations_before_failure = SIZE_MAX;  // Allocations of generated tables fail when it's 0
+
+static void *failing_malloc(size_t size)
+{
+    if (allocations_before_failure == 0)
+        return NULL;
+    allocations_before_failure--;
+    return malloc(size);
+}
+
+static void *failing_calloc(size_t count, size_t size)
+{
+    if (allocations_before_failure == 0)
+        return NULL;
+    allocations_before_failure--;
+    return calloc(count, size);
+}
+
+// stdlib.h is included already, so only the generated code calls these
+#define malloc(size) failing_malloc(size)
+#define calloc(count, size) failing_calloc(count, size)
+
+#include "htable_gen.h"
+#include "htable_test_system.h"
+
+/// TEST CASES
+#define KEYS_COUNT 1000
+
+static inline uint32_t hash_int(uint64_t key)
+{
+    return (uint32_t)htable_fmix64(key);
+}
+
+static inline uint32_t bad_hash_int(__attribute__((unused)) uint64_t key)
+{
+    return 6;  // All keys collide, probe chain wraps around the end of array
+}
+
+static inline bool equal_ints(uint64_t key1, uint64_t key2)
+{
+    return key1 == key2;
+}
+
+HTABLE_GEN(ints, uint64_t, uint64_t, hash_int, equal_ints)
+HTABLE_GEN(collided, uint64_t, uint64_t, bad_hash_int, equal_ints)
+
+struct str
+{
+    const char *p;
+    size_t len;
+};
+
+struct point
+{
+    int x, y;
+};
+
+static inline uint32_t hash_str(struct str key)
+{
+    return htable_word_hash((const uint8_t*)key.p, key.len, 0);
+}
+
+static inline bool equal_strs(struct str key1, struct str key2)
+{
+    return key1.len == key2.len && 0 == memcmp(key1.p, key2.p, key1.len);
+}
+
+#define HASH_STR(key) hash_str(key)  // Macros can be used as well
+HTABLE_GEN(points, struct str, struct point, HASH_STR, equal_strs)
+
+static char keys[KEYS_COUNT][TEST_KEY_SIZE];
+
+char *test_make()
+{
+    ints_t *ht = ints_make(0);
+    ASSERTION(ht != NULL, "Expected: not NULL!")
+    ASSERTION(ht->capacity == HTABLE_GEN_MIN_CAPACITY, "Expected: Minimal capacity!")
+    ASSERTION(ints_count(ht) == 0, "Expected: Empty table!")
+    ints_destroy(ht);
+
+    ht = ints_make(100);
+    ASSERTION(ht->capacity == 128, "Expected: Capacity is power of two!")
+    ints_destroy(ht);
+    ints_destroy(NULL);
+    return NULL;
+}
+
+char *test_functional()
+{
+    ints_t *ht = ints_make(0);
+    bool inserted;
+    ints_entry_t *entry;
+
+    for (uint64_t i = 0; i < KEYS_COUNT; i++)
+    {
+        entry = ints_upsert(ht, i, &inserted);
+        ASSERTION(entry && inserted, "Expected: Key was inserted!")
+        ASSERTION(entry->key == i && entry->val == 0, "Expected: New pair has zeroed value!")
+        entry->val = i * 2;
+    }
+    ASSERTION(ints_count(ht) == KEYS_COUNT, "Expected: All keys were inserted!")
+    ASSERTION(ints_count(ht) * 2 <= ht->capacity, "Expected: Load factor <= 1/2!")
+
+    entry = ints_upsert(ht, 7, &inserted);
+    ASSERTION(entry && !inserted && entry->val == 14, "Expected: Existing pair!")
+
+    for (uint64_t i = 0; i < KEYS_COUNT; i += 2)
+        ASSERTION(ints_remove(ht, i), "Expected: Key was removed!")
+    ASSERTION(!ints_remove(ht, 0), "Expected: Key was not found!")
+    ASSERTION(ints_count(ht) == KEYS_COUNT / 2, "Expected: Half of keys left!")
+
+    for (uint64_t i = 0; i < KEYS_COUNT; i++)
+    {
+        entry = ints_find(ht, i);
+        ASSERTION((entry != NULL) == (i & 1), "Expected: Odd keys were found!")
+        ASSERTION(!entry || entry->val == i * 2, "Expected: Value of pair!")
+    }
+    ASSERTION(ints_find(ht, KEYS_COUNT) == NULL, "Expected: Key was not found!")
+
+    ints_destroy(ht);
+    return NULL;
+}
+
+char *test_upsert_grow_fail()
+{
+    ints_t *ht = ints_make(0);
+    bool inserted;
+    uint64_t i = 0;
+
+    for (; (ints_count(ht) + 1) * 2 <= ht->capacity; i++)
+        ints_upsert(ht, i, NULL);
+
+    inserted = true;
+    allocations_before_failure = 0;
+    ASSERTION(ints_upsert(ht, i, &inserted) == NULL, "Expected: NULL!")
+    allocations_before_failure = SIZE_MAX;
+    ASSERTION(!inserted, "Expected: Nothing was inserted!")
+    ASSERTION(ints_count(ht) == i, "Expected: Count not changed!")
+    ASSERTION(ints_find(ht, i) == NULL, "Expected: Key was not found!")
+
+    ASSERTION(ints_upsert(ht, i, &inserted) && inserted, "Expected: Key was inserted after failure!")
+    ints_destroy(ht);
+    return NULL;
+}
+
+char *test_backward_shift()
+{
+    collided_t *ht = collided_make(0);
+    collided_entry_t *entry;
+
+    // Keys fill the array up to load factor 1/2 starting from slot 6
+    for (uint64_t i = 0; i < 4; i++)
+        collided_upsert(ht, i * 4 + 3, NULL)->val = i;
+    ASSERTION(ht->capacity == 8, "Expected: Table didn't grow!")
+    ASSERTION(ht->hashes[0] != 0 && ht->hashes[2] == 0, "Expected: Probe chain wrapped!")
+
+    ASSERTION(collided_remove(ht, 3), "Expected: Key was removed!")
+    ASSERTION(collided_remove(ht, 11), "Expected: Key was removed!")
+    for (uint64_t i = 1; i < 4; i += 2)
+    {
+        entry = collided_find(ht, i * 4 + 3);
+        ASSERTION(entry && entry->val == i, "Expected: Shifted pair was found!")
+    }
+    ASSERTION(ht->hashes[0] == 0 && ht->hashes[1] == 0, "Expected: No holes left in probe chain!")
+
+    for (uint64_t i = 0; i < KEYS_COUNT; i++)
+    {
+        collided_upsert(ht, KEYS_COUNT + i, NULL);
+        ASSERTION(collided_remove(ht, KEYS_COUNT + i), "Expected: Key was removed!")
+    }
+    ASSERTION(collided_count(ht) == 2, "Expected: Churn didn't change table!")
+    collided_destroy(ht);
+    return NULL;
+}
+
+char *test_struct_keys()
+{
+    points_t *ht = points_make(0);
+    points_entry_t *entry;
+
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        entry = points_upsert(ht, (struct str){keys[i], strlen(keys[i])}, NULL);
+        entry->val.x = i;
+        entry->val.y = -(int)i;
+    }
+
+    char key[16];
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        // Equal key from another buffer
+        memcpy(key, keys[i], sizeof(key));
+        entry = points_find(ht, (struct str){key, strlen(key)});
+        ASSERTION(entry && entry->val.x == (int)i && entry->val.y == -(int)i, "Expected: Value of pair!")
+    }
+    ASSERTION(!points_find(ht, (struct str){"key", 3}), "Expected: Key was not found!")
+    points_destroy(ht);
+    return NULL;
+}
+
+char *test_iteration()
+{
+    ints_t *ht = ints_make(0);
+    for (uint64_t i = 1; i <= KEYS_COUNT; i++)
+        ints_upsert(ht, i, NULL)->val = i;
+
+    size_t iter = 0, count = 0;
+    uint64_t sum = 0;
+    ints_entry_t *entry;
+    while ((entry = ints_next(ht, &iter)))
+    {
+        ASSERTION(entry->key == entry->val, "Expected: Pair is consistent!")
+        sum += entry->val;
+        count++;
+    }
+    ASSERTION(count == KEYS_COUNT, "Expected: All pairs were visited!")
+    ASSERTION(sum == (uint64_t)KEYS_COUNT * (KEYS_COUNT + 1) / 2, "Expected: Every pair was visited once!")
+    ASSERTION(ints_next(ht, &iter) == NULL, "Expected: End of table!")
+    ints_destroy(ht);
+    return NULL;
+}
+
+int main(void)
+{
+    make_test_keys(keys, KEYS_COUNT, "key");
+
+    struct test_case test_cases[] = {
+        {"Test generated make", test_make},
+        {"Test generated functional", test_functional},
+        {"Test generated upsert grow fail", test_upsert_grow_fail},
+        {"Test generated backward shift", test_backward_shift},
+        {"Test generated struct keys", test_struct_keys},
+        {"Test generated iteration", test_iteration},
+        {0, 0},
+    };
+
+    return run_tests(test_cases);
+}
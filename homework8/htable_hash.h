@@ -0,0 +1,144 @@
+#ifndef _H_TABLE_HASH_H
+#define _H_TABLE_HASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+#define HTABLE_HAVE_CRC32C 1   // CRC32C instructions are used if CPU supports them (checked at runtime)
+#endif
+
+// Built-in hash functions (HTABLE_HASH_WORD, HTABLE_HASH_CRC32C, HTABLE_HASH_JENKINS). They're inline,
+// so code specialized for a key type (see htable_gen.h) hashes keys without a call through pointer.
+
+#define HTABLE_WORD_HASH_M1 0x9E3779B97F4A7C15ull
+#define HTABLE_WORD_HASH_M2 0xC2B2AE3D27D4EB4Full
+#define HTABLE_ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static inline uint64_t htable_load_word(const uint8_t *p)
+{
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));  // Compiles to one unaligned load
+    return word;
+}
+
+static inline uint32_t htable_load_half_word(const uint8_t *p)
+{
+    uint32_t half_word;
+    memcpy(&half_word, p, sizeof(half_word));
+    return half_word;
+}
+
+/**
+ * Load tail of key (1..7 bytes) without byte loop. Loads may overlap, it's fine
+ * because every byte is loaded and the key length is mixed in the hash anyway.
+ */
+static inline uint64_t htable_load_tail(const uint8_t *p, size_t len)
+{
+    if (len >= 4)
+        return htable_load_half_word(p) | (uint64_t)htable_load_half_word(p + len - 4) << 32;
+    return p[0] | (uint64_t)p[len >> 1] << 8 | (uint64_t)p[len - 1] << 16;
+}
+
+/**
+ * Finalizer of MurmurHash3, every bit of the result depends on every bit of h.
+ */
+static inline uint64_t htable_fmix64(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * Word-at-a-time hash function. Used as default hash function.
+ * The key is read by 8 bytes, the key length is mixed in the seed.
+ */
+static inline uint32_t htable_word_hash(const uint8_t *key, size_t key_len, uint64_t seed)
+{
+    uint64_t hash = seed ^ (key_len * HTABLE_WORD_HASH_M1);
+
+    while (key_len >= 8)
+    {
+        hash ^= HTABLE_ROTL64(htable_load_word(key) * HTABLE_WORD_HASH_M2, 31) * HTABLE_WORD_HASH_M1;
+        hash = HTABLE_ROTL64(hash, 27) * 5 + 0x52DCE729;
+        key += 8;
+        key_len -= 8;
+    }
+
+    if (key_len)
+        hash ^= HTABLE_ROTL64(htable_load_tail(key, key_len) * HTABLE_WORD_HASH_M2, 31) * HTABLE_WORD_HASH_M1;
+
+    return (uint32_t)htable_fmix64(hash);
+}
+
+/**
+ * Jenkins hash function. The seed is the initial hash value.
+ * see: https://en.wikipedia.org/wiki/Jenkins_hash_function
+ */
+static inline uint32_t htable_jenkins_hash(const uint8_t *key, size_t key_len, uint64_t seed)
+{
+    size_t i = 0;
+    uint32_t hash = (uint32_t)seed;
+
+    while (i != key_len)
+    {
+        hash += key[i++];
+        hash += hash << 10;
+        hash ^= hash >> 6;
+    }
+
+    hash += hash << 3;
+    hash ^= hash >> 11;
+    hash += hash << 15;
+    return hash;
+}
+
+/**
+ * True if htable_crc32c_hash can be called on this CPU.
+ */
+static inline bool htable_crc32c_supported(void)
+{
+#ifdef HTABLE_HAVE_CRC32C
+    return __builtin_cpu_supports("sse4.2");
+#else
+    return false;
+#endif
+}
+
+#ifdef HTABLE_HAVE_CRC32C
+/**
+ * CRC32C hash function (SSE4.2 crc32 instruction, 8 bytes per instruction).
+ * CRC bits are mixed at the end because Swiss layout uses low bits of hash as fingerprint.
+ * Call it only if htable_crc32c_supported() is true.
+ */
+__attribute__((target("sse4.2")))
+static inline uint32_t htable_crc32c_hash(const uint8_t *key, size_t key_len, uint64_t seed)
+{
+    uint64_t crc = (uint32_t)(seed ^ (seed >> 32));
+    crc = _mm_crc32_u64(crc, key_len);
+
+    while (key_len >= 8)
+    {
+        crc = _mm_crc32_u64(crc, htable_load_word(key));
+        key += 8;
+        key_len -= 8;
+    }
+
+    if (key_len)
+        crc = _mm_crc32_u64(crc, htable_load_tail(key, key_len));
+
+    uint32_t hash = (uint32_t)crc;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 13;
+    return hash;
+}
+#endif
+
+#endif // _H_TABLE_HASH_H
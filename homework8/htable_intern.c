@@ -0,0 +1,161 @@
+#include <stdlib.h>
+
+#include "htable.h"
+#include "htable_intern.h"
+
+#define CHECK_AND_EXIT_WITH_VAL_IF(cond, v)       if (cond)  return v;
+#define CHECK_AND_EXIT_IF(cond)                   if (cond)  return;
+
+#define INTERN_MIN_IDS 64
+#define INTERN_BATCH 64  // Strings looked up by one htable_find_batch call
+
+typedef struct
+{
+    htable_item_base_t base;
+    uint32_t id;
+} intern_item_t;
+
+struct htable_intern_t
+{
+    htable_t *ht;               // Items and strings are in its arena
+    const intern_item_t **by_id;
+    size_t count;
+    size_t capacity;            // Of by_id
+};
+
+static const uint8_t empty_string[1];
+
+/**
+ * Item for lookup of str, empty string may be NULL but the table needs a key pointer.
+ */
+static inline intern_item_t lookup_item(const uint8_t *str, size_t len)
+{
+    intern_item_t item = {{(uint8_t*)((str) ? str : empty_string), len, 0}, HTABLE_INTERN_NONE};
+    return item;
+}
+
+htable_intern_t *htable_intern_make(size_t init_len)
+{
+    htable_intern_t *in = malloc(sizeof(htable_intern_t));
+    CHECK_AND_EXIT_WITH_VAL_IF(!in, NULL)
+
+    htable_options_t options = {init_len, NULL, HTABLE_OPT_ARENA | HTABLE_OPT_SWISS | HTABLE_OPT_RANDOM_SEED,
+                                HTABLE_HASH_WORD, 0};
+    in->capacity = (init_len > INTERN_MIN_IDS) ? init_len : INTERN_MIN_IDS;
+    in->ht = htable_make_ex(&options);
+    in->by_id = malloc(in->capacity * sizeof(intern_item_t*));
+    if (!in->ht || !in->by_id)
+    {
+        htable_destroy(in->ht);
+        free(in->by_id);
+        free(in);
+        return NULL;
+    }
+    in->count = 0;
+    return in;
+}
+
+void htable_intern_destroy(htable_intern_t *in)
+{
+    CHECK_AND_EXIT_IF(!in)
+    htable_destroy(in->ht);
+    free(in->by_id);
+    free(in);
+}
+
+uint32_t htable_intern(htable_intern_t *in, const uint8_t *str, size_t len)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!in, HTABLE_INTERN_NONE)
+    CHECK_AND_EXIT_WITH_VAL_IF(!str && len, HTABLE_INTERN_NONE)
+
+    // All IDs are taken: strings interned already still have theirs
+    if (in->count >= HTABLE_INTERN_NONE)
+        return htable_intern_find(in, str, len);
+
+    // Room for the next ID is made first: a string is never added without its ID
+    if (in->count == in->capacity)
+    {
+        size_t capacity = in->capacity << 1;
+        const intern_item_t **by_id = realloc(in->by_id, capacity * sizeof(intern_item_t*));
+        CHECK_AND_EXIT_WITH_VAL_IF(!by_id, HTABLE_INTERN_NONE)
+        in->by_id = by_id;
+        in->capacity = capacity;
+    }
+
+    bool inserted;
+    intern_item_t item = lookup_item(str, len);
+    intern_item_t *stored = (intern_item_t*)htable_upsert(in->ht, &item.base, sizeof(item), &inserted);
+    CHECK_AND_EXIT_WITH_VAL_IF(!stored, HTABLE_INTERN_NONE)
+    if (inserted)
+    {
+        stored->id = (uint32_t)in->count;
+        in->by_id[in->count++] = stored;
+    }
+    return stored->id;
+}
+
+size_t htable_intern_bulk(htable_intern_t *in, const uint8_t * const *strs, const size_t *lens, size_t count,
+                          uint32_t *ids)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!in || !strs || !lens || !ids, 0)
+
+    intern_item_t items[INTERN_BATCH];
+    const htable_item_base_t *batch_items[INTERN_BATCH];
+    htable_item_base_t *found[INTERN_BATCH];
+    size_t batch;
+
+    for (size_t first = 0; first < count; first += batch)
+    {
+        batch = (count - first < INTERN_BATCH) ? count - first : INTERN_BATCH;
+        for (size_t i = 0; i < batch; i++)
+        {
+            // Strings before NULL string with length are interned, the rest are not
+            if (!strs[first + i] && lens[first + i])
+            {
+                count = first + i;
+                batch = i;
+                break;
+            }
+            items[i] = lookup_item(strs[first + i], lens[first + i]);
+            batch_items[i] = &items[i].base;
+        }
+        htable_find_batch(in->ht, batch_items, batch, found);
+
+        // Misses are added one by one, a string repeated in the batch is found by its second upsert
+        for (size_t i = 0; i < batch; i++)
+        {
+            if (found[i])
+                ids[first + i] = ((intern_item_t*)found[i])->id;
+            else
+                ids[first + i] = htable_intern(in, strs[first + i], lens[first + i]);
+            CHECK_AND_EXIT_WITH_VAL_IF(ids[first + i] == HTABLE_INTERN_NONE, first + i)
+        }
+    }
+    return count;
+}
+
+uint32_t htable_intern_find(htable_intern_t *in, const uint8_t *str, size_t len)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!in, HTABLE_INTERN_NONE)
+    CHECK_AND_EXIT_WITH_VAL_IF(!str && len, HTABLE_INTERN_NONE)
+
+    htable_item_base_t *found;
+    intern_item_t item = lookup_item(str, len);
+    CHECK_AND_EXIT_WITH_VAL_IF(!htable_find(in->ht, &item.base, &found), HTABLE_INTERN_NONE)
+    return ((intern_item_t*)found)->id;
+}
+
+const uint8_t *htable_intern_lookup(const htable_intern_t *in, uint32_t id, size_t *len)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!in, NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF(id >= in->count, NULL)
+    if (len)
+        *len = in->by_id[id]->base.key_len;
+    return in->by_id[id]->base.key;
+}
+
+size_t htable_intern_count(const htable_intern_t *in)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!in, 0)
+    return in->count;
+}
@@ -0,0 +1,109 @@
+#ifndef _H_TABLE_INTERN_H
+#define _H_TABLE_INTERN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define HTABLE_INTERN_NONE UINT32_MAX  // Returned instead of ID if string isn't interned
+
+typedef struct htable_intern_t htable_intern_t;
+
+/**
+ *   Make a string interner
+ *
+ *   \param [in] init_len - The initial number of distinct strings
+ *
+ *   \return It returns pointer to the instance of interner or NULL if error happened
+ *
+ *   \details Every distinct byte string gets a dense 32-bit ID: 0, 1, 2, ... in order of the first
+ *   intern call, so structures can keep 4-byte IDs instead of strings and compare them as integers,
+ *   and arrays indexed by ID can replace maps keyed by string. Strings are copied once into the
+ *   append-only arena of the underlying htable_t (Swiss layout, random seed), they are never moved
+ *   or released until htable_intern_destroy, so pointers returned by htable_intern_lookup stay valid.
+ *   ID to string is one array access. Strings can't be removed.
+ */
+htable_intern_t *htable_intern_make(size_t init_len);
+
+/**
+ *  Destroy the interner with all its strings
+ *
+ *  \param [in] in - The instance of interner
+ */
+void htable_intern_destroy(htable_intern_t *in);
+
+/**
+ *  Get ID of string, the string is added if it isn't interned yet
+ *
+ *  \param [in] in - The instance of interner
+ *
+ *  \param [in] str - The string (bytes, it may contain zeros; NULL is allowed for empty string)
+ *
+ *  \param [in] len - The length of string
+ *
+ *  \return It returns ID of string or HTABLE_INTERN_NONE if memory can't be allocated or there are
+ *  already HTABLE_INTERN_NONE strings.
+ */
+uint32_t htable_intern(htable_intern_t *in, const uint8_t *str, size_t len);
+
+/**
+ *  Get IDs of many strings, strings which aren't interned yet are added
+ *
+ *  \param [in] in - The instance of interner
+ *
+ *  \param [in] strs - The array of strings
+ *
+ *  \param [in] lens - The array of their lengths
+ *
+ *  \param [in] count - The number of strings
+ *
+ *  \param [out] ids - The array where IDs are returned
+ *
+ *  \return It returns the number of strings interned: it is less than count only if error happened
+ *  (memory can't be allocated, all IDs are taken or the string is NULL with non-zero length),
+ *  IDs of strings after it are not set.
+ *
+ *  \details Strings which are interned already are looked up by htable_find_batch in groups,
+ *  so cache misses of their lookups overlap. It pays off for streams where most strings repeat
+ *  (tokens, field names, URLs).
+ */
+size_t htable_intern_bulk(htable_intern_t *in, const uint8_t * const *strs, const size_t *lens, size_t count,
+                          uint32_t *ids);
+
+/**
+ *  Get ID of string without adding it
+ *
+ *  \param [in] in - The instance of interner
+ *
+ *  \param [in] str - The string
+ *
+ *  \param [in] len - The length of string
+ *
+ *  \return It returns ID of string or HTABLE_INTERN_NONE if string isn't interned.
+ */
+uint32_t htable_intern_find(htable_intern_t *in, const uint8_t *str, size_t len);
+
+/**
+ *  Get string by ID
+ *
+ *  \param [in] in - The instance of interner
+ *
+ *  \param [in] id - The ID
+ *
+ *  \param [out] len - The pointer where length of string is returned (can be NULL)
+ *
+ *  \return It returns pointer to the string (not zero-terminated, valid until htable_intern_destroy)
+ *  or NULL if there is no such ID.
+ */
+const uint8_t *htable_intern_lookup(const htable_intern_t *in, uint32_t id, size_t *len);
+
+/**
+ *  Get the number of interned strings (the next ID)
+ *
+ *  \param [in] in - The instance of interner
+ *
+ *  \return It returns the number of strings.
+ */
+size_t htable_intern_count(const htable_intern_t *in);
+
+#endif // _H_TABLE_INTERN_H
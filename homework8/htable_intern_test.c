@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "htable_intern.h"
+#include "htable_test_system.h"
+
+/// TEST CASES
+#define KEYS_COUNT 10000
+
+static char keys[KEYS_COUNT][TEST_KEY_SIZE];
+
+static bool equal(const uint8_t *str, size_t len, const char *expected, size_t expected_len)
+{
+    return str && len == expected_len && !memcmp(str, expected, len);
+}
+
+char *test_wrong_params()
+{
+    htable_intern_t *in = htable_intern_make(0);
+    uint32_t id;
+    const uint8_t *str = (const uint8_t*)"key";
+    size_t len = 3;
+    ASSERTION(in != NULL, "Expected: Interner was created!")
+    ASSERTION(htable_intern(NULL, str, 3) == HTABLE_INTERN_NONE, "Expected: HTABLE_INTERN_NONE!")
+    ASSERTION(htable_intern(in, NULL, 3) == HTABLE_INTERN_NONE, "Expected: HTABLE_INTERN_NONE!")
+    ASSERTION(htable_intern_find(NULL, str, 3) == HTABLE_INTERN_NONE, "Expected: HTABLE_INTERN_NONE!")
+    ASSERTION(htable_intern_find(in, NULL, 3) == HTABLE_INTERN_NONE, "Expected: HTABLE_INTERN_NONE!")
+    ASSERTION(htable_intern_bulk(NULL, &str, &len, 1, &id) == 0, "Expected: 0!")
+    ASSERTION(htable_intern_bulk(in, NULL, &len, 1, &id) == 0, "Expected: 0!")
+    ASSERTION(htable_intern_bulk(in, &str, NULL, 1, &id) == 0, "Expected: 0!")
+    ASSERTION(htable_intern_bulk(in, &str, &len, 1, NULL) == 0, "Expected: 0!")
+    ASSERTION(htable_intern_lookup(NULL, 0, NULL) == NULL, "Expected: NULL!")
+    ASSERTION(htable_intern_lookup(in, 0, NULL) == NULL, "Expected: No ID yet!")
+    ASSERTION(htable_intern_count(NULL) == 0, "Expected: 0!")
+    ASSERTION(htable_intern_count(in) == 0, "Expected: Nothing was interned!")
+    htable_intern_destroy(NULL);
+    htable_intern_destroy(in);
+    return NULL;
+}
+
+char *test_functional()
+{
+    htable_intern_t *in = htable_intern_make(0);
+    const uint8_t *first[KEYS_COUNT];
+    const uint8_t *str;
+    size_t len;
+    ASSERTION(in != NULL, "Expected: Interner was created!")
+
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        ASSERTION(htable_intern_find(in, (uint8_t*)keys[i], strlen(keys[i])) == HTABLE_INTERN_NONE,
+                  "Expected: String is not interned yet!")
+        ASSERTION(htable_intern(in, (uint8_t*)keys[i], strlen(keys[i])) == i, "Expected: IDs are dense!")
+        first[i] = htable_intern_lookup(in, (uint32_t)i, NULL);
+        ASSERTION(first[i] != (uint8_t*)keys[i], "Expected: String was copied!")
+    }
+    ASSERTION(htable_intern_count(in) == KEYS_COUNT, "Expected: All strings were interned!")
+
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        ASSERTION(htable_intern(in, (uint8_t*)keys[i], strlen(keys[i])) == i, "Expected: The same ID!")
+        ASSERTION(htable_intern_find(in, (uint8_t*)keys[i], strlen(keys[i])) == i, "Expected: String was found!")
+        str = htable_intern_lookup(in, (uint32_t)i, &len);
+        ASSERTION(equal(str, len, keys[i], strlen(keys[i])), "Expected: String of ID!")
+        ASSERTION(str == first[i], "Expected: String wasn't moved by growth!")
+    }
+    ASSERTION(htable_intern_count(in) == KEYS_COUNT, "Expected: Nothing was added!")
+    ASSERTION(htable_intern_lookup(in, KEYS_COUNT, &len) == NULL, "Expected: NULL!")
+    htable_intern_destroy(in);
+    return NULL;
+}
+
+char *test_special_strings()
+{
+    htable_intern_t *in = htable_intern_make(4);
+    const uint8_t binary[5] = {'a', 0, 'b', 0, 0};
+    size_t len = 1;
+    ASSERTION(in != NULL, "Expected: Interner was created!")
+
+    uint32_t empty = htable_intern(in, NULL, 0);
+    ASSERTION(empty == 0, "Expected: Empty string was interned!")
+    ASSERTION(htable_intern(in, (uint8_t*)"", 0) == empty, "Expected: Empty string is the same!")
+    ASSERTION(htable_intern_lookup(in, empty, &len) != NULL && len == 0, "Expected: Empty string of ID!")
+
+    // Strings differing only after zero bytes or by trailing zeros are different
+    for (size_t i = 1; i <= 5; i++)
+        ASSERTION(htable_intern(in, binary, i) == i, "Expected: Prefix is another string!")
+    for (size_t i = 1; i <= 5; i++)
+    {
+        const uint8_t *str = htable_intern_lookup(in, (uint32_t)i, &len);
+        ASSERTION(equal(str, len, (char*)binary, i), "Expected: Binary string!")
+    }
+    ASSERTION(htable_intern_count(in) == 6, "Expected: 6 strings!")
+    htable_intern_destroy(in);
+    return NULL;
+}
+
+char *test_bulk()
+{
+    htable_intern_t *in = htable_intern_make(0);
+    static const uint8_t *strs[3 * KEYS_COUNT];
+    static size_t lens[3 * KEYS_COUNT];
+    static uint32_t ids[3 * KEYS_COUNT];
+    ASSERTION(in != NULL, "Expected: Interner was created!")
+
+    // Every string comes three times: twice next to each other (the same batch), once much later
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        strs[2 * i] = strs[2 * i + 1] = strs[2 * KEYS_COUNT + i] = (uint8_t*)keys[i];
+        lens[2 * i] = lens[2 * i + 1] = lens[2 * KEYS_COUNT + i] = strlen(keys[i]);
+    }
+    ASSERTION(htable_intern_bulk(in, strs, lens, 0, ids) == 0, "Expected: Nothing to intern!")
+    ASSERTION(htable_intern_bulk(in, strs, lens, 3 * KEYS_COUNT, ids) == 3 * KEYS_COUNT, "Expected: All strings!")
+    ASSERTION(htable_intern_count(in) == KEYS_COUNT, "Expected: Repeated strings were interned once!")
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        ASSERTION(ids[2 * i] == i && ids[2 * i + 1] == i, "Expected: IDs in order of the first occurrence!")
+        ASSERTION(ids[2 * KEYS_COUNT + i] == i, "Expected: ID of interned string!")
+    }
+    htable_intern_destroy(in);
+    return NULL;
+}
+
+char *test_bulk_invalid()
+{
+    htable_intern_t *in = htable_intern_make(0);
+    const uint8_t *strs[3] = {(uint8_t*)"abc", NULL, (uint8_t*)"def"};
+    const size_t lens[3] = {3, 40, 3};
+    uint32_t ids[3] = {0, HTABLE_INTERN_NONE, HTABLE_INTERN_NONE};
+    ASSERTION(in != NULL, "Expected: Interner was created!")
+
+    ASSERTION(htable_intern_bulk(in, strs, lens, 3, ids) == 1, "Expected: Stopped at NULL string with length!")
+    ASSERTION(ids[0] == 0 && ids[1] == HTABLE_INTERN_NONE && ids[2] == HTABLE_INTERN_NONE, "Expected: One ID!")
+    ASSERTION(htable_intern_count(in) == 1, "Expected: Strings after it were not interned!")
+    htable_intern_destroy(in);
+    return NULL;
+}
+
+int main(void)
+{
+    make_test_keys(keys, KEYS_COUNT, "");
+
+    struct test_case test_cases[] = {
+        {"Test intern wrong params", test_wrong_params},
+        {"Test intern functional", test_functional},
+        {"Test intern special strings", test_special_strings},
+        {"Test intern bulk", test_bulk},
+        {"Test intern bulk invalid string", test_bulk_invalid},
+        {0, 0},
+    };
+
+    return run_tests(test_cases);
+}
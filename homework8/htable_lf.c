@@ -0,0 +1,450 @@
+#define _POSIX_C_SOURCE 200809L
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "htable_lf.h"
+#include "htable_hash.h"
+
+#define CHECK_AND_EXIT_WITH_VAL_IF(cond, v)       if (cond)  return v;
+#define CHECK_AND_EXIT_IF(cond)                   if (cond)  return;
+
+#define CACHE_LINE_SIZE 64
+#define RECLAIM_THRESHOLD 64        // Writer tries to release retired items when so many are waiting
+#define EPOCH_IDLE UINT64_MAX       // Epoch of reader out of read section
+
+/**
+ * Slot array. Readers load item pointer (acquire), then hash of the slot. The writer stores hash
+ * before item (release), so a reader that sees an item sees its hash as well.
+ */
+typedef struct
+{
+    size_t capacity;
+    _Atomic uint32_t *hashes;       // Follows items in the same allocation
+    _Atomic(htable_item_base_t*) items[];
+} lf_slots_t;
+
+typedef struct
+{
+    void *ptr;
+    uint64_t epoch;                 // Global epoch when ptr was unlinked
+    bool is_slots;
+} retired_t;
+
+// Every reader takes whole cache lines, so readers don't share lines with each other
+struct htable_lf_reader_t
+{
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t epoch;
+    atomic_bool in_use;
+    htable_lf_t *lf;
+    htable_lf_reader_t *next;
+};
+
+struct htable_lf_t
+{
+    _Atomic(lf_slots_t*) slots;
+    _Atomic uint64_t epoch;
+    _Atomic(htable_lf_reader_t*) readers;
+    hash_func_t hash_func;          // User's hash function or NULL
+    uint32_t hash;                  // Built-in hash function (HTABLE_HASH_*), used if hash_func is NULL
+    uint64_t seed;                  // Seed of built-in hash function
+    size_t items_count;             // Fields below are used by the writer only
+    size_t deleted_count;
+    item_destructor_t item_destructor;
+    retired_t *retired;
+    size_t retired_count;
+    size_t retired_capacity;
+};
+
+// We use address of this for marking items as deleted
+static htable_item_base_t lf_deleted__;
+static htable_item_base_t * const lf_marked_as_deleted = &lf_deleted__;
+
+static void default_item_destructor(htable_item_base_t *item)
+{
+    free(item);
+}
+
+static lf_slots_t *alloc_slots(size_t capacity)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(capacity > (SIZE_MAX - sizeof(lf_slots_t)) / (sizeof(void*) + sizeof(uint32_t)), NULL)
+    lf_slots_t *slots = calloc(1, sizeof(lf_slots_t) + capacity * (sizeof(void*) + sizeof(uint32_t)));
+    CHECK_AND_EXIT_WITH_VAL_IF(!slots, NULL)
+    slots->capacity = capacity;
+    slots->hashes = (_Atomic uint32_t*)(slots->items + capacity);
+    return slots;
+}
+
+static uint32_t hash_key(const htable_lf_t *lf, const uint8_t *key, size_t key_len)
+{
+    if (lf->hash_func)
+        return lf->hash_func(key, key_len);
+    switch (lf->hash)
+    {
+#ifdef HTABLE_HAVE_CRC32C
+    case HTABLE_HASH_CRC32C:
+        return htable_crc32c_hash(key, key_len, lf->seed);
+#endif
+    case HTABLE_HASH_JENKINS:
+        return htable_jenkins_hash(key, key_len, lf->seed);
+    default:
+        return htable_word_hash(key, key_len, lf->seed);
+    }
+}
+
+static bool compare_items_key(const htable_item_base_t *item_first, const htable_item_base_t *item_second)
+{
+    return item_first->key_len == item_second->key_len &&
+           0 == memcmp(item_first->key, item_second->key, item_first->key_len);
+}
+
+/**
+ * Minimal epoch of readers in read sections (EPOCH_IDLE if there are no such readers).
+ */
+static uint64_t min_reader_epoch(htable_lf_t *lf)
+{
+    uint64_t min_epoch = EPOCH_IDLE, epoch;
+    htable_lf_reader_t *reader = atomic_load(&lf->readers);
+    for (; reader; reader = reader->next)
+    {
+        epoch = atomic_load(&reader->epoch);
+        if (epoch < min_epoch)
+            min_epoch = epoch;
+    }
+    return min_epoch;
+}
+
+static void release(htable_lf_t *lf, retired_t *retired)
+{
+    if (retired->is_slots)
+        free(retired->ptr);
+    else
+        lf->item_destructor(retired->ptr);
+}
+
+/**
+ * Readers entered read section before ptr was unlinked have epoch <= current one. When there is no
+ * place in the retired list we wait for them and release ptr at once.
+ */
+static void retire(htable_lf_t *lf, void *ptr, bool is_slots)
+{
+    retired_t retired = {ptr, atomic_load(&lf->epoch), is_slots};
+
+    if (lf->retired_count == lf->retired_capacity)
+    {
+        size_t new_capacity = lf->retired_capacity ? lf->retired_capacity << 1 : RECLAIM_THRESHOLD;
+        retired_t *new_retired = realloc(lf->retired, new_capacity * sizeof(retired_t));
+        if (!new_retired)
+        {
+            atomic_fetch_add(&lf->epoch, 1);
+            atomic_thread_fence(memory_order_seq_cst);
+            while (min_reader_epoch(lf) <= retired.epoch)
+                sched_yield();
+            release(lf, &retired);
+            return;
+        }
+        lf->retired = new_retired;
+        lf->retired_capacity = new_capacity;
+    }
+    lf->retired[lf->retired_count++] = retired;
+}
+
+size_t htable_lf_reclaim(htable_lf_t *lf)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!lf, 0)
+
+    // Readers entering read section from now on can't see retired items
+    atomic_fetch_add(&lf->epoch, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t min_epoch = min_reader_epoch(lf);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < lf->retired_count; i++)
+    {
+        if (lf->retired[i].epoch < min_epoch)
+            release(lf, &lf->retired[i]);
+        else
+            lf->retired[kept++] = lf->retired[i];
+    }
+    lf->retired_count = kept;
+    return kept;
+}
+
+htable_lf_t *htable_lf_make(const htable_options_t *options)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!options, NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF(options->flags & ~HTABLE_OPT_RANDOM_SEED, NULL)
+
+    htable_lf_t *lf = malloc(sizeof(htable_lf_t));
+    CHECK_AND_EXIT_WITH_VAL_IF(!lf, NULL)
+
+    lf_slots_t *slots = alloc_slots((options->init_len < 8) ? 8 : options->init_len);
+    if (!slots)
+    {
+        free(lf);
+        return NULL;
+    }
+
+    // The same hash function and seed as htable_make_ex chooses
+    lf->hash_func = options->hash_func;
+    lf->hash = options->hash;
+    if (lf->hash == HTABLE_HASH_CRC32C && !htable_crc32c_supported())
+        lf->hash = HTABLE_HASH_WORD;
+    lf->seed = (options->flags & HTABLE_OPT_RANDOM_SEED) ? htable_random_seed() : options->seed;
+
+    atomic_init(&lf->slots, slots);
+    atomic_init(&lf->epoch, 0);
+    atomic_init(&lf->readers, NULL);
+    lf->items_count = 0;
+    lf->deleted_count = 0;
+    lf->item_destructor = default_item_destructor;
+    lf->retired = NULL;
+    lf->retired_count = 0;
+    lf->retired_capacity = 0;
+    return lf;
+}
+
+void htable_lf_destroy(htable_lf_t *lf)
+{
+    CHECK_AND_EXIT_IF(!lf)
+
+    for (size_t i = 0; i < lf->retired_count; i++)
+        release(lf, &lf->retired[i]);
+    free(lf->retired);
+
+    lf_slots_t *slots = atomic_load(&lf->slots);
+    htable_item_base_t *item;
+    for (size_t i = 0; i < slots->capacity; i++)
+    {
+        item = atomic_load_explicit(&slots->items[i], memory_order_relaxed);
+        if (item && item != lf_marked_as_deleted)
+            lf->item_destructor(item);
+    }
+    free(slots);
+
+    htable_lf_reader_t *reader = atomic_load(&lf->readers), *next;
+    for (; reader; reader = next)
+    {
+        next = reader->next;
+        free(reader);
+    }
+    free(lf);
+}
+
+htable_lf_reader_t *htable_lf_reader_register(htable_lf_t *lf)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!lf, NULL)
+    htable_lf_reader_t *reader = atomic_load(&lf->readers);
+    bool in_use;
+
+    for (; reader; reader = reader->next)
+    {
+        in_use = false;
+        if (atomic_compare_exchange_strong(&reader->in_use, &in_use, true))
+            return reader;
+    }
+
+    reader = aligned_alloc(CACHE_LINE_SIZE, sizeof(htable_lf_reader_t));
+    CHECK_AND_EXIT_WITH_VAL_IF(!reader, NULL)
+    atomic_init(&reader->epoch, EPOCH_IDLE);
+    atomic_init(&reader->in_use, true);
+    reader->lf = lf;
+
+    // Readers are never unlinked until htable_lf_destroy, so plain CAS push is safe
+    reader->next = atomic_load(&lf->readers);
+    while (!atomic_compare_exchange_weak(&lf->readers, &reader->next, reader))
+        ;
+    return reader;
+}
+
+void htable_lf_reader_unregister(htable_lf_reader_t *reader)
+{
+    CHECK_AND_EXIT_IF(!reader)
+    atomic_store(&reader->epoch, EPOCH_IDLE);
+    atomic_store(&reader->in_use, false);
+}
+
+void htable_lf_read_lock(htable_lf_reader_t *reader)
+{
+    // The fence pairs with the one in htable_lf_reclaim: the writer either sees our epoch
+    // or we see pointers it has unlinked before scanning readers
+    atomic_store(&reader->epoch, atomic_load(&reader->lf->epoch));
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void htable_lf_read_unlock(htable_lf_reader_t *reader)
+{
+    atomic_store_explicit(&reader->epoch, EPOCH_IDLE, memory_order_release);
+}
+
+/**
+ * Linear probing. Returns the item with the same key and its index, or NULL and index of the first
+ * empty (or deleted) slot if there is no such item.
+ */
+static htable_item_base_t *find_slot(lf_slots_t *slots, const htable_item_base_t *item, uint32_t hash,
+                                     size_t *out_index)
+{
+    size_t index = hash % slots->capacity;
+    size_t free_index = SIZE_MAX;
+    htable_item_base_t *current;
+
+    for (size_t i = 0; i < slots->capacity; i++)
+    {
+        current = atomic_load_explicit(&slots->items[index], memory_order_acquire);
+        if (!current)
+            break;
+
+        if (current == lf_marked_as_deleted)
+        {
+            if (free_index == SIZE_MAX)
+                free_index = index;
+        }
+        else if (atomic_load_explicit(&slots->hashes[index], memory_order_relaxed) == hash &&
+                 compare_items_key(current, item))
+        {
+            *out_index = index;
+            return current;
+        }
+        index = (index + 1) % slots->capacity;
+    }
+
+    *out_index = (free_index != SIZE_MAX) ? free_index : index;
+    return NULL;
+}
+
+bool htable_lf_find(htable_lf_t *lf, const htable_item_base_t *item, const htable_item_base_t **out_item)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!lf || !item || !item->key, false)
+    uint32_t hash = hash_key(lf, item->key, item->key_len);
+    lf_slots_t *slots = atomic_load_explicit(&lf->slots, memory_order_acquire);
+    size_t index;
+
+    const htable_item_base_t *found = find_slot(slots, item, hash, &index);
+    if (found && out_item)
+        *out_item = found;
+    return found != NULL;
+}
+
+/**
+ * Build new slot array without deleted marks and publish it. Readers still walking the old
+ * array see all items, the old array is retired.
+ */
+static bool grow(htable_lf_t *lf)
+{
+    lf_slots_t *slots = atomic_load_explicit(&lf->slots, memory_order_relaxed);
+    size_t new_capacity = slots->capacity;
+    if (lf->deleted_count <= lf->items_count)
+    {
+        CHECK_AND_EXIT_WITH_VAL_IF(new_capacity > SIZE_MAX >> 1, false)
+        new_capacity <<= 1;
+    }
+
+    lf_slots_t *new_slots = alloc_slots(new_capacity);
+    CHECK_AND_EXIT_WITH_VAL_IF(!new_slots, false)
+
+    htable_item_base_t *item;
+    uint32_t hash;
+    size_t index;
+    for (size_t i = 0; i < slots->capacity; i++)
+    {
+        item = atomic_load_explicit(&slots->items[i], memory_order_relaxed);
+        if (!item || item == lf_marked_as_deleted)
+            continue;
+
+        hash = atomic_load_explicit(&slots->hashes[i], memory_order_relaxed);
+        index = hash % new_capacity;
+        while (atomic_load_explicit(&new_slots->items[index], memory_order_relaxed))
+            index = (index + 1) % new_capacity;
+        atomic_store_explicit(&new_slots->hashes[index], hash, memory_order_relaxed);
+        atomic_store_explicit(&new_slots->items[index], item, memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&lf->slots, new_slots, memory_order_release);
+    lf->deleted_count = 0;
+    retire(lf, slots, true);
+    return true;
+}
+
+htable_status_t htable_lf_set(htable_lf_t *lf, const htable_item_base_t *item, size_t item_size)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!lf || !item || !item->key, HTABLE_UNKNOWN)
+    CHECK_AND_EXIT_WITH_VAL_IF(item_size < sizeof(htable_item_base_t), HTABLE_UNKNOWN)
+
+    lf_slots_t *slots = atomic_load_explicit(&lf->slots, memory_order_relaxed);
+    if ((lf->items_count + lf->deleted_count + 1) << 1 > slots->capacity)
+    {
+        CHECK_AND_EXIT_WITH_VAL_IF(!grow(lf), HTABLE_MEM_ERROR)
+        slots = atomic_load_explicit(&lf->slots, memory_order_relaxed);
+    }
+
+    // Items are immutable after publication, so a new copy is made even if the key exists
+    htable_item_base_t *candidate = malloc(item_size + item->key_len);
+    CHECK_AND_EXIT_WITH_VAL_IF(!candidate, HTABLE_MEM_ERROR)
+    memcpy(candidate, item, item_size);
+    candidate->key = (uint8_t*)candidate + item_size;
+    candidate->flags = HTABLE_ITEM_INLINE_KEY;
+    memcpy(candidate->key, item->key, item->key_len);
+
+    size_t index;
+    uint32_t hash = hash_key(lf, item->key, item->key_len);
+    htable_item_base_t *found = find_slot(slots, item, hash, &index);
+    htable_item_base_t *prev = atomic_load_explicit(&slots->items[index], memory_order_relaxed);
+
+    atomic_store_explicit(&slots->hashes[index], hash, memory_order_relaxed);
+    atomic_store_explicit(&slots->items[index], candidate, memory_order_release);
+
+    if (found)
+        retire(lf, found, false);
+    else
+        lf->items_count++;
+    if (prev == lf_marked_as_deleted)
+        lf->deleted_count--;
+
+    if (lf->retired_count >= RECLAIM_THRESHOLD)
+        htable_lf_reclaim(lf);
+    return HTABLE_OK;
+}
+
+bool htable_lf_remove(htable_lf_t *lf, const htable_item_base_t *item)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!lf || !item || !item->key, false)
+    lf_slots_t *slots = atomic_load_explicit(&lf->slots, memory_order_relaxed);
+    uint32_t hash = hash_key(lf, item->key, item->key_len);
+    size_t index;
+
+    htable_item_base_t *found = find_slot(slots, item, hash, &index);
+    CHECK_AND_EXIT_WITH_VAL_IF(!found, false)
+
+    atomic_store_explicit(&slots->items[index], lf_marked_as_deleted, memory_order_release);
+    lf->items_count--;
+    lf->deleted_count++;
+    retire(lf, found, false);
+
+    if (lf->retired_count >= RECLAIM_THRESHOLD)
+        htable_lf_reclaim(lf);
+    return true;
+}
+
+void htable_lf_enumerate_items(htable_lf_t *lf, int (*callback)(const htable_item_base_t *item))
+{
+    CHECK_AND_EXIT_IF(!lf)
+    CHECK_AND_EXIT_IF(!callback)
+    lf_slots_t *slots = atomic_load_explicit(&lf->slots, memory_order_acquire);
+    htable_item_base_t *item;
+
+    for (size_t i = 0; i < slots->capacity; i++)
+    {
+        item = atomic_load_explicit(&slots->items[i], memory_order_acquire);
+        if (item && item != lf_marked_as_deleted && !callback(item))
+            break;
+    }
+}
+
+item_destructor_t htable_lf_set_item_destructor(htable_lf_t *lf, item_destructor_t new_item_destructor)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!lf, NULL)
+    item_destructor_t current_item_destructor = lf->item_destructor;
+    lf->item_destructor = (new_item_destructor) ? new_item_destructor : default_item_destructor;
+    return current_item_destructor;
+}
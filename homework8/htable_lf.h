@@ -0,0 +1,151 @@
+#ifndef _H_TABLE_LF_H
+#define _H_TABLE_LF_H
+
+#include "htable.h"
+
+typedef struct htable_lf_t htable_lf_t;
+typedef struct htable_lf_reader_t htable_lf_reader_t;
+
+/**
+ *   Make a hash table with lock-free readers and a single writer
+ *
+ *   \param [in] options - The pointer to options of hash table
+ *
+ *   \return It returns pointer to the instance of hash table or NULL if error happened
+ *
+ *   \details Readers never take a lock: slots are published with atomic stores, items are never
+ *   changed after they are published, and the slot array is replaced at once when it grows.
+ *   Items replaced or removed by the writer (and old slot arrays) are retired and released only
+ *   after every reader has left the read section it could see them in (epoch-based reclamation).
+ *   Only init_len, hash_func, hash, seed and HTABLE_OPT_RANDOM_SEED flag of options are used,
+ *   other flags make NULL returned. Keys are always stored inline (HTABLE_ITEM_INLINE_KEY).
+ */
+htable_lf_t *htable_lf_make(const htable_options_t *options);
+
+/**
+ *  Destroy the hash table
+ *
+ *  \param [in] lf - The instance of hash table
+ *
+ *  \details It must not be called while readers are in read sections. Registered readers are released.
+ */
+void htable_lf_destroy(htable_lf_t *lf);
+
+/**
+ *  Register reader
+ *
+ *  \param [in] lf - The instance of hash table
+ *
+ *  \return It returns reader handle or NULL if error happened
+ *
+ *  \details Every reading thread needs its own handle. It can be called from any thread.
+ */
+htable_lf_reader_t *htable_lf_reader_register(htable_lf_t *lf);
+
+/**
+ *  Unregister reader
+ *
+ *  \param [in] reader - The reader handle
+ *
+ *  \details The handle is reused by the next htable_lf_reader_register call.
+ */
+void htable_lf_reader_unregister(htable_lf_reader_t *reader);
+
+/**
+ *  Enter read section
+ *
+ *  \param [in] reader - The reader handle
+ *
+ *  \details Items found in read section stay valid until htable_lf_read_unlock is called.
+ *  Read sections should be short, retired items are not released while any reader stays in one.
+ */
+void htable_lf_read_lock(htable_lf_reader_t *reader);
+
+/**
+ *  Leave read section
+ *
+ *  \param [in] reader - The reader handle
+ */
+void htable_lf_read_unlock(htable_lf_reader_t *reader);
+
+/**
+ *  Find and return item (reader side)
+ *
+ *  \param [in] lf - The instance of hash table
+ *
+ *  \param [in] item - Pointer to a htable_item_base_t structure (or compatible)
+ *
+ *  \param [out] out_item - The pointer where the pointer to item will be returned (can be NULL)
+ *
+ *  \return  It returns true if key has been found in hash table or false if it isn't so.
+ *
+ *  \details It must be called in read section or by the writer. The returned item must not be changed.
+ */
+bool htable_lf_find(htable_lf_t *lf, const htable_item_base_t *item, const htable_item_base_t **out_item);
+
+/**
+ *  Insert item into the hash table (writer side)
+ *
+ *  \param [in] lf - The instance of hash table
+ *
+ *  \param [in] item - Pointer to a htable_item_base_t structure (or compatible structure)
+ *
+ *  \param [in] item_size - Size of item
+ *
+ *  \return It returns HTABLE_OK or error code (one of values of htable_status_t).
+ *
+ *  \details See htable_set. Previous item with the same key is retired, not destroyed at once.
+ *  Only one thread at a time may call writer side functions.
+ */
+htable_status_t htable_lf_set(htable_lf_t *lf, const htable_item_base_t *item, size_t item_size);
+
+/**
+ *  Remove item from the hash table (writer side)
+ *
+ *  \param [in] lf - The instance of hash table
+ *
+ *  \param [in] item - Pointer to a htable_item_base_t structure (or compatible)
+ *
+ *  \return It returns true if key has been found in hash table or false if it isn't so.
+ *
+ *  \details The removed item is retired, not destroyed at once.
+ */
+bool htable_lf_remove(htable_lf_t *lf, const htable_item_base_t *item);
+
+/**
+ *  Release retired items which no reader can see (writer side)
+ *
+ *  \param [in] lf - The instance of hash table
+ *
+ *  \return It returns the number of items and slot arrays still waiting for readers.
+ *
+ *  \details htable_lf_set and htable_lf_remove call it when many items are retired.
+ */
+size_t htable_lf_reclaim(htable_lf_t *lf);
+
+/**
+ * Enumerate items of hash table
+ *
+ * \param [in] lf - The instance of hash table
+ *
+ * \param [in] callback - The pointer to function that will be called for each item in hash table
+ *
+ * \details It must be called in read section or by the writer. See htable_enumerate_items.
+ */
+void htable_lf_enumerate_items(htable_lf_t *lf, int (*callback)(const htable_item_base_t *item));
+
+/**
+ *  Set your own function that will be called when retired item is released.
+ *
+ *  \param [in] lf - The instance of hash table
+ *
+ *  \param [in] item_destructor - The pointer of your own item destructor
+ *
+ *  \returns This function returns pointer to item destructor set by previous call
+ *
+ *  \details See htable_set_item_destructor. Keys are inline, so only the item has to be released
+ *  (with free). Set item_destructor parameter to NULL to get back default item destructor.
+ */
+item_destructor_t htable_lf_set_item_destructor(htable_lf_t *lf, item_destructor_t new_item_destructor);
+
+#endif // _H_TABLE_LF_H
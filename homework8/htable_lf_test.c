@@ -0,0 +1,284 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "htable_lf.h"
+#include "htable_test_system.h"
+
+/// TEST CASES
+#define KEYS_COUNT 1000
+#define READERS_COUNT 4
+
+struct item
+{
+    htable_item_base_t base;
+    size_t val;
+};
+
+static char keys[KEYS_COUNT][TEST_KEY_SIZE];
+static size_t destructor_calls_count;
+static size_t enumerated_count;
+
+static void make_key(struct item *item, size_t i)
+{
+    item->base.key = (uint8_t*)keys[i];
+    item->base.key_len = strlen(keys[i]);
+    item->base.flags = 0;
+}
+
+static void counting_item_destructor(htable_item_base_t *item)
+{
+    destructor_calls_count++;
+    free(item);
+}
+
+static int enum_callback(__attribute__((unused)) const htable_item_base_t *item)
+{
+    enumerated_count++;
+    return 1;
+}
+
+char *test_make_wrong_params()
+{
+    htable_options_t options = {0, NULL, HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    ASSERTION(htable_lf_make(NULL) == NULL, "Expected: NULL!")
+    ASSERTION(htable_lf_make(&options) == NULL, "Expected: NULL!")
+    options.flags = HTABLE_OPT_SWISS;
+    ASSERTION(htable_lf_make(&options) == NULL, "Expected: NULL!")
+    return NULL;
+}
+
+char *test_wrong_params()
+{
+    htable_options_t options = {0, NULL, 0, HTABLE_HASH_WORD, 0};
+    htable_lf_t *lf = htable_lf_make(&options);
+    struct item item = {{NULL, 0, 0}, 0};
+
+    ASSERTION(htable_lf_set(NULL, &item.base, sizeof(item)) == HTABLE_UNKNOWN, "Expected: HTABLE_UNKNOWN!")
+    ASSERTION(htable_lf_set(lf, &item.base, sizeof(item)) == HTABLE_UNKNOWN, "Expected: HTABLE_UNKNOWN!")
+    make_key(&item, 0);
+    ASSERTION(htable_lf_set(lf, &item.base, 1) == HTABLE_UNKNOWN, "Expected: HTABLE_UNKNOWN!")
+    ASSERTION(!htable_lf_find(lf, NULL, NULL), "Expected: false!")
+    ASSERTION(!htable_lf_remove(lf, NULL), "Expected: false!")
+    ASSERTION(htable_lf_reader_register(NULL) == NULL, "Expected: NULL!")
+    htable_lf_enumerate_items(lf, NULL);
+    htable_lf_destroy(NULL);
+    htable_lf_destroy(lf);
+    return NULL;
+}
+
+char *test_functional()
+{
+    htable_options_t options = {0, NULL, HTABLE_OPT_RANDOM_SEED, HTABLE_HASH_WORD, 0};
+    htable_lf_t *lf = htable_lf_make(&options);
+    const htable_item_base_t *out;
+    struct item item;
+    ASSERTION(lf != NULL, "Expected: not NULL!")
+
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        make_key(&item, i);
+        item.val = i;
+        ASSERTION(htable_lf_set(lf, &item.base, sizeof(item)) == HTABLE_OK, "Expected: HTABLE_OK!")
+    }
+
+    for (size_t i = 0; i < KEYS_COUNT; i += 2)
+    {
+        make_key(&item, i);
+        ASSERTION(htable_lf_remove(lf, &item.base), "Expected: Item was removed!")
+        ASSERTION(!htable_lf_remove(lf, &item.base), "Expected: Item was not found!")
+    }
+
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        make_key(&item, i);
+        bool res = htable_lf_find(lf, &item.base, &out);
+        ASSERTION(res == (i & 1), "Expected: Only odd keys were found!")
+        ASSERTION(!res || ((struct item*)out)->val == i, "Expected: Value of item!")
+        ASSERTION(!res || out->flags == HTABLE_ITEM_INLINE_KEY, "Expected: Inline key!")
+    }
+
+    enumerated_count = 0;
+    htable_lf_enumerate_items(lf, enum_callback);
+    ASSERTION(enumerated_count == KEYS_COUNT / 2, "Expected: All items were enumerated!")
+
+    htable_lf_destroy(lf);
+    return NULL;
+}
+
+static uint32_t const_hash_func(__attribute__((unused)) const uint8_t *key, __attribute__((unused)) size_t key_len)
+{
+    return 7;
+}
+
+char *test_hash_functions()
+{
+    htable_options_t options[] = {
+        {0, NULL, 0, HTABLE_HASH_CRC32C, 1},
+        {0, NULL, 0, HTABLE_HASH_JENKINS, 1},
+        {0, const_hash_func, 0, HTABLE_HASH_WORD, 0},
+    };
+    struct item item;
+
+    for (size_t k = 0; k < sizeof(options) / sizeof(options[0]); k++)
+    {
+        htable_lf_t *lf = htable_lf_make(&options[k]);
+        ASSERTION(lf != NULL, "Expected: not NULL!")
+        for (size_t i = 0; i < KEYS_COUNT; i++)
+        {
+            make_key(&item, i);
+            item.val = i;
+            htable_lf_set(lf, &item.base, sizeof(item));
+        }
+        for (size_t i = 0; i < KEYS_COUNT; i++)
+        {
+            make_key(&item, i);
+            ASSERTION(htable_lf_find(lf, &item.base, NULL), "Expected: Item was found!")
+        }
+        htable_lf_destroy(lf);
+    }
+    return NULL;
+}
+
+char *test_reclaim()
+{
+    htable_options_t options = {0, NULL, 0, HTABLE_HASH_WORD, 0};
+    htable_lf_t *lf = htable_lf_make(&options);
+    htable_lf_set_item_destructor(lf, counting_item_destructor);
+    htable_lf_reader_t *reader = htable_lf_reader_register(lf);
+    const htable_item_base_t *out;
+    struct item item;
+    destructor_calls_count = 0;
+
+    make_key(&item, 0);
+    item.val = 1;
+    htable_lf_set(lf, &item.base, sizeof(item));
+
+    htable_lf_read_lock(reader);
+    ASSERTION(htable_lf_find(lf, &item.base, &out), "Expected: Item was found!")
+
+    item.val = 2;
+    htable_lf_set(lf, &item.base, sizeof(item));
+    ASSERTION(htable_lf_reclaim(lf) == 1, "Expected: Replaced item waits for reader!")
+    ASSERTION(destructor_calls_count == 0, "Expected: Item was not released!")
+    ASSERTION(((struct item*)out)->val == 1, "Expected: Reader sees old item!")
+
+    htable_lf_read_unlock(reader);
+    ASSERTION(htable_lf_reclaim(lf) == 0, "Expected: Nothing waits!")
+    ASSERTION(destructor_calls_count == 1, "Expected: Replaced item was released!")
+
+    // Reader entered after removal can't see the item
+    htable_lf_remove(lf, &item.base);
+    htable_lf_read_lock(reader);
+    ASSERTION(!htable_lf_find(lf, &item.base, NULL), "Expected: Item was not found!")
+    htable_lf_read_unlock(reader);
+    ASSERTION(htable_lf_reclaim(lf) == 0, "Expected: Nothing waits!")
+    ASSERTION(destructor_calls_count == 2, "Expected: Removed item was released!")
+
+    htable_lf_reader_unregister(reader);
+    ASSERTION(htable_lf_reader_register(lf) == reader, "Expected: Reader handle was reused!")
+    htable_lf_destroy(lf);
+    return NULL;
+}
+
+struct reader_ctx
+{
+    pthread_t thread;
+    htable_lf_t *lf;
+    atomic_bool *stop;
+    size_t errors;
+};
+
+static void *read_keys(void *arg)
+{
+    struct reader_ctx *ctx = arg;
+    htable_lf_reader_t *reader = htable_lf_reader_register(ctx->lf);
+    const htable_item_base_t *out;
+    struct item item;
+
+    while (!atomic_load(ctx->stop))
+    {
+        for (size_t i = 0; i < KEYS_COUNT; i++)
+        {
+            make_key(&item, i);
+            htable_lf_read_lock(reader);
+            // Even keys are never removed, values of all keys equal key index
+            if (htable_lf_find(ctx->lf, &item.base, &out))
+                ctx->errors += ((const struct item*)out)->val != i;
+            else
+                ctx->errors += !(i & 1);
+            htable_lf_read_unlock(reader);
+        }
+    }
+    htable_lf_reader_unregister(reader);
+    return NULL;
+}
+
+char *test_threads()
+{
+    htable_options_t options = {0, NULL, 0, HTABLE_HASH_WORD, 0};
+    htable_lf_t *lf = htable_lf_make(&options);
+    struct reader_ctx readers[READERS_COUNT];
+    atomic_bool stop = false;
+    struct item item;
+
+    for (size_t i = 0; i < KEYS_COUNT; i += 2)
+    {
+        make_key(&item, i);
+        item.val = i;
+        htable_lf_set(lf, &item.base, sizeof(item));
+    }
+
+    for (size_t i = 0; i < READERS_COUNT; i++)
+    {
+        readers[i] = (struct reader_ctx){0, lf, &stop, 0};
+        ASSERTION(!pthread_create(&readers[i].thread, NULL, read_keys, &readers[i]), "Expected: Thread started!")
+    }
+
+    // The writer replaces even keys and inserts/removes odd ones, the table grows meanwhile
+    for (size_t round = 0; round < 20; round++)
+    {
+        for (size_t i = 0; i < KEYS_COUNT; i++)
+        {
+            make_key(&item, i);
+            item.val = i;
+            if ((i & 1) && (round & 1))
+                htable_lf_remove(lf, &item.base);
+            else
+                htable_lf_set(lf, &item.base, sizeof(item));
+        }
+    }
+    atomic_store(&stop, true);
+
+    size_t errors = 0;
+    for (size_t i = 0; i < READERS_COUNT; i++)
+    {
+        pthread_join(readers[i].thread, NULL);
+        errors += readers[i].errors;
+    }
+    ASSERTION(errors == 0, "Expected: Readers always saw consistent items!")
+    ASSERTION(htable_lf_reclaim(lf) == 0, "Expected: All retired items were released!")
+
+    htable_lf_destroy(lf);
+    return NULL;
+}
+
+int main(void)
+{
+    make_test_keys(keys, KEYS_COUNT, "key");
+
+    struct test_case test_cases[] = {
+        {"Test htable_lf_make wrong params", test_make_wrong_params},
+        {"Test lf wrong params", test_wrong_params},
+        {"Test lf functional", test_functional},
+        {"Test lf hash functions", test_hash_functions},
+        {"Test lf reclaim", test_reclaim},
+        {"Test lf threads", test_threads},
+        {0, 0},
+    };
+
+    return run_tests(test_cases);
+}
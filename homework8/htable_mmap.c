@@ -0,0 +1,183 @@
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "htable_mmap.h"
+
+#define CHECK_AND_EXIT_WITH_VAL_IF(cond, v)       if (cond)  return v;
+
+#define THP_SIZE ((size_t)2 * 1024 * 1024)  // Transparent huge page of x86-64 and arm64 (4 KiB base pages)
+#define NUMA_MAX_NODES 1024
+#define MASK_BITS (8 * sizeof(unsigned long))
+#define ALIGN_UP(size, align) (((size) + (align) - 1) & ~((align) - 1))
+
+#define CACHE_LINE_SIZE 64
+
+// Length of mapping (0 for blocks from malloc) is kept in the last word of header preceding block.
+// Mapped blocks take one cache line for it, so they start at cache line like the mapping itself.
+#define MALLOC_HEADER_SIZE ALIGN_UP(sizeof(size_t), _Alignof(max_align_t))
+#define MAP_HEADER_SIZE CACHE_LINE_SIZE
+
+static inline size_t *block_length(void *p)
+{
+    return (size_t*)p - 1;
+}
+
+/**
+ * Default size of explicit huge pages from /proc/meminfo (THP_SIZE if it can't be read).
+ */
+static size_t read_hugetlb_page_size(void)
+{
+    size_t kb = 0;
+    char line[128];
+    FILE *f = fopen("/proc/meminfo", "r");
+    CHECK_AND_EXIT_WITH_VAL_IF(!f, THP_SIZE)
+    while (fgets(line, sizeof(line), f) && 1 != sscanf(line, "Hugepagesize: %zu kB", &kb))
+        ;
+    fclose(f);
+    return (kb) ? kb * 1024 : THP_SIZE;
+}
+
+/**
+ * Apply placement policy to mapping before its pages are touched.
+ */
+static bool set_policy(const htable_mmap_t *mm, void *base, size_t length)
+{
+#ifdef __linux__
+    unsigned long mask[NUMA_MAX_NODES / MASK_BITS] = {0};
+    int mode;
+    if (mm->numa == HTABLE_NUMA_INTERLEAVE)
+    {
+        // All nodes the cpuset of process allows
+        CHECK_AND_EXIT_WITH_VAL_IF(syscall(SYS_get_mempolicy, &mode, mask, NUMA_MAX_NODES, NULL,
+                                           MPOL_F_MEMS_ALLOWED), false)
+        mode = MPOL_INTERLEAVE;
+    }
+    else
+    {
+        CHECK_AND_EXIT_WITH_VAL_IF(mm->node >= NUMA_MAX_NODES, false)
+        mask[mm->node / MASK_BITS] = 1ul << (mm->node % MASK_BITS);
+        mode = MPOL_PREFERRED;
+    }
+    // The kernel reads maxnode - 1 bits of mask
+    return 0 == syscall(SYS_mbind, base, length, mode, mask, NUMA_MAX_NODES + 1, 0);
+#else
+    (void)mm;
+    (void)base;
+    (void)length;
+    return false;
+#endif
+}
+
+/**
+ * Map at least size bytes with the best page kind available, returns NULL if mapping failed.
+ */
+static void *map_block(htable_mmap_t *mm, size_t size, size_t *out_length)
+{
+    const int prot = PROT_READ | PROT_WRITE, flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    uint8_t *base;
+
+#ifdef MAP_HUGETLB
+    if (mm->pages == HTABLE_PAGES_HUGETLB)
+    {
+        // Fails if the pool has no free pages, THP are used then
+        *out_length = ALIGN_UP(size, mm->hugetlb_page_size);
+        base = mmap(NULL, *out_length, prot, flags | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED)
+        {
+            mm->hugetlb_count++;
+            return base;
+        }
+    }
+#endif
+
+    if (mm->pages == HTABLE_PAGES_REGULAR)
+    {
+        *out_length = size;
+        base = mmap(NULL, size, prot, flags, -1, 0);
+        CHECK_AND_EXIT_WITH_VAL_IF(base == MAP_FAILED, NULL)
+        mm->regular_count++;
+        return base;
+    }
+
+    // Huge page is used only for aligned 2 MiB range: map one page more and trim both ends
+    *out_length = ALIGN_UP(size, THP_SIZE);
+    uint8_t *raw = mmap(NULL, *out_length + THP_SIZE, prot, flags, -1, 0);
+    CHECK_AND_EXIT_WITH_VAL_IF(raw == MAP_FAILED, NULL)
+    base = (uint8_t*)ALIGN_UP((uintptr_t)raw, THP_SIZE);
+    if (base > raw)
+        munmap(raw, base - raw);
+    munmap(base + *out_length, raw + THP_SIZE - base);
+
+#ifdef MADV_HUGEPAGE
+    if (0 == madvise(base, *out_length, MADV_HUGEPAGE))
+    {
+        mm->thp_count++;
+        return base;
+    }
+#endif
+    mm->regular_count++;
+    return base;
+}
+
+bool htable_mmap_init(htable_mmap_t *mm, uint32_t pages, uint32_t numa, int node)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!mm, false)
+    CHECK_AND_EXIT_WITH_VAL_IF(pages > HTABLE_PAGES_HUGETLB || numa > HTABLE_NUMA_NODE, false)
+    CHECK_AND_EXIT_WITH_VAL_IF(numa == HTABLE_NUMA_NODE && node < 0, false)
+
+    memset(mm, 0, sizeof(htable_mmap_t));
+    mm->pages = pages;
+    mm->numa = numa;
+    mm->node = node;
+    mm->min_size = HTABLE_MMAP_MIN_SIZE;
+    mm->hugetlb_page_size = (pages == HTABLE_PAGES_HUGETLB) ? read_hugetlb_page_size() : 0;
+    return true;
+}
+
+void *htable_mmap_alloc(size_t size, void *ctx)
+{
+    htable_mmap_t *mm = ctx;
+    CHECK_AND_EXIT_WITH_VAL_IF(!mm, NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF(size > SIZE_MAX / 2, NULL)  // Rounding up to huge pages can't overflow
+
+    uint8_t *block;
+    if (size < mm->min_size)
+    {
+        block = malloc(MALLOC_HEADER_SIZE + size);
+        CHECK_AND_EXIT_WITH_VAL_IF(!block, NULL)
+        block += MALLOC_HEADER_SIZE;
+        *block_length(block) = 0;
+        return block;
+    }
+
+    size_t length;
+    uint8_t *base = map_block(mm, MAP_HEADER_SIZE + size, &length);
+    CHECK_AND_EXIT_WITH_VAL_IF(!base, NULL)
+    if (mm->numa != HTABLE_NUMA_DEFAULT && !set_policy(mm, base, length))
+        mm->numa_failures++;
+    block = base + MAP_HEADER_SIZE;
+    *block_length(block) = length;  // The first touch, pages are placed by the policy from now
+    mm->mapped_bytes += length;
+    return block;
+}
+
+void htable_mmap_free(void *p, void *ctx)
+{
+    htable_mmap_t *mm = ctx;
+    size_t length = *block_length(p);
+    if (!length)
+    {
+        free((uint8_t*)p - MALLOC_HEADER_SIZE);
+        return;
+    }
+    mm->mapped_bytes -= length;
+    munmap((uint8_t*)p - MAP_HEADER_SIZE, length);
+}
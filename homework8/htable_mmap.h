@@ -0,0 +1,81 @@
+#ifndef _H_TABLE_MMAP_H
+#define _H_TABLE_MMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define HTABLE_PAGES_REGULAR 0  // Regular pages
+#define HTABLE_PAGES_THP 1      // Transparent huge pages (mappings are aligned and advised)
+#define HTABLE_PAGES_HUGETLB 2  // Explicit huge pages from hugetlbfs pool (THP if the pool is empty)
+
+#define HTABLE_NUMA_DEFAULT 0     // Pages are placed on the node of the thread touching them first
+#define HTABLE_NUMA_INTERLEAVE 1  // Pages are interleaved over all nodes the process may use
+#define HTABLE_NUMA_NODE 2        // Pages are placed on the given node (others if it runs out of memory)
+
+#define HTABLE_MMAP_MIN_SIZE (2 * 1024 * 1024)  // Default min_size: smaller allocations go to malloc
+
+typedef struct
+{
+    uint32_t pages;             // HTABLE_PAGES_*
+    uint32_t numa;              // HTABLE_NUMA_*
+    int node;                   // Node of HTABLE_NUMA_NODE
+    size_t min_size;            // Smaller allocations go to malloc
+    size_t hugetlb_page_size;   // Size of explicit huge pages (read by htable_mmap_init)
+    size_t hugetlb_count;       // Mappings backed by explicit huge pages
+    size_t thp_count;           // Mappings advised to use transparent huge pages
+    size_t regular_count;       // Mappings with regular pages (huge pages not requested or unavailable)
+    size_t numa_failures;       // Mappings the placement policy couldn't be applied to
+    size_t mapped_bytes;        // Bytes mapped now
+} htable_mmap_t;
+
+/**
+ *   Initialize allocator mapping large blocks with huge pages and NUMA placement policy
+ *
+ *   \param [out] mm - The allocator state (context of htable_mmap_alloc and htable_mmap_free)
+ *
+ *   \param [in] pages - Page kind: HTABLE_PAGES_REGULAR, HTABLE_PAGES_THP or HTABLE_PAGES_HUGETLB
+ *
+ *   \param [in] numa - Placement policy: HTABLE_NUMA_DEFAULT, HTABLE_NUMA_INTERLEAVE or HTABLE_NUMA_NODE
+ *
+ *   \param [in] node - The node for HTABLE_NUMA_NODE (ignored by other policies)
+ *
+ *   \return It returns false if pages or numa is unknown or node is negative for HTABLE_NUMA_NODE.
+ *
+ *   \details Plug it into a hash table with htable_make_alloc:
+ *   htable_allocator_t allocator = {htable_mmap_alloc, htable_mmap_free, &mm};
+ *   Blocks of min_size (HTABLE_MMAP_MIN_SIZE by default, it can be changed after the call) and
+ *   bigger - slot arrays of large tables, Bloom filters and arena chunks - get their own mappings,
+ *   smaller ones (items and keys of tables without arena) are taken from malloc. Huge pages
+ *   cover 2 MiB by one TLB entry instead of 4 KiB, so random probes of a table of hundreds of
+ *   millions of slots stop missing TLB. Every step falls back quietly: mapping without huge
+ *   pages if the hugetlbfs pool is empty, no advice if THP is disabled, first-touch placement if
+ *   the kernel has no NUMA support. Counters show what was really used. HTABLE_NUMA_INTERLEAVE
+ *   spreads the slot array over memory controllers of all sockets, so threads of every socket
+ *   see the same average latency; HTABLE_NUMA_NODE keeps it next to threads pinned to one node.
+ *   Counters are not atomic: tables sharing the state must be used from one thread or under one lock.
+ */
+bool htable_mmap_init(htable_mmap_t *mm, uint32_t pages, uint32_t numa, int node);
+
+/**
+ *  Allocate memory block (alloc hook of htable_allocator_t)
+ *
+ *  \param [in] size - The size of block
+ *
+ *  \param [in] ctx - The pointer to htable_mmap_t initialized by htable_mmap_init
+ *
+ *  \return It returns pointer to the block or NULL if memory can't be allocated. Blocks of min_size
+ *  and bigger are aligned to 64-byte cache line, smaller ones as max_align_t.
+ */
+void *htable_mmap_alloc(size_t size, void *ctx);
+
+/**
+ *  Release memory block (free hook of htable_allocator_t)
+ *
+ *  \param [in] p - The pointer returned by htable_mmap_alloc
+ *
+ *  \param [in] ctx - The pointer to htable_mmap_t passed to htable_mmap_alloc
+ */
+void htable_mmap_free(void *p, void *ctx);
+
+#endif // _H_TABLE_MMAP_H
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "htable.h"
+#include "htable_mmap.h"
+#include "htable_test_system.h"
+
+/// TEST CASES
+#define KEYS_COUNT 200000
+#define BIG_SIZE (5 * 1024 * 1024 + 3)
+#define THP_SIZE ((size_t)2 * 1024 * 1024)
+#define CACHE_LINE_SIZE 64
+
+static char keys[KEYS_COUNT][TEST_KEY_SIZE];
+
+static size_t mappings(const htable_mmap_t *mm)
+{
+    return mm->hugetlb_count + mm->thp_count + mm->regular_count;
+}
+
+static bool fill(uint8_t *p, size_t size)
+{
+    for (size_t i = 0; i < size; i += 4096)
+        p[i] = (uint8_t)i;
+    p[size - 1] = 0xAB;
+    return p[0] == 0 && p[size - 1] == 0xAB;
+}
+
+char *test_wrong_params()
+{
+    htable_mmap_t mm;
+    ASSERTION(!htable_mmap_init(NULL, HTABLE_PAGES_THP, HTABLE_NUMA_DEFAULT, 0), "Expected: false!")
+    ASSERTION(!htable_mmap_init(&mm, HTABLE_PAGES_HUGETLB + 1, HTABLE_NUMA_DEFAULT, 0), "Expected: false!")
+    ASSERTION(!htable_mmap_init(&mm, HTABLE_PAGES_THP, HTABLE_NUMA_NODE + 1, 0), "Expected: false!")
+    ASSERTION(!htable_mmap_init(&mm, HTABLE_PAGES_THP, HTABLE_NUMA_NODE, -1), "Expected: false!")
+    ASSERTION(htable_mmap_alloc(16, NULL) == NULL, "Expected: NULL!")
+    ASSERTION(htable_mmap_init(&mm, HTABLE_PAGES_THP, HTABLE_NUMA_DEFAULT, 0), "Expected: true!")
+    ASSERTION(htable_mmap_alloc(SIZE_MAX - 64, &mm) == NULL, "Expected: NULL!")
+    ASSERTION(mappings(&mm) == 0 && mm.mapped_bytes == 0, "Expected: Nothing was mapped!")
+    return NULL;
+}
+
+char *test_small_blocks()
+{
+    htable_mmap_t mm;
+    ASSERTION(htable_mmap_init(&mm, HTABLE_PAGES_HUGETLB, HTABLE_NUMA_INTERLEAVE, 0), "Expected: true!")
+    ASSERTION(mm.min_size == HTABLE_MMAP_MIN_SIZE, "Expected: Default threshold!")
+    uint8_t *p = htable_mmap_alloc(100, &mm);
+    ASSERTION(p != NULL && ((uintptr_t)p & (_Alignof(max_align_t) - 1)) == 0, "Expected: Aligned block!")
+    ASSERTION(fill(p, 100), "Expected: Block is writable!")
+    ASSERTION(mappings(&mm) == 0 && mm.mapped_bytes == 0, "Expected: Block is from malloc!")
+    htable_mmap_free(p, &mm);
+    return NULL;
+}
+
+char *test_big_blocks()
+{
+    const uint32_t pages[3] = {HTABLE_PAGES_REGULAR, HTABLE_PAGES_THP, HTABLE_PAGES_HUGETLB};
+    htable_mmap_t mm;
+    for (size_t i = 0; i < 3; i++)
+    {
+        ASSERTION(htable_mmap_init(&mm, pages[i], HTABLE_NUMA_DEFAULT, 0), "Expected: true!")
+        uint8_t *p = htable_mmap_alloc(BIG_SIZE, &mm);
+        ASSERTION(p != NULL && ((uintptr_t)p & (CACHE_LINE_SIZE - 1)) == 0, "Expected: Cache line aligned block!")
+        ASSERTION(fill(p, BIG_SIZE), "Expected: Block is writable!")
+        ASSERTION(mappings(&mm) == 1 && mm.mapped_bytes >= BIG_SIZE, "Expected: Block was mapped!")
+        ASSERTION(pages[i] != HTABLE_PAGES_REGULAR || mm.regular_count == 1, "Expected: Regular pages!")
+        // Huge pages were requested: the mapping starts at huge page whatever backs it
+        if (pages[i] != HTABLE_PAGES_REGULAR)
+        {
+            ASSERTION(((uintptr_t)p & (THP_SIZE - 1)) == CACHE_LINE_SIZE, "Expected: Only header precedes block!")
+            ASSERTION(mm.mapped_bytes % THP_SIZE == 0, "Expected: Whole huge pages were mapped!")
+        }
+        htable_mmap_free(p, &mm);
+        ASSERTION(mm.mapped_bytes == 0, "Expected: Block was unmapped!")
+    }
+    return NULL;
+}
+
+char *test_numa_policies()
+{
+    const uint32_t numa[3] = {HTABLE_NUMA_INTERLEAVE, HTABLE_NUMA_NODE, HTABLE_NUMA_NODE};
+    const int nodes[3] = {0, 0, 100000};
+    htable_mmap_t mm;
+    for (size_t i = 0; i < 3; i++)
+    {
+        ASSERTION(htable_mmap_init(&mm, HTABLE_PAGES_THP, numa[i], nodes[i]), "Expected: true!")
+        uint8_t *p = htable_mmap_alloc(BIG_SIZE, &mm);
+        ASSERTION(p != NULL && fill(p, BIG_SIZE), "Expected: Block was mapped whatever the policy!")
+        ASSERTION(mm.numa_failures <= 1, "Expected: At most one failure per mapping!")
+        ASSERTION(nodes[i] < 1024 || mm.numa_failures == 1, "Expected: Unknown node can't be used!")
+        htable_mmap_free(p, &mm);
+    }
+    return NULL;
+}
+
+char *test_htable()
+{
+    const uint32_t layouts[3] = {HTABLE_OPT_ARENA, HTABLE_OPT_SWISS | HTABLE_OPT_BLOOM, HTABLE_OPT_DENSE};
+    htable_mmap_t mm;
+    htable_allocator_t allocator = {htable_mmap_alloc, htable_mmap_free, &mm};
+    htable_item_base_t item;
+    for (size_t l = 0; l < 3; l++)
+    {
+        ASSERTION(htable_mmap_init(&mm, HTABLE_PAGES_THP, HTABLE_NUMA_INTERLEAVE, 0), "Expected: true!")
+        htable_options_t options = {0, NULL, layouts[l], HTABLE_HASH_WORD, 0};
+        htable_t *ht = htable_make_alloc(&options, &allocator);
+        ASSERTION(ht != NULL, "Expected: Hash table was created!")
+        for (size_t i = 0; i < KEYS_COUNT; i++)
+        {
+            item = (htable_item_base_t){(uint8_t*)keys[i], strlen(keys[i]), 0};
+            htable_set(ht, &item, sizeof(item));
+        }
+        ASSERTION(htable_status(ht) == HTABLE_OK, "Expected: HTABLE_OK!")
+        for (size_t i = 0; i < KEYS_COUNT; i++)
+        {
+            item = (htable_item_base_t){(uint8_t*)keys[i], strlen(keys[i]), 0};
+            ASSERTION(htable_find(ht, &item, NULL), "Expected: Item was found!")
+        }
+        ASSERTION(mm.mapped_bytes >= KEYS_COUNT * sizeof(uint32_t), "Expected: Slot array was mapped!")
+        htable_destroy(ht);
+        ASSERTION(mm.mapped_bytes == 0, "Expected: Everything was unmapped!")
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    make_test_keys(keys, KEYS_COUNT, "");
+
+    struct test_case test_cases[] = {
+        {"Test mmap wrong params", test_wrong_params},
+        {"Test mmap small blocks", test_small_blocks},
+        {"Test mmap big blocks", test_big_blocks},
+        {"Test mmap NUMA policies", test_numa_policies},
+        {"Test mmap hash table", test_htable},
+        {0, 0},
+    };
+
+    return run_tests(test_cases);
+}
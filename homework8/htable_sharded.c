@@ -0,0 +1,190 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "htable_sharded.h"
+
+#define CHECK_AND_EXIT_WITH_VAL_IF(cond, v)       if (cond)  return v;
+#define CHECK_AND_EXIT_IF(cond)                   if (cond)  return;
+
+#define CACHE_LINE_SIZE 64
+#define HTABLE_SHARDS_MAX 4096
+
+// Every shard takes whole cache lines, so locking one shard doesn't slow down threads using neighbours
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) pthread_mutex_t lock;
+    htable_t *ht;
+} shard_t;
+
+struct htable_sharded_t
+{
+    shard_t *shards;
+    size_t shards_count;
+    size_t item_size;   // All items have it, so finds copy whole items
+};
+
+static void destroy_shards(htable_sharded_t *sht, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        pthread_mutex_destroy(&sht->shards[i].lock);
+        htable_destroy(sht->shards[i].ht);
+    }
+    free(sht->shards);
+    free(sht);
+}
+
+/**
+ * Shard is selected by high bits of hash, shards use low bits for slot index.
+ * All shards have the same hash function and seed, so the hash is passed to the shard as it is.
+ */
+static shard_t *select_shard(htable_sharded_t *sht, const htable_item_base_t *item, uint32_t *hash)
+{
+    *hash = htable_hash(sht->shards[0].ht, item->key, item->key_len);
+    return &sht->shards[((uint64_t)*hash * sht->shards_count) >> 32];
+}
+
+htable_sharded_t *htable_sharded_make(size_t shards_count, size_t item_size, const htable_options_t *options)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!options, NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF(!shards_count || shards_count > HTABLE_SHARDS_MAX, NULL)
+    CHECK_AND_EXIT_WITH_VAL_IF(item_size < sizeof(htable_item_base_t), NULL)
+
+    htable_sharded_t *sht = malloc(sizeof(htable_sharded_t));
+    CHECK_AND_EXIT_WITH_VAL_IF(!sht, NULL)
+    sht->shards = aligned_alloc(CACHE_LINE_SIZE, shards_count * sizeof(shard_t));
+    if (!sht->shards)
+    {
+        free(sht);
+        return NULL;
+    }
+    sht->shards_count = shards_count;
+    sht->item_size = item_size;
+
+    htable_options_t shard_options = *options;
+    shard_options.init_len = options->init_len / shards_count;
+    if (options->flags & HTABLE_OPT_RANDOM_SEED)
+    {
+        // One random seed for all shards
+        shard_options.flags &= ~HTABLE_OPT_RANDOM_SEED;
+        shard_options.seed = htable_random_seed();
+    }
+    for (size_t i = 0; i < shards_count; i++)
+    {
+        shard_t *shard = &sht->shards[i];
+        shard->ht = htable_make_ex(&shard_options);
+        if (!shard->ht)
+        {
+            destroy_shards(sht, i);
+            return NULL;
+        }
+        if (pthread_mutex_init(&shard->lock, NULL))
+        {
+            htable_destroy(shard->ht);
+            destroy_shards(sht, i);
+            return NULL;
+        }
+    }
+    return sht;
+}
+
+void htable_sharded_destroy(htable_sharded_t *sht)
+{
+    CHECK_AND_EXIT_IF(!sht)
+    destroy_shards(sht, sht->shards_count);
+}
+
+htable_status_t htable_sharded_set(htable_sharded_t *sht, const htable_item_base_t *item, size_t item_size)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!sht || !item || !item->key, HTABLE_UNKNOWN)
+    CHECK_AND_EXIT_WITH_VAL_IF(item_size != sht->item_size, HTABLE_UNKNOWN)
+    uint32_t hash;
+    shard_t *shard = select_shard(sht, item, &hash);
+
+    pthread_mutex_lock(&shard->lock);
+    htable_set_hashed(shard->ht, item, item_size, hash);
+    htable_status_t status = htable_status(shard->ht);
+    pthread_mutex_unlock(&shard->lock);
+    return status;
+}
+
+htable_status_t htable_sharded_upsert(htable_sharded_t *sht, const htable_item_base_t *item, size_t item_size,
+                                      htable_update_func_t update, void *ctx)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!sht || !item || !item->key, HTABLE_UNKNOWN)
+    CHECK_AND_EXIT_WITH_VAL_IF(item_size != sht->item_size, HTABLE_UNKNOWN)
+    uint32_t hash;
+    shard_t *shard = select_shard(sht, item, &hash);
+    bool inserted;
+
+    pthread_mutex_lock(&shard->lock);
+    htable_item_base_t *stored = htable_upsert_hashed(shard->ht, item, item_size, hash, &inserted);
+    if (stored && update)
+        update(stored, inserted, ctx);
+    htable_status_t status = htable_status(shard->ht);
+    pthread_mutex_unlock(&shard->lock);
+    return status;
+}
+
+bool htable_sharded_remove(htable_sharded_t *sht, const htable_item_base_t *item)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!sht || !item || !item->key, false)
+    uint32_t hash;
+    shard_t *shard = select_shard(sht, item, &hash);
+
+    pthread_mutex_lock(&shard->lock);
+    bool is_founded = htable_remove_hashed(shard->ht, item, hash);
+    pthread_mutex_unlock(&shard->lock);
+    return is_founded;
+}
+
+bool htable_sharded_find(htable_sharded_t *sht, const htable_item_base_t *item, htable_item_base_t *out_item)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!sht || !item || !item->key, false)
+    uint32_t hash;
+    shard_t *shard = select_shard(sht, item, &hash);
+    htable_item_base_t *stored;
+
+    pthread_mutex_lock(&shard->lock);
+    bool is_founded = htable_find_hashed(shard->ht, item, hash, &stored);
+    if (is_founded && out_item)
+        memcpy(out_item, stored, sht->item_size);
+    pthread_mutex_unlock(&shard->lock);
+    return is_founded;
+}
+
+void htable_sharded_enumerate_items(htable_sharded_t *sht, int (*callback)(htable_item_base_t *item))
+{
+    CHECK_AND_EXIT_IF(!sht)
+    CHECK_AND_EXIT_IF(!callback)
+    bool go_on = true;
+
+    for (size_t i = 0; go_on && i < sht->shards_count; i++)
+    {
+        pthread_mutex_lock(&sht->shards[i].lock);
+        go_on = htable_enumerate_items(sht->shards[i].ht, callback);
+        pthread_mutex_unlock(&sht->shards[i].lock);
+    }
+}
+
+bool htable_sharded_stats(htable_sharded_t *sht, size_t shard_index, htable_stats_t *stats)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!sht || shard_index >= sht->shards_count, false)
+    shard_t *shard = &sht->shards[shard_index];
+
+    pthread_mutex_lock(&shard->lock);
+    bool ok = htable_stats(shard->ht, stats);
+    pthread_mutex_unlock(&shard->lock);
+    return ok;
+}
+
+item_destructor_t htable_sharded_set_item_destructor(htable_sharded_t *sht, item_destructor_t new_item_destructor)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!sht, NULL)
+    item_destructor_t current_item_destructor = NULL;
+    for (size_t i = 0; i < sht->shards_count; i++)
+        current_item_destructor = htable_set_item_destructor(sht->shards[i].ht, new_item_destructor);
+    return current_item_destructor;
+}
@@ -0,0 +1,149 @@
+#ifndef _H_TABLE_SHARDED_H
+#define _H_TABLE_SHARDED_H
+
+#include "htable.h"
+
+typedef struct htable_sharded_t htable_sharded_t;
+
+typedef void (*htable_update_func_t)(htable_item_base_t *item, bool inserted, void *ctx);
+
+/**
+ *   Make a sharded hash table which can be used from many threads
+ *
+ *   \param [in] shards_count - The number of sub-tables (shards)
+ *
+ *   \param [in] item_size - Size of every item stored in the table
+ *
+ *   \param [in] options - The pointer to options of every shard (see htable_make_ex)
+ *
+ *   \return It returns pointer to the instance of sharded hash table or NULL if error happened
+ *
+ *   \details Every shard is a htable_t protected by its own mutex. A key always goes to the same shard
+ *   which is selected by high bits of key's hash, so threads working with different shards don't wait
+ *   for each other. init_len of options is divided between shards. Use the number of shards a few
+ *   times bigger than the number of threads. All shards share one seed (a random one with
+ *   HTABLE_OPT_RANDOM_SEED), so every key is hashed once per call.
+ */
+htable_sharded_t *htable_sharded_make(size_t shards_count, size_t item_size, const htable_options_t *options);
+
+/**
+ *  Destroy the sharded hash table
+ *
+ *  \param [in] sht - The instance of sharded hash table
+ *
+ *  \details It must not be called while other threads use the hash table.
+ */
+void htable_sharded_destroy(htable_sharded_t *sht);
+
+/**
+ *  Insert item into the sharded hash table
+ *
+ *  \param [in] sht - The instance of sharded hash table
+ *
+ *  \param [in] item - Pointer to a htable_item_base_t structure (or compatible structure)
+ *
+ *  \param [in] item_size - Size of item, it must be equal to item_size of htable_sharded_make
+ *
+ *  \return It returns status of the shard after insertion (one of values of htable_status_t).
+ *  HTABLE_UNKNOWN is returned for wrong parameters.
+ *
+ *  \details See htable_set.
+ */
+htable_status_t htable_sharded_set(htable_sharded_t *sht, const htable_item_base_t *item, size_t item_size);
+
+/**
+ *  Find item or insert it if it isn't in the sharded hash table, then update it
+ *
+ *  \param [in] sht - The instance of sharded hash table
+ *
+ *  \param [in] item - Pointer to a htable_item_base_t structure (or compatible structure)
+ *
+ *  \param [in] item_size - Size of item, it must be equal to item_size of htable_sharded_make
+ *
+ *  \param [in] update - The function called for the stored item (can be NULL)
+ *
+ *  \param [in] ctx - The pointer passed to update function
+ *
+ *  \return It returns status of the shard after upsert (one of values of htable_status_t).
+ *  HTABLE_UNKNOWN is returned for wrong parameters.
+ *
+ *  \details See htable_upsert. The update function is called while the shard is locked, so it can
+ *  change the stored item safely. inserted parameter of update function is true for new item.
+ *  The update function must not call functions of the sharded hash table.
+ */
+htable_status_t htable_sharded_upsert(htable_sharded_t *sht, const htable_item_base_t *item, size_t item_size,
+                                      htable_update_func_t update, void *ctx);
+
+/**
+ *  Remove item from the sharded hash table
+ *
+ *  \param [in] sht - The instance of sharded hash table
+ *
+ *  \param [in] item - Pointer to a htable_item_base_t structure (or compatible)
+ *
+ *  \return It returns true if key has been found in hash table or false if it isn't so.
+ *
+ *  \details See htable_remove.
+ */
+bool htable_sharded_remove(htable_sharded_t *sht, const htable_item_base_t *item);
+
+/**
+ *  Find item and copy it
+ *
+ *  \param [in] sht - The instance of sharded hash table
+ *
+ *  \param [in] item - Pointer to a htable_item_base_t structure (or compatible)
+ *
+ *  \param [out] out_item - The pointer to a buffer of item_size of htable_sharded_make bytes where
+ *  the found item is copied (can be NULL)
+ *
+ *  \return  It returns true if key has been found in hash table or false if it isn't so.
+ *
+ *  \details The stored item can be changed or destroyed by another thread as soon as the shard is
+ *  unlocked, so it's copied while the shard is locked. The key field of the copy points to the stored
+ *  key, it's valid until the item is removed or replaced.
+ */
+bool htable_sharded_find(htable_sharded_t *sht, const htable_item_base_t *item, htable_item_base_t *out_item);
+
+/**
+ * Enumerate items of all shards
+ *
+ * \param [in] sht - The instance of sharded hash table
+ *
+ * \param [in] callback - The pointer to function that will be called for each item in hash table
+ *
+ * \details Shards are locked one by one, so the enumeration is not a snapshot of the whole table.
+ * The callback function can return zero to stop enumeration. It must not call functions of the
+ * sharded hash table. See htable_enumerate_items.
+ */
+void htable_sharded_enumerate_items(htable_sharded_t *sht, int (*callback)(htable_item_base_t *item));
+
+/**
+ *  Get statistics of one shard
+ *
+ *  \param [in] sht - The instance of sharded hash table
+ *
+ *  \param [in] shard_index - The index of shard (0 .. shards_count - 1)
+ *
+ *  \param [out] stats - The pointer where statistics are returned
+ *
+ *  \return It returns true if statistics were collected or false if error happened.
+ *
+ *  \details See htable_stats. The shard is locked while it takes O(capacity of shard) time.
+ */
+bool htable_sharded_stats(htable_sharded_t *sht, size_t shard_index, htable_stats_t *stats);
+
+/**
+ *  Set your own function that will be called when shards need to delete item.
+ *
+ *  \param [in] sht - The instance of sharded hash table
+ *
+ *  \param [in] item_destructor - The pointer of your own item destructor
+ *
+ *  \returns This function returns pointer to item destructor set by previous call
+ *
+ *  \details See htable_set_item_destructor. It must be called before other threads use the hash table.
+ */
+item_destructor_t htable_sharded_set_item_destructor(htable_sharded_t *sht, item_destructor_t new_item_destructor);
+
+#endif // _H_TABLE_SHARDED_H
@@ -0,0 +1,255 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "htable_sharded.h"
+#include "htable_test_system.h"
+
+/// TEST CASES
+#define KEYS_COUNT 1000
+#define THREADS_COUNT 4
+#define BLOOM_SHARDS_COUNT 64
+#define BLOOM_KEYS_COUNT (BLOOM_SHARDS_COUNT * 512)
+
+struct item
+{
+    htable_item_base_t base;
+    size_t val;
+};
+
+static char keys[KEYS_COUNT][TEST_KEY_SIZE];
+static char bloom_keys[BLOOM_KEYS_COUNT][TEST_KEY_SIZE];
+static char bloom_misses[BLOOM_KEYS_COUNT][TEST_KEY_SIZE];
+static size_t enumerated_count;
+static size_t enumerated_sum;
+
+static void make_key(struct item *item, size_t i)
+{
+    item->base.key = (uint8_t*)keys[i];
+    item->base.key_len = strlen(keys[i]);
+    item->base.flags = 0;
+}
+
+static void increment(htable_item_base_t *item, bool inserted, void *ctx)
+{
+    if (inserted)
+        ((struct item*)item)->val = 0;
+    ((struct item*)item)->val++;
+    (*(size_t*)ctx) += inserted;
+}
+
+static int enum_callback(htable_item_base_t *item)
+{
+    enumerated_count++;
+    enumerated_sum += ((struct item*)item)->val;
+    return 1;
+}
+
+static int enum_callback_stop(__attribute__((unused)) htable_item_base_t *item)
+{
+    enumerated_count++;
+    return 0;
+}
+
+char *test_make_wrong_params()
+{
+    htable_options_t options = {0, NULL, 0, HTABLE_HASH_WORD, 0};
+    ASSERTION(htable_sharded_make(4, sizeof(struct item), NULL) == NULL, "Expected: NULL!")
+    ASSERTION(htable_sharded_make(0, sizeof(struct item), &options) == NULL, "Expected: NULL!")
+    options.flags = HTABLE_OPT_SWISS | HTABLE_OPT_ROBIN_HOOD;
+    ASSERTION(htable_sharded_make(4, sizeof(struct item), &options) == NULL, "Expected: NULL!")
+    return NULL;
+}
+
+char *test_wrong_params()
+{
+    htable_options_t options = {0, NULL, 0, HTABLE_HASH_WORD, 0};
+    htable_sharded_t *sht = htable_sharded_make(4, sizeof(struct item), &options);
+    struct item item = {{NULL, 0, 0}, 0};
+
+    ASSERTION(htable_sharded_set(NULL, &item.base, sizeof(item)) == HTABLE_UNKNOWN, "Expected: HTABLE_UNKNOWN!")
+    ASSERTION(htable_sharded_set(sht, &item.base, sizeof(item)) == HTABLE_UNKNOWN, "Expected: HTABLE_UNKNOWN!")
+    ASSERTION(htable_sharded_upsert(sht, NULL, sizeof(item), NULL, NULL) == HTABLE_UNKNOWN, "Expected: HTABLE_UNKNOWN!")
+    ASSERTION(!htable_sharded_find(sht, &item.base, NULL), "Expected: false!")
+    ASSERTION(!htable_sharded_remove(sht, &item.base), "Expected: false!")
+    htable_sharded_enumerate_items(sht, NULL);
+    htable_sharded_destroy(NULL);
+    htable_sharded_destroy(sht);
+    return NULL;
+}
+
+char *test_functional()
+{
+    htable_options_t options = {64, NULL, HTABLE_OPT_ARENA | HTABLE_OPT_RANDOM_SEED, HTABLE_HASH_WORD, 0};
+    htable_sharded_t *sht = htable_sharded_make(8, sizeof(struct item), &options);
+    struct item item, out;
+    ASSERTION(sht != NULL, "Expected: not NULL!")
+
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        make_key(&item, i);
+        item.val = i;
+        ASSERTION(htable_sharded_set(sht, &item.base, sizeof(item)) == HTABLE_OK, "Expected: HTABLE_OK!")
+    }
+
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        make_key(&item, i);
+        ASSERTION(htable_sharded_find(sht, &item.base, &out.base), "Expected: Item was found!")
+        ASSERTION(out.val == i, "Expected: Value of item!")
+    }
+
+    for (size_t i = 0; i < KEYS_COUNT; i += 2)
+    {
+        make_key(&item, i);
+        ASSERTION(htable_sharded_remove(sht, &item.base), "Expected: Item was removed!")
+    }
+
+    size_t inserted = 0;
+    make_key(&item, 0);
+    htable_sharded_upsert(sht, &item.base, sizeof(item), increment, &inserted);
+    make_key(&item, 1);
+    htable_sharded_upsert(sht, &item.base, sizeof(item), increment, &inserted);
+    ASSERTION(inserted == 1, "Expected: Only removed item was inserted!")
+    ASSERTION(htable_sharded_find(sht, &item.base, &out.base) && out.val == 2, "Expected: Updated!")
+
+    enumerated_count = 0;
+    htable_sharded_enumerate_items(sht, enum_callback);
+    ASSERTION(enumerated_count == KEYS_COUNT / 2 + 1, "Expected: All items of all shards were enumerated!")
+
+    enumerated_count = 0;
+    htable_sharded_enumerate_items(sht, enum_callback_stop);
+    ASSERTION(enumerated_count == 1, "Expected: Enumeration was stopped!")
+
+    htable_sharded_destroy(sht);
+    return NULL;
+}
+
+char *test_item_size()
+{
+    htable_options_t options = {0, NULL, 0, HTABLE_HASH_WORD, 0};
+    ASSERTION(htable_sharded_make(1, sizeof(htable_item_base_t) - 1, &options) == NULL, "Expected: NULL!")
+
+    htable_sharded_t *sht = htable_sharded_make(1, sizeof(struct item), &options);
+    struct item item, out;
+    make_key(&item, 0);
+    item.val = 7;
+    ASSERTION(htable_sharded_set(sht, &item.base, sizeof(htable_item_base_t)) == HTABLE_UNKNOWN,
+              "Expected: Item of other size is rejected!")
+    ASSERTION(htable_sharded_upsert(sht, &item.base, sizeof(item) + 1, NULL, NULL) == HTABLE_UNKNOWN,
+              "Expected: Item of other size is rejected!")
+    ASSERTION(!htable_sharded_find(sht, &item.base, NULL), "Expected: Nothing was inserted!")
+
+    htable_sharded_set(sht, &item.base, sizeof(item));
+    out.val = 0;
+    ASSERTION(htable_sharded_find(sht, &item.base, &out.base), "Expected: Item was found!")
+    ASSERTION(out.val == 7, "Expected: Whole item was copied!")
+    htable_sharded_destroy(sht);
+    return NULL;
+}
+
+char *test_bloom()
+{
+    // Keys of a shard have the same high bits of hash, Bloom filter of shard must not depend on them
+    htable_options_t options = {BLOOM_KEYS_COUNT, NULL, HTABLE_OPT_BLOOM | HTABLE_OPT_STATS, HTABLE_HASH_WORD, 0};
+    htable_sharded_t *sht = htable_sharded_make(BLOOM_SHARDS_COUNT, sizeof(htable_item_base_t), &options);
+    htable_item_base_t item = {NULL, 0, 0};
+    htable_stats_t stats;
+
+    for (size_t i = 0; i < BLOOM_KEYS_COUNT; i++)
+    {
+        item.key = (uint8_t*)bloom_keys[i];
+        item.key_len = strlen(bloom_keys[i]);
+        htable_sharded_set(sht, &item, sizeof(item));
+    }
+    size_t found = 0;
+    for (size_t i = 0; i < BLOOM_KEYS_COUNT; i++)
+    {
+        item.key = (uint8_t*)bloom_misses[i];
+        item.key_len = strlen(bloom_misses[i]);
+        found += htable_sharded_find(sht, &item, NULL);
+    }
+    ASSERTION(found == 0, "Expected: Missing keys were not found!")
+
+    uint64_t rejects = 0;
+    for (size_t i = 0; i < BLOOM_SHARDS_COUNT; i++)
+    {
+        ASSERTION(htable_sharded_stats(sht, i, &stats), "Expected: Statistics of shard!")
+        rejects += stats.bloom_rejects;
+    }
+    ASSERTION(!htable_sharded_stats(sht, BLOOM_SHARDS_COUNT, &stats), "Expected: No such shard!")
+    ASSERTION(rejects > BLOOM_KEYS_COUNT * 9 / 10, "Expected: Most misses were rejected by Bloom filters!")
+    htable_sharded_destroy(sht);
+    return NULL;
+}
+
+struct worker
+{
+    pthread_t thread;
+    htable_sharded_t *sht;
+    size_t inserted;
+};
+
+static void *count_keys(void *arg)
+{
+    struct worker *w = arg;
+    struct item item = {{NULL, 0, 0}, 0};
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        make_key(&item, i);
+        htable_sharded_upsert(w->sht, &item.base, sizeof(item), increment, &w->inserted);
+    }
+    return NULL;
+}
+
+char *test_threads()
+{
+    htable_options_t options = {0, NULL, HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    htable_sharded_t *sht = htable_sharded_make(16, sizeof(struct item), &options);
+    struct worker workers[THREADS_COUNT];
+
+    for (size_t i = 0; i < THREADS_COUNT; i++)
+    {
+        workers[i].sht = sht;
+        workers[i].inserted = 0;
+        ASSERTION(!pthread_create(&workers[i].thread, NULL, count_keys, &workers[i]), "Expected: Thread started!")
+    }
+
+    size_t inserted = 0;
+    for (size_t i = 0; i < THREADS_COUNT; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+        inserted += workers[i].inserted;
+    }
+    ASSERTION(inserted == KEYS_COUNT, "Expected: Every key was inserted once!")
+
+    enumerated_count = 0;
+    enumerated_sum = 0;
+    htable_sharded_enumerate_items(sht, enum_callback);
+    ASSERTION(enumerated_count == KEYS_COUNT, "Expected: All keys are in table!")
+    ASSERTION(enumerated_sum == KEYS_COUNT * THREADS_COUNT, "Expected: Every upsert was counted!")
+
+    htable_sharded_destroy(sht);
+    return NULL;
+}
+
+int main(void)
+{
+    make_test_keys(keys, KEYS_COUNT, "key");
+    make_test_keys(bloom_keys, BLOOM_KEYS_COUNT, "key");
+    make_test_keys(bloom_misses, BLOOM_KEYS_COUNT, "miss");
+
+    struct test_case test_cases[] = {
+        {"Test htable_sharded_make wrong params", test_make_wrong_params},
+        {"Test sharded wrong params", test_wrong_params},
+        {"Test sharded functional", test_functional},
+        {"Test sharded item size", test_item_size},
+        {"Test sharded threads", test_threads},
+        {"Test sharded bloom", test_bloom},
+        {0, 0},
+    };
+
+    return run_tests(test_cases);
+}
@@ -0,0 +1,240 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "htable_snapshot.h"
+#include "htable_hash.h"
+
+#define CHECK_AND_EXIT_WITH_VAL_IF(cond, v)       if (cond)  return v;
+#define CHECK_AND_EXIT_IF(cond)                   if (cond)  return;
+
+#define SNAPSHOT_MAGIC "HTSNAP\0"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304      // Read back in other order on machine with another byte order
+#define SNAPSHOT_SEED 0x736E617073686F74ull  // Seed of snapshot hash function (htable_word_hash)
+#define ALIGN8(size) (((size) + 7) & ~(uint64_t)7)
+
+// All offsets are from the start of file, so the file can be mapped at any address
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t seed;
+    uint64_t capacity;          // Number of slots, power of two
+    uint64_t items_count;
+    uint64_t payload_size;      // Bytes of item after htable_item_base_t
+    uint64_t slots_offset;
+    uint64_t file_size;
+} snapshot_header_t;
+
+typedef struct
+{
+    uint32_t hash;
+    uint32_t key_len;
+    uint64_t offset;            // Record: payload (aligned to 8 bytes) then key. 0 is empty slot
+} snapshot_slot_t;
+
+struct htable_snapshot_t
+{
+    const uint8_t *base;
+    size_t size;
+    const snapshot_header_t *header;
+    const snapshot_slot_t *slots;
+    uint64_t seed;              // Keys are hashed by htable_word_hash with seed of header
+};
+
+struct collected
+{
+    htable_item_base_t **items;
+    size_t count;
+    size_t capacity;
+};
+
+static int collect_item(htable_item_base_t *item, void *ctx)
+{
+    struct collected *c = ctx;
+    if (c->count == c->capacity)
+    {
+        size_t new_capacity = c->capacity ? c->capacity << 1 : 1024;
+        htable_item_base_t **new_items = realloc(c->items, new_capacity * sizeof(htable_item_base_t*));
+        CHECK_AND_EXIT_WITH_VAL_IF(!new_items, 0)
+        c->items = new_items;
+        c->capacity = new_capacity;
+    }
+    c->items[c->count++] = item;
+    return 1;
+}
+
+static bool write_padding(FILE *f, size_t size)
+{
+    static const uint8_t zeros[8];
+    return size == 0 || fwrite(zeros, size, 1, f) == 1;
+}
+
+/**
+ * Build slot array for collected items and write the whole snapshot.
+ */
+static bool write_snapshot(FILE *f, struct collected *c, size_t payload_size)
+{
+    snapshot_header_t header = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, SNAPSHOT_BYTE_ORDER, SNAPSHOT_SEED,
+                                8, c->count, payload_size, sizeof(snapshot_header_t), 0};
+    while (header.capacity < c->count << 1)
+        header.capacity <<= 1;
+
+    snapshot_slot_t *slots = calloc(header.capacity, sizeof(snapshot_slot_t));
+    CHECK_AND_EXIT_WITH_VAL_IF(!slots, false)
+
+    uint64_t offset = header.slots_offset + header.capacity * sizeof(snapshot_slot_t);
+    uint64_t mask = header.capacity - 1, index;
+    htable_item_base_t *item;
+    for (size_t i = 0; i < c->count; i++)
+    {
+        item = c->items[i];
+        uint32_t hash = htable_word_hash(item->key, item->key_len, header.seed);
+        for (index = hash & mask; slots[index].offset; index = (index + 1) & mask)
+            ;
+        slots[index] = (snapshot_slot_t){hash, (uint32_t)item->key_len, offset};
+        offset += ALIGN8(payload_size) + ALIGN8(item->key_len);
+    }
+    header.file_size = offset;
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(slots, sizeof(snapshot_slot_t), header.capacity, f) == header.capacity;
+    free(slots);
+
+    for (size_t i = 0; ok && i < c->count; i++)
+    {
+        item = c->items[i];
+        ok = (payload_size == 0 || fwrite(item + 1, payload_size, 1, f) == 1) &&
+             write_padding(f, ALIGN8(payload_size) - payload_size) &&
+             (item->key_len == 0 || fwrite(item->key, item->key_len, 1, f) == 1) &&
+             write_padding(f, ALIGN8(item->key_len) - item->key_len);
+    }
+    return ok;
+}
+
+bool htable_snapshot_save(htable_t *ht, size_t item_size, const char *path)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht || !path || item_size < sizeof(htable_item_base_t), false)
+
+    struct collected c = {NULL, 0, 0};
+    bool ok = htable_enumerate_items_ex(ht, collect_item, &c);
+    for (size_t i = 0; ok && i < c.count; i++)
+    {
+        if (c.items[i]->key_len > UINT32_MAX)
+        {
+            errno = EOVERFLOW;
+            ok = false;
+        }
+    }
+
+    char *tmp_path = malloc(strlen(path) + sizeof(".tmp"));
+    FILE *f = NULL;
+    ok = ok && tmp_path;
+    if (ok)
+    {
+        sprintf(tmp_path, "%s.tmp", path);
+        f = fopen(tmp_path, "wb");
+        ok = f != NULL;
+    }
+
+    if (ok)
+    {
+        ok = write_snapshot(f, &c, item_size - sizeof(htable_item_base_t)) &&
+             fflush(f) == 0 && fsync(fileno(f)) == 0;
+        ok = (fclose(f) == 0) && ok;
+        ok = ok && rename(tmp_path, path) == 0;
+        if (!ok)
+            unlink(tmp_path);
+    }
+
+    free(tmp_path);
+    free(c.items);
+    return ok;
+}
+
+static bool is_valid_header(const snapshot_header_t *header, size_t size)
+{
+    return 0 == memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) &&
+           header->version == SNAPSHOT_VERSION &&
+           header->byte_order == SNAPSHOT_BYTE_ORDER &&
+           header->file_size == size &&
+           header->capacity && !(header->capacity & (header->capacity - 1)) &&
+           header->items_count <= header->capacity &&
+           header->slots_offset == sizeof(snapshot_header_t) &&
+           header->capacity <= (size - header->slots_offset) / sizeof(snapshot_slot_t);
+}
+
+htable_snapshot_t *htable_snapshot_open(const char *path)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!path, NULL)
+    int fd = open(path, O_RDONLY);
+    CHECK_AND_EXIT_WITH_VAL_IF(fd == -1, NULL)
+
+    struct stat st;
+    void *base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(snapshot_header_t))
+        base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping stays valid after the file is closed
+    CHECK_AND_EXIT_WITH_VAL_IF(base == MAP_FAILED, NULL)
+
+    htable_snapshot_t *snap = malloc(sizeof(htable_snapshot_t));
+    if (!snap || !is_valid_header(base, st.st_size))
+    {
+        free(snap);
+        munmap(base, st.st_size);
+        return NULL;
+    }
+
+    snap->base = base;
+    snap->size = st.st_size;
+    snap->header = base;
+    snap->slots = (const snapshot_slot_t*)(snap->base + snap->header->slots_offset);
+    snap->seed = snap->header->seed;
+    return snap;
+}
+
+void htable_snapshot_close(htable_snapshot_t *snap)
+{
+    CHECK_AND_EXIT_IF(!snap)
+    munmap((void*)snap->base, snap->size);
+    free(snap);
+}
+
+const void *htable_snapshot_find(const htable_snapshot_t *snap, const htable_item_base_t *item)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!snap || !item || !item->key, NULL)
+
+    uint32_t hash = htable_word_hash(item->key, item->key_len, snap->seed);
+    uint64_t mask = snap->header->capacity - 1;
+    uint64_t key_offset = ALIGN8(snap->header->payload_size);
+    uint64_t index = hash & mask;
+    const snapshot_slot_t *slot;
+
+    for (uint64_t i = 0; i <= mask; i++, index = (index + 1) & mask)
+    {
+        slot = &snap->slots[index];
+        if (!slot->offset)
+            return NULL;
+
+        // Records are checked against file size, a damaged file can't make us read out of mapping
+        if (slot->hash == hash && slot->key_len == item->key_len &&
+            slot->offset < snap->size && key_offset + slot->key_len <= snap->size - slot->offset &&
+            0 == memcmp(snap->base + slot->offset + key_offset, item->key, item->key_len))
+            return snap->base + slot->offset;
+    }
+    return NULL;
+}
+
+size_t htable_snapshot_items_count(const htable_snapshot_t *snap)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!snap, 0)
+    return snap->header->items_count;
+}
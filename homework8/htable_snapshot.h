@@ -0,0 +1,72 @@
+#ifndef _H_TABLE_SNAPSHOT_H
+#define _H_TABLE_SNAPSHOT_H
+
+#include "htable.h"
+
+typedef struct htable_snapshot_t htable_snapshot_t;
+
+/**
+ *   Save the hash table to file which can be mapped by htable_snapshot_open
+ *
+ *   \param [in] ht - The instance of hash table
+ *
+ *   \param [in] item_size - Size of items (all items of hash table must have the same size)
+ *
+ *   \param [in] path - The path of snapshot file
+ *
+ *   \return It returns true if snapshot was saved or false if error happened (errno is set).
+ *
+ *   \details The file contains slot array (hash, key length and offset of record for every slot),
+ *   and records with payload (item_size - sizeof(htable_item_base_t) bytes after base of item) and key.
+ *   There are no pointers in the file, so payloads must not contain pointers either.
+ *   The slot array is built for the snapshot (linear probing, load factor <= 1/2) with its own hash
+ *   function, so any hash table layout and hash function can be saved. The file is written to a
+ *   temporary file which is renamed to path, so readers never see partially written snapshot.
+ */
+bool htable_snapshot_save(htable_t *ht, size_t item_size, const char *path);
+
+/**
+ *   Map snapshot file
+ *
+ *   \param [in] path - The path of snapshot file
+ *
+ *   \return It returns pointer to the instance of snapshot or NULL if error happened
+ *
+ *   \details The file is mapped read-only and shared, nothing is allocated per item and nothing
+ *   is rehashed, so opening takes the same time for any size. Pages are read on demand and
+ *   page cache is shared by all processes mapping the file. NULL is returned for files which
+ *   are not snapshots or were saved on machine with another byte order.
+ */
+htable_snapshot_t *htable_snapshot_open(const char *path);
+
+/**
+ *  Unmap snapshot
+ *
+ *  \param [in] snap - The instance of snapshot
+ */
+void htable_snapshot_close(htable_snapshot_t *snap);
+
+/**
+ *  Find payload of item in snapshot
+ *
+ *  \param [in] snap - The instance of snapshot
+ *
+ *  \param [in] item - Pointer to a htable_item_base_t structure (or compatible)
+ *
+ *  \return It returns pointer to payload of found item (read-only, valid until htable_snapshot_close)
+ *  or NULL if key was not found.
+ *
+ *  \details Payload is aligned to 8 bytes.
+ */
+const void *htable_snapshot_find(const htable_snapshot_t *snap, const htable_item_base_t *item);
+
+/**
+ *  Get the number of items in snapshot
+ *
+ *  \param [in] snap - The instance of snapshot
+ *
+ *  \return It returns the number of items.
+ */
+size_t htable_snapshot_items_count(const htable_snapshot_t *snap);
+
+#endif // _H_TABLE_SNAPSHOT_H
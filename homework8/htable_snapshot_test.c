@@ -0,0 +1,204 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "htable_snapshot.h"
+#include "htable_test_system.h"
+
+/// TEST CASES
+#define KEYS_COUNT 1000
+
+struct item
+{
+    htable_item_base_t base;
+    size_t val;
+    char tag[3];
+};
+
+static char keys[KEYS_COUNT][TEST_KEY_SIZE];
+static char snapshot_path[64];
+
+static void make_key(struct item *item, size_t i)
+{
+    item->base.key = (uint8_t*)keys[i];
+    item->base.key_len = strlen(keys[i]);
+    item->base.flags = 0;
+}
+
+static char *check_layout(uint32_t flags)
+{
+    htable_options_t options = {0, NULL, flags, HTABLE_HASH_JENKINS, 0};
+    htable_t *ht = htable_make_ex(&options);
+    struct item item;
+    ASSERTION(ht != NULL, "Expected: not NULL!")
+
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        make_key(&item, i);
+        item.val = i;
+        memcpy(item.tag, "abc", sizeof(item.tag));
+        htable_set(ht, &item.base, sizeof(item));
+        ASSERTION(htable_status(ht) == HTABLE_OK, "Expected: HTABLE_OK!")
+    }
+    for (size_t i = 0; i < KEYS_COUNT; i += 2)
+    {
+        make_key(&item, i);
+        ASSERTION(htable_remove(ht, &item.base), "Expected: Item was removed!")
+    }
+
+    ASSERTION(htable_snapshot_save(ht, sizeof(item), snapshot_path), "Expected: Snapshot was saved!")
+    htable_destroy(ht);
+
+    htable_snapshot_t *snap = htable_snapshot_open(snapshot_path);
+    ASSERTION(snap != NULL, "Expected: Snapshot was opened!")
+    ASSERTION(htable_snapshot_items_count(snap) == KEYS_COUNT / 2, "Expected: Count of saved items!")
+
+    const struct
+    {
+        size_t val;
+        char tag[3];
+    } *payload;
+    for (size_t i = 0; i < KEYS_COUNT; i++)
+    {
+        make_key(&item, i);
+        payload = htable_snapshot_find(snap, &item.base);
+        if (i % 2 == 0)
+        {
+            ASSERTION(payload == NULL, "Expected: Removed item was not saved!")
+            continue;
+        }
+        ASSERTION(payload != NULL, "Expected: Item was found!")
+        ASSERTION(((uintptr_t)payload & 7) == 0, "Expected: Payload is aligned!")
+        ASSERTION(payload->val == i && !memcmp(payload->tag, "abc", 3), "Expected: Payload of item!")
+    }
+
+    item.base.key = (uint8_t*)"missing";
+    item.base.key_len = 7;
+    ASSERTION(htable_snapshot_find(snap, &item.base) == NULL, "Expected: NULL!")
+
+    htable_snapshot_close(snap);
+    return NULL;
+}
+
+char *test_wrong_params()
+{
+    htable_t *ht = htable_make(0, NULL);
+    struct item item = {{NULL, 0, 0}, 0, {0}};
+
+    ASSERTION(!htable_snapshot_save(NULL, sizeof(item), snapshot_path), "Expected: false!")
+    ASSERTION(!htable_snapshot_save(ht, sizeof(item), NULL), "Expected: false!")
+    ASSERTION(!htable_snapshot_save(ht, 1, snapshot_path), "Expected: false!")
+    ASSERTION(!htable_snapshot_save(ht, sizeof(item), "/nonexistent/dir/file"), "Expected: false!")
+    ASSERTION(htable_snapshot_open(NULL) == NULL, "Expected: NULL!")
+    ASSERTION(htable_snapshot_open("/nonexistent/dir/file") == NULL, "Expected: NULL!")
+    ASSERTION(htable_snapshot_find(NULL, &item.base) == NULL, "Expected: NULL!")
+    ASSERTION(htable_snapshot_items_count(NULL) == 0, "Expected: 0!")
+    htable_snapshot_close(NULL);
+    htable_destroy(ht);
+    return NULL;
+}
+
+char *test_empty()
+{
+    htable_t *ht = htable_make(0, NULL);
+    struct item item;
+    ASSERTION(htable_snapshot_save(ht, sizeof(item), snapshot_path), "Expected: Snapshot was saved!")
+    htable_destroy(ht);
+
+    htable_snapshot_t *snap = htable_snapshot_open(snapshot_path);
+    ASSERTION(snap != NULL, "Expected: Snapshot was opened!")
+    ASSERTION(htable_snapshot_items_count(snap) == 0, "Expected: 0!")
+    make_key(&item, 0);
+    ASSERTION(htable_snapshot_find(snap, &item.base) == NULL, "Expected: NULL!")
+    htable_snapshot_close(snap);
+    return NULL;
+}
+
+char *test_linear()
+{
+    return check_layout(HTABLE_OPT_RANDOM_SEED);
+}
+
+char *test_swiss_arena()
+{
+    return check_layout(HTABLE_OPT_SWISS | HTABLE_OPT_ARENA);
+}
+
+char *test_robin_hood()
+{
+    return check_layout(HTABLE_OPT_ROBIN_HOOD);
+}
+
+char *test_replace()
+{
+    htable_t *ht = htable_make(0, NULL);
+    struct item item;
+    make_key(&item, 0);
+    item.val = 1;
+    htable_set(ht, &item.base, sizeof(item));
+    ASSERTION(htable_status(ht) == HTABLE_OK, "Expected: HTABLE_OK!")
+    ASSERTION(htable_snapshot_save(ht, sizeof(item), snapshot_path), "Expected: Snapshot was saved!")
+
+    htable_snapshot_t *snap = htable_snapshot_open(snapshot_path);
+    ASSERTION(snap != NULL, "Expected: Snapshot was opened!")
+
+    // The new snapshot replaces file, the mapped one stays unchanged
+    item.val = 2;
+    htable_set(ht, &item.base, sizeof(item));
+    ASSERTION(htable_status(ht) == HTABLE_OK, "Expected: HTABLE_OK!")
+    ASSERTION(htable_snapshot_save(ht, sizeof(item), snapshot_path), "Expected: Snapshot was saved!")
+    const size_t *val = htable_snapshot_find(snap, &item.base);
+    ASSERTION(val && *val == 1, "Expected: Old value!")
+    htable_snapshot_close(snap);
+
+    snap = htable_snapshot_open(snapshot_path);
+    val = htable_snapshot_find(snap, &item.base);
+    ASSERTION(val && *val == 2, "Expected: New value!")
+    htable_snapshot_close(snap);
+    htable_destroy(ht);
+    return NULL;
+}
+
+char *test_corrupted()
+{
+    FILE *f = fopen(snapshot_path, "wb");
+    ASSERTION(f != NULL, "Expected: File was created!")
+    ASSERTION(fwrite(keys, sizeof(keys), 1, f) == 1, "Expected: File was written!")
+    fclose(f);
+    ASSERTION(htable_snapshot_open(snapshot_path) == NULL, "Expected: Not a snapshot!")
+
+    htable_t *ht = htable_make(0, NULL);
+    struct item item;
+    make_key(&item, 0);
+    htable_set(ht, &item.base, sizeof(item));
+    ASSERTION(htable_status(ht) == HTABLE_OK, "Expected: HTABLE_OK!")
+    ASSERTION(htable_snapshot_save(ht, sizeof(item), snapshot_path), "Expected: Snapshot was saved!")
+    htable_destroy(ht);
+
+    ASSERTION(truncate(snapshot_path, 64) == 0, "Expected: File was truncated!")
+    ASSERTION(htable_snapshot_open(snapshot_path) == NULL, "Expected: Truncated snapshot!")
+    return NULL;
+}
+
+int main(void)
+{
+    make_test_keys(keys, KEYS_COUNT, "key");
+    snprintf(snapshot_path, sizeof(snapshot_path), "/tmp/htable_snapshot_test.%ld", (long)getpid());
+
+    struct test_case test_cases[] = {
+        {"Test snapshot wrong params", test_wrong_params},
+        {"Test snapshot of empty table", test_empty},
+        {"Test snapshot of linear probing table", test_linear},
+        {"Test snapshot of swiss table with arena", test_swiss_arena},
+        {"Test snapshot of robin hood table", test_robin_hood},
+        {"Test snapshot replace", test_replace},
+        {"Test snapshot corrupted file", test_corrupted},
+        {0, 0},
+    };
+
+    int status = run_tests(test_cases);
+    unlink(snapshot_path);
+    return status;
+}
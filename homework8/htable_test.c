@@ -278,6 +278,7 @@ void run_tests(struct test_case *test_cases, test_setup_func_t setUpFunc)
 }
 
 /// TEST FOR
+#define HTABLE_ARENA_CHUNK_SIZE 256  // Arena chunks must fit mock memory buffer
 #define _STDLIB_H  // DIRTY HACK - We prevent using stdlib.h (only malloc, calloc, free used in htable.c)
 #include "htable.c"
 #undef _STDLIB_H
@@ -286,6 +287,7 @@ void run_tests(struct test_case *test_cases, test_setup_func_t setUpFunc)
 struct test_global_state {
     htable_t ht;
     htable_item_base_t *arr[4];
+    uint32_t hashes[4];
     htable_item_base_t *enumerated[4];
     size_t hash_func_calls_count;
     size_t destructor_calls_count;
@@ -342,17 +344,40 @@ void set_up_test()
 
     tgst.ht.capacity = 4;
     tgst.ht.items = tgst.arr;
+    tgst.ht.hashes = tgst.hashes;
     tgst.ht.items_count = 0;
     tgst.ht.item_destructor = mock_item_destructor;
     tgst.ht.hash_func = const_hash_func;
+    tgst.ht.seeded_hash_func = word_hash;
+    tgst.ht.seed = 0;
+    tgst.ht.inline_key_max = 0;
+    tgst.ht.flags = 0;
+    tgst.ht.arena = NULL;
+    tgst.ht.bloom = NULL;
+    tgst.ht.bloom_mem = NULL;
+    tgst.ht.bloom_blocks = 0;
+    tgst.ht.max_items = 0;
+    tgst.ht.clock_hand = 0;
+    tgst.ht.allocator = default_allocator;
+    tgst.ht.ctrl = NULL;
+    tgst.ht.positions = NULL;
+    tgst.ht.dense = NULL;
+    tgst.ht.dense_count = 0;
+    tgst.ht.deleted_count = 0;
+    tgst.ht.old_items = NULL;
+    tgst.ht.old_hashes = NULL;
+    tgst.ht.old_capacity = 0;
+    tgst.ht.migrate_index = 0;
+    memset(&tgst.ht.stats, 0, sizeof(tgst.ht.stats));
     tgst.ht.last_error = HTABLE_OK;
     memset(tgst.arr, 0, 4 * sizeof(htable_item_base_t*));
+    memset(tgst.hashes, 0, 4 * sizeof(uint32_t));
     memset(tgst.enumerated, 0, 4 * sizeof(htable_item_base_t*));
 }
 
 char *test_default_item_destructor()
 {
-    htable_item_base_t item = {(uint8_t*)"KEY", 3};
+    htable_item_base_t item = {(uint8_t*)"KEY", 3, 0};
     default_item_destructor(&item);
     ASSERTION(memory_released, "Expected: Memory was released!")
     ASSERTION(mem_freed[0].mem == item.key, "Expected: Key was freed!")
@@ -360,10 +385,64 @@ char *test_default_item_destructor()
     return NULL;
 }
 
+char *test_default_item_destructor_inline_key()
+{
+    uint8_t buffer[sizeof(htable_item_base_t) + 3];
+    htable_item_base_t *item = (htable_item_base_t*)buffer;
+    item->key = buffer + sizeof(htable_item_base_t);
+    item->key_len = 3;
+    item->flags = HTABLE_ITEM_INLINE_KEY;
+    default_item_destructor(item);
+    ASSERTION(released_count == 1, "Expected: Memory was released 1 time!")
+    ASSERTION(mem_freed[0].mem == (uint8_t*)item, "Expected: Item was freed!")
+    return NULL;
+}
+
+char *test_default_item_destructor_arena()
+{
+    htable_item_base_t item = {(uint8_t*)"KEY", 3, HTABLE_ITEM_INLINE_KEY | HTABLE_ITEM_ARENA};
+    default_item_destructor(&item);
+    ASSERTION(memory_not_released, "Expected: Memory was not released!")
+    return NULL;
+}
+
+char *test_arena_alloc()
+{
+    htable_t *ht = &tgst.ht;
+
+    uint8_t *p1 = arena_alloc(ht, 10);
+    uint8_t *p2 = arena_alloc(ht, 20);
+    ASSERTION(allocated_count == 1, "Expected: Memory allocated 1 time!")
+    ASSERTION(mem_allocated[0].size == ARENA_HEADER_SIZE + HTABLE_ARENA_CHUNK_SIZE, "Expected: Chunk allocated!")
+    ASSERTION(p1 == mem_allocated[0].mem + ARENA_HEADER_SIZE, "Expected: First block at the chunk start!")
+    ASSERTION(p2 == p1 + ARENA_ALIGN(10), "Expected: Second block follows the first one!")
+
+    uint8_t *p3 = arena_alloc(ht, HTABLE_ARENA_CHUNK_SIZE);
+    ASSERTION(allocated_count == 2, "Expected: Memory allocated 2 times!")
+    ASSERTION(mem_allocated[1].size == ARENA_HEADER_SIZE + (HTABLE_ARENA_CHUNK_SIZE << 1), "Expected: Chunk size doubled!")
+    ASSERTION(p3 == mem_allocated[1].mem + ARENA_HEADER_SIZE, "Expected: Block in new chunk!")
+    DETECT_BUFFER_UNDERFLOW
+    DETECT_BUFFER_OVERFLOW
+
+    arena_destroy(ht);
+    ASSERTION(ht->arena == NULL, "Expected: Arena is empty!")
+    DETECT_MEMORY_LEAK
+    return NULL;
+}
+
+char *test_arena_alloc_fail()
+{
+    htable_t *ht = &tgst.ht;
+    allocation_error_emulation_flag = 1;
+    ASSERTION(arena_alloc(ht, 10) == NULL, "Expected: NULL!")
+    ASSERTION(ht->arena == NULL, "Expected: Arena is empty!")
+    return NULL;
+}
+
 char *test_compare_items_key_different_key_len()
 {
-    htable_item_base_t item1 = {(uint8_t*)"KEY", 3};
-    htable_item_base_t item2 = {(uint8_t*)"PKEY", 4};
+    htable_item_base_t item1 = {(uint8_t*)"KEY", 3, 0};
+    htable_item_base_t item2 = {(uint8_t*)"PKEY", 4, 0};
     bool res = compare_items_key(&item1, &item2);
     ASSERTION(res == false, "Expected: keys are not equal!")
     return NULL;
@@ -371,8 +450,8 @@ char *test_compare_items_key_different_key_len()
 
 char *test_compare_items_key_different_key()
 {
-    htable_item_base_t item1 = {(uint8_t*)"FKEY", 4};
-    htable_item_base_t item2 = {(uint8_t*)"PKEY", 4};
+    htable_item_base_t item1 = {(uint8_t*)"FKEY", 4, 0};
+    htable_item_base_t item2 = {(uint8_t*)"PKEY", 4, 0};
     bool res = compare_items_key(&item1, &item2);
     ASSERTION(res == false, "Expected: keys are not equal!")
     return NULL;
@@ -380,8 +459,8 @@ char *test_compare_items_key_different_key()
 
 char *test_compare_items_key_the_same_key()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PKEY", 4};
-    htable_item_base_t item2 = {(uint8_t*)"PKEY", 4};
+    htable_item_base_t item1 = {(uint8_t*)"PKEY", 4, 0};
+    htable_item_base_t item2 = {(uint8_t*)"PKEY", 4, 0};
     bool res = compare_items_key(&item1, &item2);
     ASSERTION(res == true, "Expected: keys are equal!")
     return NULL;
@@ -422,7 +501,7 @@ char *test_expand_empty_items()
     ASSERTION(allocated_count == 1, "Expected: Memory allocated one time!")
     ASSERTION(released_count == 1, "Expected: Memory released one time!")
     ASSERTION(mem_allocated[0].mem == (uint8_t *)ht->items, "Expected: Memory was allocated!")
-    ASSERTION(mem_allocated[0].size == ht->capacity * sizeof(htable_item_base_t*), "Expected: Other size of memory was allocated!")
+    ASSERTION(mem_allocated[0].size == ht->capacity * SLOT_SIZE, "Expected: Other size of memory was allocated!")
     ASSERTION(mem_freed[0].mem == (uint8_t*)tgst.arr, "Expected: Memory was freed!")
 
     htable_item_base_t *p[8] = {0};
@@ -433,8 +512,8 @@ char *test_expand_empty_items()
 
 char *test_expand()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->items[0] = marked_as_deleted;
@@ -449,21 +528,22 @@ char *test_expand()
     ASSERTION(allocated_count == 1, "Expected: Memory allocated one time!")
     ASSERTION(released_count == 1, "Expected: Memory released one time!")
     ASSERTION(mem_allocated[0].mem == (uint8_t *)ht->items, "Expected: Memory was allocated!")
-    ASSERTION(mem_allocated[0].size == ht->capacity * sizeof(htable_item_base_t*), "Expected: Other size of memory was allocated!")
+    ASSERTION(mem_allocated[0].size == ht->capacity * SLOT_SIZE, "Expected: Other size of memory was allocated!")
     ASSERTION(mem_freed[0].mem == (uint8_t*)tgst.arr, "Expected: Memory was released!")
     DETECT_BUFFER_UNDERFLOW
     DETECT_BUFFER_OVERFLOW
 
     htable_item_base_t *p[8] = {&item1, &item2, 0,0,0,0,0,0};
     ASSERTION(items_array_equal(ht, (htable_item_base_t*)p), "Expected: 2 first items.")
-    ASSERTION(tgst.hash_func_calls_count == 2, "Expected: Hash function was called 2 times!")
+    ASSERTION(ht->hashes == (uint32_t*)(ht->items + 8), "Expected: Hashes follow items!")
+    ASSERTION(tgst.hash_func_calls_count == 0, "Expected: Hash function was not called!")
     return NULL;
 }
 
 char *test_find_htable_full()
 {
-    htable_item_base_t item = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->items[0] = &item;
@@ -484,7 +564,7 @@ char *test_find_htable_full()
 
 char *test_find_nothing_found_1()
 {
-    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     size_t out_idx = 0;
@@ -498,8 +578,8 @@ char *test_find_nothing_found_1()
 
 char *test_find_nothing_found_2()
 {
-    htable_item_base_t item = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->items[0] = marked_as_deleted;
@@ -517,8 +597,8 @@ char *test_find_nothing_found_2()
 
 char *test_find_direct()
 {
-    htable_item_base_t item = {(uint8_t*)"ABC_KEY", 7};
-    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->items[0] = &item;
@@ -535,8 +615,8 @@ char *test_find_direct()
 
 char *test_find_relative_1()
 {
-    htable_item_base_t item = {(uint8_t*)"ABC_KEY", 7};
-    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->items[0] = marked_as_deleted;
@@ -555,9 +635,9 @@ char *test_find_relative_1()
 
 char *test_find_relative_2()
 {
-    htable_item_base_t item1 = {(uint8_t*)"ABC_KEY", 7};
-    htable_item_base_t item2 = {(uint8_t*)"FCC_KEY", 7};
-    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item1 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_item_base_t item2 = {(uint8_t*)"FCC_KEY", 7, 0};
+    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->items[0] = &item2;
@@ -574,6 +654,24 @@ char *test_find_relative_2()
     return NULL;
 }
 
+char *test_find_hash_mismatch()
+{
+    htable_item_base_t item = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_t *ht = &tgst.ht;
+
+    ht->items[0] = &item;
+    ht->hashes[0] = 7;  // Differs from hash of for_search, so key must not be compared
+    ht->items_count = 1;
+
+    size_t out_idx = 0;
+    bool res = find(ht, &for_search, &out_idx);
+
+    ASSERTION(res == false, "Expected: Nothing was found!")
+    ASSERTION(out_idx == 1, "Expected: out_index == 1!")
+    return NULL;
+}
+
 char *test_htable_status()
 {
     htable_status_t status;
@@ -612,13 +710,16 @@ char *test_htable_make()
     ASSERTION(ht->capacity == 8, "Expected: capacity == 8!")
     ASSERTION(ht->items_count == 0, "Expected: items_count == 0!")
     ASSERTION(ht->last_error == HTABLE_OK, "Expected: HTABLE_OK!")
-    ASSERTION(ht->hash_func == jenkins_one_at_a_time_hash, "Expected: default hash_function!")
+    ASSERTION(ht->hash_func == NULL, "Expected: No user's hash function!")
+    ASSERTION(ht->seeded_hash_func == word_hash, "Expected: default hash_function!")
+    ASSERTION(ht->seed == 0, "Expected: zero seed!")
     ASSERTION(ht->item_destructor == default_item_destructor, "Expected: default destructor!")
     ASSERTION(allocated_count == 2, "Expected: Memory allocated 1 times!")
     ASSERTION((uint8_t*)ht == mem_allocated[0].mem, "Expected: Memory for htable allocated!")
     ASSERTION(mem_allocated[0].size == sizeof(htable_t), "Expected: Allocated size equals size of htable_t!")
     ASSERTION((uint8_t*)ht->items == mem_allocated[1].mem, "Expected: Memory for items allocated!")
-    ASSERTION(mem_allocated[1].size == 8*sizeof(htable_item_base_t*), "Expected: Allocated size equals 8 size of htable_item_base_t* !")
+    ASSERTION(mem_allocated[1].size == 8*SLOT_SIZE, "Expected: Allocated size equals 8 slots!")
+    ASSERTION(ht->hashes == (uint32_t*)(ht->items + 8), "Expected: Hashes follow items!")
     return NULL;
 }
 
@@ -641,6 +742,24 @@ char *test_htable_make_with_specified_params()
     return NULL;
 }
 
+char *test_htable_make_ex()
+{
+    htable_t *ht;
+
+    ht = htable_make_ex(NULL);
+    ASSERTION(ht == NULL, "Expected: NULL!")
+
+    htable_options_t options = {16, const_hash_func, HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    ht = htable_make_ex(&options);
+    ASSERTION(ht != NULL, "Expected: not NULL!")
+    ASSERTION(ht->capacity == 16, "Expected: capacity == 16!")
+    ASSERTION(ht->hash_func == const_hash_func, "Expected: Specified hash function!")
+    ASSERTION(ht->flags == HTABLE_OPT_ARENA, "Expected: Arena option!")
+    ASSERTION(ht->arena == NULL, "Expected: Arena is allocated lazily!")
+    ASSERTION(allocated_count == 2, "Expected: Memory allocated 2 times!")
+    return NULL;
+}
+
 char *test_htable_make_calloc_fail()
 {
     htable_t *ht;
@@ -651,6 +770,56 @@ char *test_htable_make_calloc_fail()
     return NULL;
 }
 
+char *test_htable_make_ex_hash()
+{
+    htable_options_t options = {8, NULL, 0, HTABLE_HASH_JENKINS, 12345};
+    htable_t *ht = htable_make_ex(&options);
+    ASSERTION(ht->hash_func == NULL, "Expected: No user's hash function!")
+    ASSERTION(ht->seeded_hash_func == jenkins_one_at_a_time_hash, "Expected: Jenkins hash function!")
+    ASSERTION(ht->seed == 12345, "Expected: Specified seed!")
+
+    options.hash = HTABLE_HASH_CRC32C;
+    ht = htable_make_ex(&options);
+#ifdef HTABLE_HAVE_CRC32C
+    if (__builtin_cpu_supports("sse4.2"))
+        ASSERTION(ht->seeded_hash_func == crc32c_hash, "Expected: CRC32C hash function!")
+    else
+#endif
+        ASSERTION(ht->seeded_hash_func == word_hash, "Expected: Fallback to word hash function!")
+
+    options.flags = HTABLE_OPT_RANDOM_SEED;
+    htable_t *ht2 = htable_make_ex(&options);
+    ht = htable_make_ex(&options);
+    ASSERTION(ht->seed != 12345, "Expected: Specified seed is ignored!")
+    ASSERTION(ht->seed != ht2->seed, "Expected: Seeds of tables differ!")
+    return NULL;
+}
+
+char *test_builtin_hash_functions()
+{
+    const uint8_t *key = (const uint8_t*)"0123456789abcdef_tail";
+
+    ASSERTION(jenkins_one_at_a_time_hash((const uint8_t*)"a", 1, 0) == 0xca2e9442, "Expected: Jenkins hash of \"a\"!")
+
+    seeded_hash_func_t funcs[] = {
+        word_hash,
+#ifdef HTABLE_HAVE_CRC32C
+        __builtin_cpu_supports("sse4.2") ? crc32c_hash : word_hash,
+#endif
+    };
+    for (size_t i = 0; i < sizeof(funcs) / sizeof(funcs[0]); i++)
+    {
+        uint32_t hash = funcs[i](key, 21, 0);
+        ASSERTION(hash == funcs[i](key, 21, 0), "Expected: Hash is stable!")
+        ASSERTION(hash != funcs[i](key, 21, 1), "Expected: Seed changes hash!")
+        ASSERTION(hash != funcs[i](key, 20, 0), "Expected: Tail bytes change hash!")
+        ASSERTION(funcs[i](key, 16, 0) != funcs[i](key + 1, 16, 0), "Expected: Full words change hash!")
+        ASSERTION(funcs[i]((const uint8_t*)"a\0", 1, 0) != funcs[i]((const uint8_t*)"a\0", 2, 0),
+                  "Expected: Zero padding differs from zero byte!")
+    }
+    return NULL;
+}
+
 char *test_htable_set_wrong_parameters()
 {
     htable_t exp_ht, *act_ht;
@@ -664,11 +833,11 @@ char *test_htable_set_wrong_parameters()
     htable_set(act_ht, NULL, sizeof(htable_item_base_t));
     ASSERTION(htable_equal(&exp_ht, act_ht), "Expected: Hash table was not changed!")
 
-    htable_item_base_t item1 = {(uint8_t*)NULL, 0};
+    htable_item_base_t item1 = {(uint8_t*)NULL, 0, 0};
     htable_set(act_ht, &item1, sizeof(htable_item_base_t));
     ASSERTION(htable_equal(&exp_ht, act_ht), "Expected: Hash table was not changed!")
 
-    htable_item_base_t item2 = {(uint8_t*)"KEY", 3};
+    htable_item_base_t item2 = {(uint8_t*)"KEY", 3, 0};
     htable_set(act_ht, &item2, 1);
     ASSERTION(htable_equal(&exp_ht, act_ht), "Expected: Hash table was not changed!")
     return NULL;
@@ -676,7 +845,7 @@ char *test_htable_set_wrong_parameters()
 
 char *test_htable_set()
 {
-    htable_item_base_t item1 = {(uint8_t*)"KEY", 3};
+    htable_item_base_t item1 = {(uint8_t*)"KEY", 3, 0};
     htable_t *ht = &tgst.ht;
 
     htable_set(ht, &item1, sizeof(htable_item_base_t));
@@ -687,6 +856,68 @@ char *test_htable_set()
     ASSERTION(mem_allocated[1].mem == (uint8_t *)ht->items[0]->key, "Expected: Memory allocated for key!")
     ASSERTION(mem_allocated[1].size == 3, "Expected: Memory allocated size is 3!")
     ASSERTION(items_equal(ht->items[0], &item1), "Expected: Items are equal!")
+    ASSERTION(ht->hashes[0] == 0, "Expected: Hash was stored!")
+    DETECT_BUFFER_UNDERFLOW
+    DETECT_BUFFER_OVERFLOW
+    return NULL;
+}
+
+char *test_htable_set_inline_key()
+{
+    htable_item_base_t item1 = {(uint8_t*)"KEY", 3, 0};
+    htable_t *ht = &tgst.ht;
+
+    size_t prev = htable_set_inline_key_max(ht, 3);
+    ASSERTION(prev == 0, "Expected: Inline keys were disabled!")
+
+    htable_set(ht, &item1, sizeof(htable_item_base_t));
+    ASSERTION(allocated_count == 1, "Expected: Memory allocated 1 time!")
+    ASSERTION(ht->items_count == 1, "Expected: Item was added to hash table")
+    ASSERTION(mem_allocated[0].mem == (uint8_t *)ht->items[0], "Expected: Memory allocated!")
+    ASSERTION(mem_allocated[0].size == sizeof(htable_item_base_t) + 3, "Expected: Memory allocated size is sizeof(htable_base_t) + 3")
+    ASSERTION(ht->items[0]->key == (uint8_t *)ht->items[0] + sizeof(htable_item_base_t), "Expected: Key is stored after item!")
+    ASSERTION(ht->items[0]->flags == HTABLE_ITEM_INLINE_KEY, "Expected: Inline key flag was set!")
+    ASSERTION(items_equal(ht->items[0], &item1), "Expected: Items are equal!")
+    DETECT_BUFFER_UNDERFLOW
+    DETECT_BUFFER_OVERFLOW
+    return NULL;
+}
+
+char *test_htable_set_inline_key_too_long()
+{
+    htable_item_base_t item1 = {(uint8_t*)"LONG_KEY", 8, 0};
+    htable_t *ht = &tgst.ht;
+
+    htable_set_inline_key_max(ht, 4);
+    htable_set(ht, &item1, sizeof(htable_item_base_t));
+    ASSERTION(allocated_count == 2, "Expected: Memory allocated 2 times!")
+    ASSERTION(mem_allocated[1].mem == (uint8_t *)ht->items[0]->key, "Expected: Memory allocated for key!")
+    ASSERTION(ht->items[0]->flags == 0, "Expected: Inline key flag was not set!")
+    ASSERTION(items_equal(ht->items[0], &item1), "Expected: Items are equal!")
+    return NULL;
+}
+
+char *test_htable_set_arena()
+{
+    htable_item_base_t item1 = {(uint8_t*)"KEY", 3, 0};
+    htable_item_base_t item2 = {(uint8_t*)"KEY_2", 5, 0};
+    htable_t *ht = &tgst.ht;
+    ht->flags = HTABLE_OPT_ARENA;
+    ht->hash_func = const_hash_func_2;
+
+    htable_set(ht, &item1, sizeof(htable_item_base_t));
+    htable_set(ht, &item2, sizeof(htable_item_base_t));
+    ASSERTION(allocated_count == 1, "Expected: Memory allocated 1 time!")
+    ASSERTION(ht->items_count == 2, "Expected: Items were added to hash table")
+
+    uint8_t *chunk_data = mem_allocated[0].mem + ARENA_HEADER_SIZE;
+    ASSERTION((uint8_t *)ht->items[3] == chunk_data, "Expected: Item 1 allocated from arena!")
+    ASSERTION(ht->items[3]->key == chunk_data + sizeof(htable_item_base_t), "Expected: Key 1 is stored after item!")
+    ASSERTION(ht->items[3]->flags == (HTABLE_ITEM_INLINE_KEY | HTABLE_ITEM_ARENA), "Expected: Arena flags were set!")
+    ASSERTION((uint8_t *)ht->items[0] == chunk_data + ARENA_ALIGN(sizeof(htable_item_base_t) + 3), "Expected: Item 2 allocated from arena!")
+    ASSERTION(items_equal(ht->items[3], &item1), "Expected: Items are equal!")
+    ASSERTION(items_equal(ht->items[0], &item2), "Expected: Items are equal!")
+    ASSERTION(ht->hashes[3] == 3 && ht->hashes[0] == 3, "Expected: Hashes were stored!")
     DETECT_BUFFER_UNDERFLOW
     DETECT_BUFFER_OVERFLOW
     return NULL;
@@ -694,7 +925,7 @@ char *test_htable_set()
 
 char *test_htable_set_full()
 {
-    htable_item_base_t item1 = {(uint8_t*)"KEY", 3};
+    htable_item_base_t item1 = {(uint8_t*)"KEY", 3, 0};
     htable_t exp_ht, *act_ht = &tgst.ht;
 
     act_ht->last_error = HTABLE_FULL;
@@ -708,7 +939,7 @@ char *test_htable_set_full()
 
 char *test_htable_set_mem_fail_1()
 {
-    htable_item_base_t item1 = {(uint8_t*)"KEY", 3};
+    htable_item_base_t item1 = {(uint8_t*)"KEY", 3, 0};
     htable_t *ht = &tgst.ht;
 
     allocation_error_emulation_after_nth_calls = 1;
@@ -722,7 +953,7 @@ char *test_htable_set_mem_fail_1()
 
 char *test_htable_set_mem_fail_2()
 {
-    htable_item_base_t item1 = {(uint8_t*)"KEY", 3};
+    htable_item_base_t item1 = {(uint8_t*)"KEY", 3, 0};
     htable_t *ht = &tgst.ht;
 
     allocation_error_emulation_flag = 1;
@@ -736,7 +967,7 @@ char *test_htable_set_mem_fail_2()
 
 char *test_htable_set_change_item()
 {
-    htable_item_base_t item1 = {(uint8_t*)"KEY", 3};
+    htable_item_base_t item1 = {(uint8_t*)"KEY", 3, 0};
     htable_t *ht = &tgst.ht;
     ht->items[0] = &item1;
     ht->items_count = 1;
@@ -757,9 +988,9 @@ char *test_htable_set_change_item()
 
 char *test_htable_set_expand()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
-    htable_item_base_t item3 = {(uint8_t*)"ABCD_KEY", 8};
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_item_base_t item3 = {(uint8_t*)"ABCD_KEY", 8, 0};
     htable_t *ht = &tgst.ht;
 
     ht->items[0] = marked_as_deleted;
@@ -767,8 +998,9 @@ char *test_htable_set_expand()
     ht->items[2] = &item3;
     ht->items[3] = &item2;
     ht->items_count = 3;
+    ht->deleted_count = 1;
 
-    htable_item_base_t item4 = {(uint8_t*)"4PT_KEY", 7};
+    htable_item_base_t item4 = {(uint8_t*)"4PT_KEY", 7, 0};
     htable_set(ht, &item4, sizeof(htable_item_base_t));
     ASSERTION(ht->capacity == 8, "Expected: Capacity == 8!")
     ASSERTION(items_equal(ht->items[0], &item1), "Expected: item1!")
@@ -779,6 +1011,130 @@ char *test_htable_set_expand()
     return NULL;
 }
 
+char *test_htable_upsert_wrong_parameters()
+{
+    htable_t exp_ht, *act_ht;
+    act_ht = &tgst.ht;
+
+    memcpy(&exp_ht, act_ht, sizeof(htable_t));
+
+    ASSERTION(htable_upsert(NULL, NULL, sizeof(htable_item_base_t), NULL) == NULL, "Expected: NULL!")
+    ASSERTION(htable_upsert(act_ht, NULL, sizeof(htable_item_base_t), NULL) == NULL, "Expected: NULL!")
+
+    htable_item_base_t item1 = {(uint8_t*)NULL, 0, 0};
+    ASSERTION(htable_upsert(act_ht, &item1, sizeof(htable_item_base_t), NULL) == NULL, "Expected: NULL!")
+
+    htable_item_base_t item2 = {(uint8_t*)"KEY", 3, 0};
+    ASSERTION(htable_upsert(act_ht, &item2, 1, NULL) == NULL, "Expected: NULL!")
+    ASSERTION(htable_equal(&exp_ht, act_ht), "Expected: Hash table was not changed!")
+    ASSERTION(memory_not_allocated, "Expected: Memory was not allocated!")
+    return NULL;
+}
+
+char *test_htable_upsert_insert()
+{
+    struct counter_item {
+        htable_item_base_t base;
+        size_t val;
+    } item1 = {{(uint8_t*)"KEY", 3, 0}, 5};
+    htable_t *ht = &tgst.ht;
+    bool inserted = false;
+
+    htable_item_base_t *res = htable_upsert(ht, &item1.base, sizeof(item1), &inserted);
+    ASSERTION(res == ht->items[0], "Expected: Inserted item returned!")
+    ASSERTION(inserted, "Expected: Inserted flag was set!")
+    ASSERTION(ht->last_error == HTABLE_OK, "Expected: OK status!")
+    ASSERTION(ht->items_count == 1, "Expected: Item was added to hash table")
+    ASSERTION(allocated_count == 2, "Expected: Memory allocated 2 times!")
+    ASSERTION(mem_allocated[0].size == sizeof(item1), "Expected: Memory allocated size is sizeof(item)")
+    ASSERTION(items_equal(res, &item1.base), "Expected: Items are equal!")
+    ASSERTION(((struct counter_item*)res)->val == 5, "Expected: Item was initialized from caller item!")
+    ASSERTION(tgst.hash_func_calls_count == 1, "Expected: Hash function was called 1 time!")
+    DETECT_BUFFER_UNDERFLOW
+    DETECT_BUFFER_OVERFLOW
+    return NULL;
+}
+
+char *test_htable_upsert_existing()
+{
+    htable_item_base_t item1 = {(uint8_t*)"KEY", 3, 0};
+    htable_item_base_t item2 = {(uint8_t*)"KEY", 3, 0};
+    htable_t *ht = &tgst.ht;
+    ht->items[0] = &item1;
+    ht->items_count = 1;
+    bool inserted = true;
+
+    htable_item_base_t *res = htable_upsert(ht, &item2, sizeof(htable_item_base_t), &inserted);
+    ASSERTION(res == &item1, "Expected: Stored item returned!")
+    ASSERTION(!inserted, "Expected: Inserted flag was not set!")
+    ASSERTION(ht->last_error == HTABLE_OK, "Expected: OK status!")
+    ASSERTION(ht->items_count == 1, "Expected: Item count not changed!")
+    ASSERTION(tgst.destructor_calls_count == 0, "Expected: Item destructor was not called!")
+    ASSERTION(memory_not_allocated, "Expected: Memory was not allocated!")
+    ASSERTION(tgst.hash_func_calls_count == 1, "Expected: Hash function was called 1 time!")
+    return NULL;
+}
+
+char *test_htable_upsert_existing_no_grow()
+{
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_item_base_t item3 = {(uint8_t*)"ABCD_KEY", 8, 0};
+    htable_t *ht = &tgst.ht;
+    ht->items[0] = &item1;
+    ht->items[1] = &item2;
+    ht->items[2] = &item3;
+    ht->items_count = 3;
+
+    htable_item_base_t *res = htable_upsert(ht, &item2, sizeof(htable_item_base_t), NULL);
+    ASSERTION(res == &item2, "Expected: Stored item returned!")
+    ASSERTION(ht->capacity == 4, "Expected: Hash table was not expanded on hit!")
+    ASSERTION(memory_not_allocated, "Expected: Memory was not allocated!")
+
+    htable_item_base_t item4 = {(uint8_t*)"4PT_KEY", 7, 0};
+    res = htable_upsert(ht, &item4, sizeof(htable_item_base_t), NULL);
+    ASSERTION(ht->capacity == 8, "Expected: Capacity == 8!")
+    ASSERTION(ht->items_count == 4, "Expected: Item was added to hash table")
+    ASSERTION(res == ht->items[3] && items_equal(res, &item4), "Expected: item4!")
+    return NULL;
+}
+
+char *test_htable_upsert_mem_fail()
+{
+    htable_item_base_t item1 = {(uint8_t*)"KEY", 3, 0};
+    htable_t *ht = &tgst.ht;
+    bool inserted = true;
+
+    allocation_error_emulation_after_nth_calls = 1;
+    ASSERTION(htable_upsert(ht, &item1, sizeof(htable_item_base_t), &inserted) == NULL, "Expected: NULL!")
+    ASSERTION(ht->last_error == HTABLE_MEM_ERROR, "Expected: Mem error status!")
+    ASSERTION(ht->items_count == 0, "Expected: Item count not changed!")
+    ASSERTION(ht->items[0] == NULL, "Expected: Slot is empty!")
+    DETECT_MEMORY_LEAK
+    return NULL;
+}
+
+char *test_htable_hashed()
+{
+    htable_item_base_t item1 = {(uint8_t*)"KEY", 3, 0}, *out_item = NULL;
+    htable_t *ht = &tgst.ht;
+    uint32_t hash = htable_hash(ht, item1.key, item1.key_len);
+    bool inserted = false;
+
+    tgst.hash_func_calls_count = 0;
+    htable_set_hashed(ht, &item1, sizeof(item1), hash);
+    ASSERTION(ht->items_count == 1, "Expected: Item was added to hash table")
+    ASSERTION(htable_upsert_hashed(ht, &item1, sizeof(item1), hash, &inserted) == ht->items[0],
+              "Expected: Stored item returned!")
+    ASSERTION(!inserted, "Expected: Item was found!")
+    ASSERTION(htable_find_hashed(ht, &item1, hash, &out_item) && out_item == ht->items[0], "Expected: Item was found!")
+    ASSERTION(htable_remove_hashed(ht, &item1, hash), "Expected: Item was removed!")
+    ASSERTION(!htable_find_hashed(ht, &item1, hash, NULL), "Expected: Item was not found!")
+    ASSERTION(tgst.hash_func_calls_count == 0, "Expected: Hash function was not called!")
+    DETECT_MEMORY_LEAK
+    return NULL;
+}
+
 char *test_htable_destroy_wrong_param()
 {
     htable_t exp_ht, *act_ht;
@@ -794,9 +1150,9 @@ char *test_htable_destroy_wrong_param()
 
 char *test_htable_destroy()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
-    htable_item_base_t item3 = {(uint8_t*)"ABCD_KEY", 8};
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_item_base_t item3 = {(uint8_t*)"ABCD_KEY", 8, 0};
     htable_t *ht = &tgst.ht;
 
     ht->items[0] = marked_as_deleted;
@@ -819,103 +1175,1162 @@ char *test_htable_destroy()
     return NULL;
 }
 
-int enum_callback(htable_item_base_t *item)
+char *test_htable_destroy_arena()
 {
-    tgst.enumerated[tgst.enum_callback_calls_count++] = item;
-    return 1;
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_options_t options = {8, NULL, HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+
+    htable_set(ht, &item1, sizeof(htable_item_base_t));
+    htable_set(ht, &item2, sizeof(htable_item_base_t));
+    htable_item_base_t *popped = htable_pop(ht, &item1);
+    ASSERTION(popped != NULL && items_equal(popped, &item1), "Expected: item1 was popped!")
+    ASSERTION(memory_not_released, "Expected: Memory was not released!")
+
+    htable_destroy(ht);
+    ASSERTION(allocated_count == 3, "Expected: Memory allocated 3 times!")
+    ASSERTION(released_count == 3, "Expected: Memory was released 3 times!")
+    ASSERTION(mem_freed[0].mem == mem_allocated[2].mem, "Expected: arena released!")
+    DETECT_MEMORY_LEAK
+    return NULL;
 }
 
-int enum_callback_stop(htable_item_base_t *item)
+struct swiss_fixture {
+    htable_item_base_t *items[SWISS_GROUP_SIZE];
+    uint32_t hashes[SWISS_GROUP_SIZE];
+    uint8_t ctrl[SWISS_GROUP_SIZE];
+} sw;
+
+htable_t *set_up_swiss(uint8_t ctrl)
 {
-    tgst.enumerated[tgst.enum_callback_calls_count++] = item;
-    return 0;
+    htable_t *ht = &tgst.ht;
+    memset(&sw, 0, sizeof(sw));
+    memset(sw.ctrl, ctrl, SWISS_GROUP_SIZE);
+    ht->flags = HTABLE_OPT_SWISS;
+    ht->capacity = SWISS_GROUP_SIZE;
+    ht->items = sw.items;
+    ht->hashes = sw.hashes;
+    ht->ctrl = sw.ctrl;
+    return ht;
 }
 
-char *test_htable_enumerate_items_wrong_params()
+char *test_htable_make_ex_swiss()
 {
-    htable_enumerate_items(NULL, enum_callback);
-    ASSERTION(tgst.enum_callback_calls_count == 0, "Expected: Callback was not called!")
-    htable_enumerate_items(&tgst.ht, NULL);
-    ASSERTION(tgst.enum_callback_calls_count == 0, "Expected: Callback was not called!")
+    htable_options_t options = {20, NULL, HTABLE_OPT_SWISS, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    ASSERTION(ht != NULL, "Expected: not NULL!")
+    ASSERTION(ht->capacity == 32, "Expected: capacity == 32!")
+    ASSERTION(mem_allocated[1].size == 32 * SWISS_SLOT_SIZE, "Expected: Allocated size equals 32 slots!")
+    ASSERTION(ht->ctrl == (uint8_t*)(ht->hashes + 32), "Expected: Control bytes follow hashes!")
+    for (size_t i = 0; i < 32; i++)
+        ASSERTION(ht->ctrl[i] == CTRL_EMPTY, "Expected: All slots are empty!")
     return NULL;
 }
 
-char *test_htable_enumerate_items()
+char *test_swiss_find_full()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
-    htable_t *ht = &tgst.ht;
-
-    ht->items[0] = marked_as_deleted;
-    ht->items[1] = &item1;
-    ht->items[2] = marked_as_deleted;
-    ht->items[3] = &item2;
-    ht->items_count = 2;
+    htable_item_base_t item = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_t *ht = set_up_swiss(H2(0));
+    for (size_t i = 0; i < SWISS_GROUP_SIZE; i++)
+        ht->items[i] = &item;
+    ht->items_count = SWISS_GROUP_SIZE;
 
-    htable_enumerate_items(ht, enum_callback);
-    ASSERTION(tgst.enum_callback_calls_count == 2, "Expected: Callback was called 2 times!")
-    ASSERTION(tgst.enumerated[0] == &item1, "Expected: item1 was enumerated!")
-    ASSERTION(tgst.enumerated[1] == &item2, "Expected: item2 was enumerated!")
+    size_t out_idx = 0;
+    bool res = find(ht, &for_search, &out_idx);
+    ASSERTION(res == false, "Expected: Nothing was found!")
+    ASSERTION(ht->last_error == HTABLE_FULL, "Expected: last_error is HTABLE_FULL!")
+    ASSERTION(tgst.hash_func_calls_count == 1, "Expected: Hash function was called!")
     return NULL;
 }
 
-char *test_htable_enumerate_items_stop()
+char *test_swiss_find_deleted()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
-    htable_t *ht = &tgst.ht;
+    htable_item_base_t item = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_item_base_t for_search = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_t *ht = set_up_swiss(CTRL_DELETED);
+    ht->ctrl[5] = H2(0);
+    ht->items[5] = &item;
+    ht->items_count = 1;
 
-    ht->items[0] = marked_as_deleted;
-    ht->items[1] = &item1;
-    ht->items[2] = marked_as_deleted;
-    ht->items[3] = &item2;
-    ht->items_count = 2;
+    size_t out_idx = 0;
+    bool res = find(ht, &for_search, &out_idx);
+    ASSERTION(res == true, "Expected: Item was found!")
+    ASSERTION(out_idx == 5, "Expected: out_index == 5!")
 
-    htable_enumerate_items(ht, enum_callback_stop);
-    ASSERTION(tgst.enum_callback_calls_count == 1, "Expected: Callback was called 1 times!")
-    ASSERTION(tgst.enumerated[0] == &item1, "Expected: item1 was enumerated!")
+    res = find(ht, &(htable_item_base_t){(uint8_t*)"KEY", 3, 0}, &out_idx);
+    ASSERTION(res == false, "Expected: Nothing was found!")
+    ASSERTION(ht->last_error != HTABLE_FULL, "Expected: last_error is not HTABLE_FULL!")
+    ASSERTION(out_idx == 0, "Expected: out_index is the first deleted slot!")
     return NULL;
 }
 
-char *test_htable_find_wrong_params()
+char *test_swiss_clear_slot()
 {
-    htable_t *ht = &tgst.ht;
-    htable_item_base_t item = {NULL, 0};
-    bool res;
+    htable_item_base_t item = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_t *ht = set_up_swiss(H2(0));
+    ht->items[3] = &item;
 
-    res = htable_find(NULL, NULL, NULL);
-    ASSERTION(res == false, "Expected: Nothing was found!")
-    res = htable_find(ht, NULL, NULL);
-    ASSERTION(res == false, "Expected: Nothing was found!")
-    res = htable_find(ht, &item, NULL);
-    ASSERTION(res == false, "Expected: Nothing was found!")
+    clear_slot(ht, 3);
+    ASSERTION(ht->ctrl[3] == CTRL_DELETED, "Expected: Slot was marked as deleted!")
+    ASSERTION(ht->items[3] == NULL, "Expected: Item was removed!")
+    ASSERTION(ht->deleted_count == 1, "Expected: deleted count == 1!")
+
+    ht->items[4] = &item;
+    clear_slot(ht, 4);
+    ASSERTION(ht->ctrl[4] == CTRL_DELETED, "Expected: Slot was marked as deleted!")
+
+    ht->ctrl[0] = CTRL_EMPTY;
+    ht->items[7] = &item;
+    clear_slot(ht, 7);
+    ASSERTION(ht->ctrl[7] == CTRL_EMPTY, "Expected: Slot became empty, group has empty slot!")
+    ASSERTION(ht->deleted_count == 2, "Expected: deleted count == 2!")
+
+    insert_slot(ht, 3, &item, 0x105);
+    ASSERTION(ht->ctrl[3] == H2(0x105), "Expected: Control byte has 7 bits of hash!")
+    ASSERTION(ht->hashes[3] == 0x105, "Expected: Hash was stored!")
+    ASSERTION(ht->deleted_count == 1, "Expected: deleted count == 1!")
     return NULL;
 }
 
-char *test_htable_find()
+char *test_swiss_functional()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
-    htable_t *ht = &tgst.ht;
+    htable_options_t options = {16, const_hash_func, HTABLE_OPT_SWISS | HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
 
-    ht->items[0] = marked_as_deleted;
-    ht->items[1] = &item1;
-    ht->items[2] = marked_as_deleted;
-    ht->items[3] = &item2;
-    ht->items_count = 2;
+    char keys[20][4];
+    htable_item_base_t item;
+    for (size_t i = 0; i < 20; i++)
+    {
+        snprintf(keys[i], sizeof(keys[i]), "K%zu", i);
+        item = (htable_item_base_t){(uint8_t*)keys[i], strlen(keys[i]), 0};
+        htable_set(ht, &item, sizeof(htable_item_base_t));
+        ASSERTION(ht->last_error == HTABLE_OK, "Expected: Item was added!")
+    }
+    ASSERTION(ht->items_count == 20, "Expected: items count == 20!")
+    ASSERTION(ht->capacity == 32, "Expected: capacity == 32!")
 
-    htable_item_base_t *out = NULL;
-    bool res = htable_find(ht, &item2, &out);
-    ASSERTION(res == true, "Expected: Item was found!")
-    ASSERTION(out != NULL, "Expected: Out parameter is not NULL!")
-    ASSERTION(items_equal(out, &item2), "Expected: Out parameter is item2!")
+    item = (htable_item_base_t){(uint8_t*)keys[3], strlen(keys[3]), 0};
+    ASSERTION(htable_remove(ht, &item) == true, "Expected: Item was removed!")
+    ASSERTION(htable_find(ht, &item, NULL) == false, "Expected: Item was not found!")
+    for (size_t i = 0; i < 20; i++)
+    {
+        item = (htable_item_base_t){(uint8_t*)keys[i], strlen(keys[i]), 0};
+        ASSERTION(i == 3 || htable_find(ht, &item, NULL), "Expected: Item was found!")
+    }
+
+    htable_destroy(ht);
+    DETECT_MEMORY_LEAK
+    DETECT_BUFFER_UNDERFLOW
+    DETECT_BUFFER_OVERFLOW
     return NULL;
 }
 
-char *test_htable_find_no_out_item()
+char *test_htable_set_cleanup_deleted()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_t *ht = &tgst.ht;
+
+    ht->items[0] = marked_as_deleted;
+    ht->items[1] = &item1;
+    ht->items[2] = marked_as_deleted;
+    ht->items_count = 1;
+    ht->deleted_count = 2;
+
+    htable_set(ht, &item2, sizeof(htable_item_base_t));
+    ASSERTION(ht->last_error == HTABLE_OK, "Expected: Item was added!")
+    ASSERTION(ht->capacity == 4, "Expected: Capacity was not changed!")
+    ASSERTION(ht->deleted_count == 0, "Expected: Deleted marks were cleaned up!")
+    ASSERTION(ht->items_count == 2, "Expected: items count == 2!")
+    ASSERTION(ht->items[0] == &item1, "Expected: item1 was moved to its home slot!")
+    ASSERTION(items_equal(ht->items[1], &item2), "Expected: item2 was added!")
+    ASSERTION(ht->items[2] == NULL && ht->items[3] == NULL, "Expected: No deleted marks!")
+    return NULL;
+}
+
+char *test_robin_hood_find()
+{
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_item_base_t for_search = {(uint8_t*)"HHH", 3, 0};
+    htable_t *ht = &tgst.ht;
+    ht->flags = HTABLE_OPT_ROBIN_HOOD;
+
+    ht->items[0] = &item1;  // home slot 0
+    ht->items[1] = &item2;  // home slot 1
+    ht->hashes[1] = 1;
+    ht->items_count = 2;
+
+    size_t out_idx = 0;
+    bool res = find(ht, &for_search, &out_idx);
+    ASSERTION(res == false, "Expected: Nothing was found!")
+    ASSERTION(out_idx == 1, "Expected: Probing stopped at richer item!")
+
+    res = find(ht, &item1, &out_idx);
+    ASSERTION(res == true, "Expected: Item was found!")
+    ASSERTION(out_idx == 0, "Expected: out_index == 0!")
+    return NULL;
+}
+
+char *test_robin_hood_insert()
+{
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_item_base_t item3 = {(uint8_t*)"HHH", 3, 0};
+    htable_t *ht = &tgst.ht;
+    ht->flags = HTABLE_OPT_ROBIN_HOOD;
+
+    ht->items[0] = &item1;
+    ht->items[1] = &item2;
+    ht->hashes[1] = 1;
+    ht->items_count = 2;
+
+    htable_set(ht, &item3, sizeof(htable_item_base_t));
+    ASSERTION(ht->items_count == 3, "Expected: items count == 3!")
+    ASSERTION(ht->items[0] == &item1, "Expected: item1 stays in its home slot!")
+    ASSERTION(items_equal(ht->items[1], &item3), "Expected: item3 took slot of richer item!")
+    ASSERTION(ht->hashes[1] == 0, "Expected: hash of item3 was stored!")
+    ASSERTION(ht->items[2] == &item2 && ht->hashes[2] == 1, "Expected: item2 was shifted!")
+    return NULL;
+}
+
+char *test_robin_hood_remove()
+{
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_item_base_t item3 = {(uint8_t*)"HHH", 3, 0};
+    htable_t *ht = &tgst.ht;
+    ht->flags = HTABLE_OPT_ROBIN_HOOD;
+
+    ht->items[0] = &item1;  // home slot 0
+    ht->items[1] = &item3;  // home slot 0
+    ht->items[2] = &item2;  // home slot 1
+    ht->hashes[2] = 1;
+    ht->items_count = 3;
+
+    htable_item_base_t *res = htable_pop(ht, &item1);
+    ASSERTION(res == &item1, "Expected: Item was found!")
+    ASSERTION(ht->items[0] == &item3, "Expected: item3 was shifted back!")
+    ASSERTION(ht->items[1] == &item2 && ht->hashes[1] == 1, "Expected: item2 was shifted back!")
+    ASSERTION(ht->items[2] == NULL, "Expected: No deleted marks!")
+    ASSERTION(ht->items_count == 2, "Expected: items count == 2!")
+    ASSERTION(ht->deleted_count == 0, "Expected: deleted count == 0!")
+    return NULL;
+}
+
+char *test_robin_hood_churn()
+{
+    htable_options_t options = {8, NULL, HTABLE_OPT_ROBIN_HOOD | HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
+
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"AT_KEY_2", 8, 0};
+    htable_item_base_t item3 = {(uint8_t*)"CC_KEY_22", 9, 0};
+    htable_item_base_t churn = {(uint8_t*)"CHURN", 5, 0};
+    htable_set(ht, &item1, sizeof(htable_item_base_t));
+    htable_set(ht, &item2, sizeof(htable_item_base_t));
+    htable_set(ht, &item3, sizeof(htable_item_base_t));
+
+    for (int i = 0; i < 20; i++)
+    {
+        htable_set(ht, &churn, sizeof(htable_item_base_t));
+        ASSERTION(htable_remove(ht, &churn) == true, "Expected: Item was removed!")
+    }
+    ASSERTION(ht->capacity == 8, "Expected: capacity == 8!")
+    ASSERTION(ht->items_count == 3, "Expected: items count == 3!")
+    for (size_t i = 0; i < ht->capacity; i++)
+        ASSERTION(ht->items[i] != marked_as_deleted, "Expected: No deleted marks!")
+    ASSERTION(htable_find(ht, &item1, NULL), "Expected: Item was found!")
+    ASSERTION(htable_find(ht, &item2, NULL), "Expected: Item was found!")
+    ASSERTION(htable_find(ht, &item3, NULL), "Expected: Item was found!")
+    ASSERTION(!htable_find(ht, &churn, NULL), "Expected: Item was not found!")
+
+    htable_destroy(ht);
+    DETECT_MEMORY_LEAK
+    return NULL;
+}
+
+char *test_htable_make_ex_wrong_options()
+{
+    htable_options_t options = {8, NULL, HTABLE_OPT_ROBIN_HOOD | HTABLE_OPT_SWISS, HTABLE_HASH_WORD, 0};
+    ASSERTION(htable_make_ex(&options) == NULL, "Expected: NULL!")
+    options.flags = HTABLE_OPT_INCREMENTAL | HTABLE_OPT_SWISS;
+    ASSERTION(htable_make_ex(&options) == NULL, "Expected: NULL!")
+    options.flags = HTABLE_OPT_DENSE | HTABLE_OPT_SWISS;
+    ASSERTION(htable_make_ex(&options) == NULL, "Expected: NULL!")
+    options.flags = HTABLE_OPT_DENSE | HTABLE_OPT_ROBIN_HOOD;
+    ASSERTION(htable_make_ex(&options) == NULL, "Expected: NULL!")
+    options.flags = HTABLE_OPT_DENSE | HTABLE_OPT_INCREMENTAL;
+    ASSERTION(htable_make_ex(&options) == NULL, "Expected: NULL!")
+    options.flags = 0;
+    options.hash = HTABLE_HASH_JENKINS + 1;
+    ASSERTION(htable_make_ex(&options) == NULL, "Expected: NULL!")
+    ASSERTION(memory_not_allocated, "Expected: Memory was not allocated!")
+    return NULL;
+}
+
+char *test_dense_make()
+{
+    htable_options_t options = {8, NULL, HTABLE_OPT_DENSE, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
+    ASSERTION(ht->items == NULL, "Expected: No item slots!")
+    ASSERTION(mem_allocated[1].size == 8 * DENSE_SLOT_SIZE, "Expected: Slots are positions and hashes!")
+    ASSERTION(mem_allocated[2].size == DENSE_CAPACITY(8) * sizeof(dense_entry_t), "Expected: Dense array!")
+    ASSERTION(ht->hashes == ht->positions + 8, "Expected: Hashes follow positions!")
+    htable_destroy(ht);
+    DETECT_MEMORY_LEAK
+
+    reset_mem();
+    allocation_error_emulation_after_nth_calls = 2;
+    ASSERTION(htable_make_ex(&options) == NULL, "Expected: NULL!")
+    DETECT_MEMORY_LEAK
+    return NULL;
+}
+
+static int enum_callback_ctx(htable_item_base_t *item, void *ctx)
+{
+    htable_item_base_t **enumerated = ctx;
+    enumerated[tgst.enum_callback_calls_count++] = item;
+    return 1;
+}
+
+char *test_dense_functional()
+{
+    htable_options_t options = {8, NULL, HTABLE_OPT_DENSE | HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
+
+    char keys[6][4];
+    htable_item_base_t items[6], *enumerated[6], *out;
+    for (size_t i = 0; i < 6; i++)
+    {
+        snprintf(keys[i], sizeof(keys[i]), "K%zu", i);
+        items[i] = (htable_item_base_t){(uint8_t*)keys[i], strlen(keys[i]), 0};
+        htable_set(ht, &items[i], sizeof(htable_item_base_t));
+    }
+    ASSERTION(ht->capacity == 16, "Expected: Table grew!")
+
+    ASSERTION(htable_remove(ht, &items[3]), "Expected: Item was removed!")
+    ASSERTION(htable_pop(ht, &items[0]) != NULL, "Expected: Item was popped!")
+    htable_set(ht, &items[5], sizeof(htable_item_base_t));  // Replaced item keeps its position
+    htable_set(ht, &items[0], sizeof(htable_item_base_t));  // Inserted again, goes to the end
+    ASSERTION(ht->items_count == 5, "Expected: items count == 5!")
+    ASSERTION(ht->dense_count == 7, "Expected: Removed items are holes in dense array!")
+    ASSERTION(!htable_find(ht, &items[3], NULL), "Expected: Item was not found!")
+
+    ASSERTION(htable_enumerate_items_ex(ht, enum_callback_ctx, enumerated), "Expected: Enumeration wasn't stopped!")
+    ASSERTION(tgst.enum_callback_calls_count == 5, "Expected: Callback was called 5 times!")
+    const size_t order[5] = {1, 2, 4, 5, 0};
+    for (size_t i = 0; i < 5; i++)
+    {
+        ASSERTION(htable_find(ht, &items[order[i]], &out), "Expected: Item was found!")
+        ASSERTION(enumerated[i] == out, "Expected: Items are enumerated in insertion order!")
+    }
+
+    // Churn: holes are squeezed out by rehash, dense array doesn't grow
+    for (int i = 0; i < 15; i++)
+    {
+        htable_set(ht, &items[3], sizeof(htable_item_base_t));
+        ASSERTION(htable_remove(ht, &items[3]), "Expected: Item was removed!")
+    }
+    ASSERTION(ht->capacity == 32, "Expected: capacity == 32!")
+    ASSERTION(ht->dense_count <= DENSE_CAPACITY(ht->capacity), "Expected: Dense array is not overflowed!")
+    ASSERTION(htable_status(ht) == HTABLE_OK, "Expected: HTABLE_OK!")
+
+    tgst.enum_callback_calls_count = 0;
+    htable_enumerate_items_ex(ht, enum_callback_ctx, enumerated);
+    ASSERTION(tgst.enum_callback_calls_count == 5, "Expected: Callback was called 5 times!")
+    for (size_t i = 0; i < 5; i++)
+        ASSERTION(items_equal(enumerated[i], &items[order[i]]), "Expected: Insertion order is kept by rehash!")
+
+    const htable_item_base_t *batch[3] = {&items[3], &items[0], &items[5]};
+    htable_item_base_t *batch_out[3];
+    ASSERTION(htable_find_batch(ht, batch, 3, batch_out) == 2, "Expected: 2 items were found!")
+    ASSERTION(batch_out[0] == NULL && batch_out[1] == enumerated[4], "Expected: Found items!")
+
+    htable_destroy(ht);
+    DETECT_MEMORY_LEAK
+    return NULL;
+}
+
+char *test_dense_destroy()
+{
+    htable_options_t options = {8, NULL, HTABLE_OPT_DENSE, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_set(ht, &item1, sizeof(htable_item_base_t));
+    htable_set(ht, &item2, sizeof(htable_item_base_t));
+    ASSERTION(htable_remove(ht, &item1), "Expected: Item was removed!")
+
+    htable_set_item_destructor(ht, mock_item_destructor);
+    htable_destroy(ht);
+    ASSERTION(tgst.destructor_calls_count == 1, "Expected: Destructor was called for live item only!")
+    return NULL;
+}
+
+#define POOL_SIZE 4096
+#define POOL_MAX_SIZE (1 << 18)
+
+// Bump allocator counting calls, tables of one test share it
+struct counting_pool
+{
+    uint8_t *mem;
+    size_t size;
+    size_t used;
+    size_t allocs;
+    size_t frees;
+};
+
+static _Alignas(max_align_t) uint8_t pool_mem[POOL_MAX_SIZE];
+
+static void pool_init(struct counting_pool *pool, size_t size)
+{
+    *pool = (struct counting_pool){pool_mem, size, 0, 0, 0};
+}
+
+void *pool_alloc(size_t size, void *ctx)
+{
+    struct counting_pool *pool = ctx;
+    size = (size + 15) & ~(size_t)15;
+    if (pool->size - pool->used < size)
+        return NULL;
+    pool->allocs++;
+    pool->used += size;
+    return pool->mem + pool->used - size;
+}
+
+void pool_free(void *p, void *ctx)
+{
+    struct counting_pool *pool = ctx;
+    if ((uint8_t*)p >= pool->mem && (uint8_t*)p < pool->mem + pool->size)
+        pool->frees++;
+}
+
+/**
+ * Table taking all memory from the pool.
+ */
+static htable_t *make_pool_table(struct counting_pool *pool, uint32_t flags, uint64_t seed)
+{
+    htable_options_t options = {0, NULL, flags, HTABLE_HASH_WORD, seed};
+    htable_allocator_t allocator = {pool_alloc, pool_free, pool};
+    return htable_make_alloc(&options, &allocator);
+}
+
+#define LAYOUTS_COUNT 5
+static const uint32_t layouts[LAYOUTS_COUNT] = {
+    0, HTABLE_OPT_SWISS, HTABLE_OPT_ROBIN_HOOD, HTABLE_OPT_INCREMENTAL, HTABLE_OPT_DENSE
+};
+
+char *test_htable_make_alloc_wrong_params()
+{
+    htable_options_t options = {0, NULL, 0, HTABLE_HASH_WORD, 0};
+    htable_allocator_t allocator = {pool_alloc, NULL, NULL};
+    ASSERTION(htable_make_alloc(&options, NULL) == NULL, "Expected: NULL!")
+    ASSERTION(htable_make_alloc(&options, &allocator) == NULL, "Expected: NULL!")
+    allocator = (htable_allocator_t){NULL, pool_free, NULL};
+    ASSERTION(htable_make_alloc(&options, &allocator) == NULL, "Expected: NULL!")
+    ASSERTION(htable_make_alloc(NULL, &allocator) == NULL, "Expected: NULL!")
+    ASSERTION(memory_not_allocated, "Expected: Memory was not allocated!")
+    return NULL;
+}
+
+char *test_htable_make_alloc()
+{
+    struct counting_pool pool;
+    const uint32_t flags[3] = {0, HTABLE_OPT_SWISS | HTABLE_OPT_ARENA, HTABLE_OPT_DENSE | HTABLE_OPT_STATS};
+    char keys[8][4];
+    htable_item_base_t item, *out;
+    htable_stats_t stats;
+
+    for (size_t l = 0; l < 3; l++)
+    {
+        pool_init(&pool, POOL_SIZE);
+        htable_t *ht = make_pool_table(&pool, flags[l], 0);
+        ASSERTION(ht != NULL, "Expected: Hash table was created!")
+        for (size_t i = 0; i < 8; i++)
+        {
+            snprintf(keys[i], sizeof(keys[i]), "K%zu", i);
+            item = (htable_item_base_t){(uint8_t*)keys[i], strlen(keys[i]), 0};
+            htable_set(ht, &item, sizeof(item));
+            htable_set(ht, &item, sizeof(item));  // Replaced item is released
+        }
+        ASSERTION(htable_status(ht) == HTABLE_OK, "Expected: HTABLE_OK!")
+        ASSERTION(htable_remove(ht, &item), "Expected: Item was removed!")
+        ASSERTION(htable_find(ht, (item.key = (uint8_t*)keys[0], &item), &out), "Expected: Item was found!")
+        ASSERTION(htable_stats(ht, &stats), "Expected: Statistics were collected!")
+
+        out = htable_pop(ht, &item);
+        ASSERTION(out != NULL, "Expected: Item was popped!")
+        if (!(out->flags & HTABLE_ITEM_ARENA))
+        {
+            pool_free(out->key, &pool);
+            pool_free(out, &pool);
+        }
+        htable_destroy(ht);
+        ASSERTION(pool.allocs == pool.frees, "Expected: Everything was released by allocator!")
+    }
+    ASSERTION(memory_not_allocated, "Expected: malloc was not called!")
+    return NULL;
+}
+
+char *test_htable_stats_wrong_params()
+{
+    htable_stats_t stats;
+    ASSERTION(!htable_stats(NULL, &stats), "Expected: false!")
+    ASSERTION(!htable_stats(&tgst.ht, NULL), "Expected: false!")
+
+    allocation_error_emulation_flag = 1;
+    ASSERTION(!htable_stats(&tgst.ht, &stats), "Expected: false!")
+    ASSERTION(htable_status(&tgst.ht) == HTABLE_MEM_ERROR, "Expected: HTABLE_MEM_ERROR!")
+    return NULL;
+}
+
+char *test_htable_stats()
+{
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_item_base_t item3 = {(uint8_t*)"KEY", 3, 0};
+    htable_t *ht = &tgst.ht;
+    htable_stats_t stats;
+    ht->flags = HTABLE_OPT_STATS;
+
+    // Constant hash: all items have the same home slot
+    htable_set(ht, &item1, sizeof(htable_item_base_t));
+    htable_set(ht, &item2, sizeof(htable_item_base_t));
+    ASSERTION(htable_find(ht, &item2, NULL), "Expected: Item was found!")
+    ASSERTION(!htable_find(ht, &item3, NULL), "Expected: Item was not found!")
+
+    ASSERTION(htable_stats(ht, &stats), "Expected: Statistics were collected!")
+    ASSERTION(stats.items_count == 2 && stats.capacity == 4, "Expected: 2 items, 4 slots!")
+    ASSERTION(stats.deleted_count == 0 && stats.load_factor == 0.5, "Expected: load factor == 0.5!")
+    ASSERTION(stats.insert_probes[0] == 1 && stats.insert_probes[1] == 1, "Expected: Insert probes 1 and 2!")
+    ASSERTION(stats.find_probes[1] == 1 && stats.find_probes[2] == 1, "Expected: Find probes 2 and 3!")
+    ASSERTION(stats.mean_probes == 1.5 && stats.max_probes == 2, "Expected: Probes of stored items!")
+    ASSERTION(stats.hash_dispersion == 1.5, "Expected: Items are clustered in one home slot!")
+    ASSERTION(stats.resize_count == 0, "Expected: Table didn't grow!")
+
+    ASSERTION(htable_remove(ht, &item1), "Expected: Item was removed!")
+    ASSERTION(htable_stats(ht, &stats), "Expected: Statistics were collected!")
+    ASSERTION(stats.items_count == 1 && stats.deleted_count == 1, "Expected: Tombstone is counted!")
+    ASSERTION(stats.mean_probes == 2, "Expected: Probes of stored item!")
+
+    // Miss goes on past the tombstone in the home slot up to the empty slot
+    ASSERTION(!htable_find(ht, &item3, NULL), "Expected: Item was not found!")
+    ASSERTION(htable_stats(ht, &stats), "Expected: Statistics were collected!")
+    ASSERTION(stats.find_probes[0] == 0 && stats.find_probes[2] == 2, "Expected: Miss probes 3!")
+    return NULL;
+}
+
+char *test_htable_stats_resize()
+{
+    htable_options_t options = {8, NULL, HTABLE_OPT_STATS | HTABLE_OPT_SWISS, HTABLE_HASH_WORD, 0};
+    htable_item_base_t item = {(uint8_t*)"K", 1, 0};
+    htable_stats_t stats;
+    uint64_t finds = 0, inserts = 0;
+    htable_t *ht = htable_make_ex(&options);
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
+    htable_set_item_destructor(ht, mock_item_destructor);
+
+    char keys[16];
+    for (size_t i = 0; i < sizeof(keys); i++)
+    {
+        keys[i] = 'a' + i;
+        item.key = (uint8_t*)&keys[i];
+        htable_set(ht, &item, sizeof(htable_item_base_t));
+    }
+    ASSERTION(htable_find(ht, &item, NULL), "Expected: Item was found!")
+    ASSERTION(htable_stats(ht, &stats), "Expected: Statistics were collected!")
+    ASSERTION(stats.capacity == 32 && stats.resize_count == 1, "Expected: Table grew once!")
+    for (size_t i = 0; i < HTABLE_PROBE_HISTOGRAM_SIZE; i++)
+    {
+        finds += stats.find_probes[i];
+        inserts += stats.insert_probes[i];
+    }
+    ASSERTION(finds == 1 && inserts == 16, "Expected: Every insert and find is counted!")
+    ASSERTION(stats.mean_probes >= 1 && stats.max_probes >= 1, "Expected: Probes of stored items!")
+
+    htable_destroy(ht);
+    return NULL;
+}
+
+struct counter
+{
+    htable_item_base_t base;
+    size_t count;
+};
+
+static void add_counts(htable_item_base_t *dst_item, const htable_item_base_t *src_item)
+{
+    ((struct counter*)dst_item)->count += ((const struct counter*)src_item)->count;
+}
+
+char *test_htable_merge_wrong_params()
+{
+    struct counting_pool pool;
+    pool_init(&pool, POOL_SIZE);
+    htable_options_t options = {0, NULL, 0, HTABLE_HASH_WORD, 0};
+    htable_t *dst = make_pool_table(&pool, HTABLE_OPT_ARENA, 0);
+    htable_t *src = make_pool_table(&pool, 0, 0);
+    htable_t *other = htable_make_ex(&options);
+    ASSERTION(dst && src && other, "Expected: Hash tables were created!")
+
+    ASSERTION(!htable_merge(NULL, src, add_counts), "Expected: false!")
+    ASSERTION(!htable_merge(dst, NULL, add_counts), "Expected: false!")
+    ASSERTION(!htable_merge(src, src, add_counts), "Expected: false!")
+    ASSERTION(!htable_merge(src, other, add_counts), "Expected: Allocators differ!")
+    ASSERTION(!htable_merge(dst, src, add_counts), "Expected: Heap items can't be moved to arena table!")
+    htable_set_item_destructor(src, mock_item_destructor);
+    ASSERTION(!htable_merge(src, dst, add_counts), "Expected: Item destructors differ!")
+    htable_set_item_destructor(src, NULL);
+    ASSERTION(htable_merge(src, dst, add_counts), "Expected: Arena items can be moved to heap table!")
+
+    htable_destroy(dst);
+    htable_destroy(src);
+    htable_destroy(other);
+    ASSERTION(pool.allocs == pool.frees, "Expected: Everything was released by allocator!")
+    return NULL;
+}
+
+/**
+ * Fill table with keys K<first>..K<last - 1>, every item has count.
+ */
+static bool fill_counters(htable_t *ht, size_t first, size_t last, size_t count)
+{
+    char key[4];
+    struct counter item = {{(uint8_t*)key, 0, 0}, count};
+    for (size_t i = first; i < last; i++)
+    {
+        item.base.key_len = snprintf(key, sizeof(key), "K%zu", i);
+        htable_set(ht, &item.base, sizeof(item));
+    }
+    return htable_status(ht) == HTABLE_OK;
+}
+
+char *test_htable_merge()
+{
+    struct counting_pool pool;
+    const uint32_t flags[5][2] = {
+        {0, 0},
+        {HTABLE_OPT_SWISS, HTABLE_OPT_DENSE},
+        {HTABLE_OPT_DENSE, HTABLE_OPT_ROBIN_HOOD | HTABLE_OPT_ARENA},
+        {HTABLE_OPT_ROBIN_HOOD | HTABLE_OPT_ARENA, HTABLE_OPT_SWISS | HTABLE_OPT_ARENA},
+        {HTABLE_OPT_INCREMENTAL | HTABLE_OPT_STATS, HTABLE_OPT_INCREMENTAL},
+    };
+    char key[4];
+    struct counter item = {{(uint8_t*)key, 0, 0}, 0};
+    htable_item_base_t *out;
+
+    for (size_t l = 0; l < 5; l++)
+    {
+        pool_init(&pool, POOL_SIZE);
+        // Odd cases have different seeds: keys of src are rehashed
+        htable_t *dst = make_pool_table(&pool, flags[l][0], 0);
+        htable_t *src = make_pool_table(&pool, flags[l][1], l & 1);
+        ASSERTION(dst && src, "Expected: Hash tables were created!")
+        ASSERTION(fill_counters(dst, 0, 6, 1) && fill_counters(src, 3, 9, 10), "Expected: Items were set!")
+        size_t allocs = pool.allocs;
+
+        ASSERTION(htable_merge(dst, src, add_counts), "Expected: Tables were merged!")
+        ASSERTION(pool.allocs - allocs <= 2, "Expected: Only slots of dst were allocated (2 arrays if dense)!")
+        ASSERTION(htable_status(dst) == HTABLE_OK, "Expected: HTABLE_OK!")
+        for (size_t i = 0; i < 9; i++)
+        {
+            item.base.key_len = snprintf(key, sizeof(key), "K%zu", i);
+            ASSERTION(htable_find(dst, &item.base, &out), "Expected: Item was found!")
+            ASSERTION(((struct counter*)out)->count == ((i < 3) ? 1 : (i < 6) ? 11 : 10), "Expected: Counts were combined!")
+            ASSERTION(!htable_find(src, &item.base, NULL), "Expected: Item was moved!")
+        }
+
+        // Empty src is filled again, the second merge replaces items without combine
+        ASSERTION(fill_counters(src, 0, 2, 5), "Expected: Items were set!")
+        ASSERTION(htable_merge(dst, src, NULL), "Expected: Tables were merged!")
+        item.base.key_len = snprintf(key, sizeof(key), "K0");
+        ASSERTION(htable_find(dst, &item.base, &out) && ((struct counter*)out)->count == 5, "Expected: Item was replaced!")
+
+        htable_destroy(src);
+        htable_destroy(dst);
+        ASSERTION(pool.allocs == pool.frees, "Expected: Everything was released by allocator!")
+    }
+    ASSERTION(memory_not_allocated, "Expected: malloc was not called!")
+    return NULL;
+}
+
+char *test_htable_merge_mem_fail()
+{
+    htable_options_t options = {0, NULL, 0, HTABLE_HASH_WORD, 0};
+    htable_t *dst = htable_make_ex(&options);
+    htable_t *src = htable_make_ex(&options);
+    ASSERTION(dst && src, "Expected: Hash tables were created!")
+    ASSERTION(fill_counters(dst, 0, 4, 1) && fill_counters(src, 4, 8, 1), "Expected: Items were set!")
+
+    allocation_error_emulation_flag = 1;
+    ASSERTION(!htable_merge(dst, src, add_counts), "Expected: Slot array of dst can't grow!")
+    ASSERTION(htable_status(dst) == HTABLE_MEM_ERROR, "Expected: HTABLE_MEM_ERROR!")
+    allocation_error_emulation_flag = 0;
+
+    htable_stats_t stats;
+    ASSERTION(htable_stats(src, &stats) && stats.items_count == 4, "Expected: Nothing was moved!")
+    ASSERTION(htable_stats(dst, &stats) && stats.items_count == 4, "Expected: Nothing was moved!")
+    htable_destroy(dst);
+    htable_destroy(src);
+    DETECT_MEMORY_LEAK
+    return NULL;
+}
+
+char *test_htable_set_max_items_wrong_params()
+{
+    htable_options_t options = {0, NULL, HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
+    ASSERTION(!htable_set_max_items(NULL, 4), "Expected: false!")
+    ASSERTION(!htable_set_max_items(ht, 4), "Expected: Arena table can't be bounded!")
+    htable_destroy(ht);
+    return NULL;
+}
+
+char *test_htable_bounded()
+{
+    htable_options_t options = {0, NULL, 0, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    htable_stats_t stats;
+    char key[4];
+    htable_item_base_t item = {(uint8_t*)key, 2, 0};
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
+    htable_set_item_destructor(ht, mock_item_destructor);
+    ASSERTION(htable_set_max_items(ht, 4), "Expected: Limit was set!")
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        snprintf(key, sizeof(key), "K%zu", i);
+        htable_set(ht, &item, sizeof(item));
+    }
+    // K3 is the only item which wasn't found, CLOCK evicts it wherever the hand starts
+    for (size_t i = 0; i < 3; i++)
+    {
+        snprintf(key, sizeof(key), "K%zu", i);
+        ASSERTION(htable_find(ht, &item, NULL), "Expected: Item was found!")
+    }
+    snprintf(key, sizeof(key), "K4");
+    ASSERTION(htable_upsert(ht, &item, sizeof(item), NULL) != NULL, "Expected: Item was inserted!")
+    ASSERTION(tgst.destructor_calls_count == 1, "Expected: Evicted item was destroyed!")
+    snprintf(key, sizeof(key), "K3");
+    ASSERTION(!htable_find(ht, &item, NULL), "Expected: Item was evicted!")
+
+    ASSERTION(htable_stats(ht, &stats), "Expected: Statistics were collected!")
+    ASSERTION(stats.items_count == 4 && stats.evictions == 1, "Expected: 4 items, 1 eviction!")
+    ASSERTION(stats.hits == 3 && stats.misses == 2, "Expected: 3 hits, 2 misses (upsert and find)!")
+
+    ASSERTION(htable_set_max_items(ht, 2), "Expected: Limit was set!")
+    ASSERTION(tgst.destructor_calls_count == 3, "Expected: Extra items were evicted at once!")
+    ASSERTION(htable_set_max_items(ht, 0), "Expected: Limit was removed!")
+    htable_destroy(ht);
+    ASSERTION(tgst.destructor_calls_count == 5, "Expected: All items were destroyed!")
+    return NULL;
+}
+
+/**
+ * Full bounded table: nothing is evicted if the new item can't be made (item or key allocation fails).
+ */
+char *test_htable_bounded_make_fail()
+{
+    htable_options_t options = {0, NULL, 0, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    char key[4];
+    htable_item_base_t item = {(uint8_t*)key, 2, 0};
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
+    htable_set_item_destructor(ht, mock_item_destructor);
+    ASSERTION(htable_set_max_items(ht, 2), "Expected: Limit was set!")
+    for (size_t i = 0; i < 2; i++)
+    {
+        snprintf(key, sizeof(key), "K%zu", i);
+        htable_set(ht, &item, sizeof(item));
+    }
+
+    snprintf(key, sizeof(key), "K2");
+    for (size_t fail_after = 0; fail_after < 2; fail_after++)
+    {
+        allocation_error_emulation_after_nth_calls = allocated_next_idx + fail_after;
+        htable_set(ht, &item, sizeof(item));
+        ASSERTION(htable_status(ht) == HTABLE_MEM_ERROR, "Expected: HTABLE_MEM_ERROR!")
+        ASSERTION(htable_upsert(ht, &item, sizeof(item), NULL) == NULL, "Expected: NULL!")
+        ASSERTION(htable_status(ht) == HTABLE_MEM_ERROR, "Expected: HTABLE_MEM_ERROR!")
+    }
+    allocation_error_emulation_after_nth_calls = -1;
+    ASSERTION(tgst.destructor_calls_count == 0, "Expected: Nothing was evicted!")
+    for (size_t i = 0; i < 2; i++)
+    {
+        snprintf(key, sizeof(key), "K%zu", i);
+        ASSERTION(htable_find(ht, &item, NULL), "Expected: Item was found!")
+    }
+
+    snprintf(key, sizeof(key), "K2");
+    ASSERTION(htable_upsert(ht, &item, sizeof(item), NULL) != NULL, "Expected: Item was inserted!")
+    ASSERTION(tgst.destructor_calls_count == 1, "Expected: Evicted item was destroyed!")
+    htable_destroy(ht);
+    ASSERTION(tgst.destructor_calls_count == 3, "Expected: All items were destroyed!")
+    return NULL;
+}
+
+#define BLOCK_SIZE 1024
+#define BLOCKS_COUNT 32
+
+struct block_pool
+{
+    _Alignas(max_align_t) uint8_t mem[BLOCKS_COUNT][BLOCK_SIZE];
+    bool used[BLOCKS_COUNT];
+    size_t live;
+    size_t max_live;
+};
+
+void *block_alloc(size_t size, void *ctx)
+{
+    struct block_pool *pool = ctx;
+    for (size_t i = 0; size <= BLOCK_SIZE && i < BLOCKS_COUNT; i++)
+    {
+        if (pool->used[i])
+            continue;
+        pool->used[i] = true;
+        if (++pool->live > pool->max_live)
+            pool->max_live = pool->live;
+        return pool->mem[i];
+    }
+    return NULL;
+}
+
+void block_free(void *p, void *ctx)
+{
+    struct block_pool *pool = ctx;
+    pool->used[((uint8_t*)p - pool->mem[0]) / BLOCK_SIZE] = false;
+    pool->live--;
+}
+
+/**
+ * Stream of distinct keys through bounded table of every layout: memory is reused by evicted items.
+ */
+char *test_htable_bounded_stream()
+{
+    static struct block_pool pool;
+    htable_allocator_t allocator = {block_alloc, block_free, &pool};
+    char key[8];
+    htable_item_base_t item = {(uint8_t*)key, 0, 0};
+    htable_stats_t stats;
+    size_t capacity = 0;
+
+    for (size_t l = 0; l < LAYOUTS_COUNT; l++)
+    {
+        memset(&pool, 0, sizeof(pool));
+        htable_options_t options = {0, NULL, layouts[l], HTABLE_HASH_WORD, 0};
+        htable_t *ht = htable_make_alloc(&options, &allocator);
+        ASSERTION(ht != NULL && htable_set_max_items(ht, 8), "Expected: Bounded hash table was created!")
+        for (size_t i = 0; i < 1000; i++)
+        {
+            item.key_len = snprintf(key, sizeof(key), "K%zu", i);
+            if (i & 1)
+                htable_set(ht, &item, sizeof(item));
+            else
+                htable_upsert(ht, &item, sizeof(item), NULL);
+            ASSERTION(htable_status(ht) == HTABLE_OK, "Expected: HTABLE_OK!")
+            ASSERTION(htable_find(ht, &item, NULL), "Expected: New item was found!")
+            if (i == 100)
+            {
+                htable_stats(ht, &stats);
+                capacity = stats.capacity;
+            }
+        }
+        ASSERTION(htable_stats(ht, &stats), "Expected: Statistics were collected!")
+        ASSERTION(stats.items_count == 8 && stats.evictions == 992, "Expected: 8 items, 992 evictions!")
+        ASSERTION(stats.capacity == capacity, "Expected: Slot array stopped growing!")
+        ASSERTION(pool.max_live <= 24, "Expected: Memory stays flat!")
+        htable_destroy(ht);
+        ASSERTION(pool.live == 0, "Expected: Everything was released!")
+    }
+    return NULL;
+}
+
+char *test_bloom_find()
+{
+    htable_item_base_t item = {(uint8_t*)"PT_KEY", 6, 0};
+    uint64_t block[BLOOM_WORDS] = {0};
+    htable_stats_t stats;
+    htable_t *ht = &tgst.ht;
+    ht->flags = HTABLE_OPT_STATS;
+    ht->bloom = block;
+    ht->bloom_blocks = 1;
+    ht->items[0] = &item;
+    ht->hashes[0] = 0;
+    ht->items_count = 1;
+
+    ASSERTION(!htable_find(ht, &item, NULL), "Expected: Empty filter rejected the key!")
+    ASSERTION(!htable_remove(ht, &item), "Expected: Key was not removed!")
+    ASSERTION(ht->items[0] == &item, "Expected: Slot was not touched!")
+    ASSERTION(htable_stats(ht, &stats) && stats.bloom_rejects == 1, "Expected: 1 rejected lookup!")
+
+    bloom_add(ht, 0);
+    for (size_t i = 0; i < BLOOM_WORDS; i++)
+        ASSERTION(block[i] == 1, "Expected: One bit was set in every word!")
+    ASSERTION(htable_find(ht, &item, NULL), "Expected: Item was found!")
+    ASSERTION(!bloom_may_contain(ht, 0x12345678), "Expected: Other hash is rejected!")
+    ht->bloom = NULL;
+    return NULL;
+}
+
+char *test_bloom_make_fail()
+{
+    htable_options_t options = {0, NULL, HTABLE_OPT_BLOOM, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    ASSERTION(ht != NULL && ht->bloom != NULL, "Expected: Hash table with filter was created!")
+    ASSERTION(mem_allocated[2].size == 2 * BLOOM_BLOCK_SIZE - 1, "Expected: One block for small table!")
+    ASSERTION(((uintptr_t)ht->bloom & (BLOOM_BLOCK_SIZE - 1)) == 0, "Expected: Block is cache line aligned!")
+    htable_destroy(ht);
+    DETECT_MEMORY_LEAK
+
+    reset_mem();
+    allocation_error_emulation_after_nth_calls = 2;
+    ASSERTION(htable_make_ex(&options) == NULL, "Expected: NULL!")
+    DETECT_MEMORY_LEAK
+    return NULL;
+}
+
+/**
+ * Filter of every layout is kept in sync by inserts and rebuilds: no key is lost, most absent keys are rejected.
+ */
+char *test_bloom_functional()
+{
+    struct counting_pool pool;
+    char keys[100][8], absent[1000][8];
+    htable_item_base_t items[100], absent_items[1000];
+    const htable_item_base_t *batch[100];
+    htable_item_base_t *out[100];
+    htable_stats_t stats;
+
+    for (size_t i = 0; i < 100; i++)
+    {
+        items[i] = (htable_item_base_t){(uint8_t*)keys[i], snprintf(keys[i], sizeof(keys[i]), "K%zu", i), 0};
+        batch[i] = &items[i];
+    }
+    for (size_t i = 0; i < 1000; i++)
+        absent_items[i] = (htable_item_base_t){(uint8_t*)absent[i], snprintf(absent[i], sizeof(absent[i]), "M%zu", i), 0};
+
+    for (size_t l = 0; l < LAYOUTS_COUNT; l++)
+    {
+        pool_init(&pool, POOL_MAX_SIZE);
+        htable_t *ht = make_pool_table(&pool, layouts[l] | HTABLE_OPT_BLOOM | HTABLE_OPT_STATS, 0);
+        ASSERTION(ht != NULL, "Expected: Hash table was created!")
+        for (size_t i = 0; i < 100; i++)
+        {
+            htable_set(ht, &items[i], sizeof(htable_item_base_t));
+            ASSERTION(htable_find(ht, &items[i], NULL), "Expected: New item was found!")
+        }
+        ASSERTION(htable_find_batch(ht, batch, 100, out) == 100, "Expected: All items were found!")
+
+        size_t found = 0;
+        for (size_t i = 0; i < 1000; i++)
+            found += htable_find(ht, &absent_items[i], NULL);
+        ASSERTION(found == 0, "Expected: Absent keys were not found!")
+        ASSERTION(htable_stats(ht, &stats), "Expected: Statistics were collected!")
+        ASSERTION(stats.resize_count > 0, "Expected: Filter was rebuilt by resizes!")
+        ASSERTION(stats.bloom_rejects >= 900, "Expected: Most absent keys were rejected by filter!")
+        ASSERTION(((uintptr_t)ht->bloom & (BLOOM_BLOCK_SIZE - 1)) == 0, "Expected: Rebuilt filter is aligned!")
+
+        for (size_t i = 0; i < 100; i += 2)
+            ASSERTION(htable_remove(ht, &items[i]), "Expected: Item was removed!")
+        for (size_t i = 0; i < 100; i++)
+            ASSERTION(htable_find(ht, &items[i], NULL) == (i & 1), "Expected: Only odd items were found!")
+        htable_destroy(ht);
+        ASSERTION(pool.allocs == pool.frees, "Expected: Everything was released!")
+    }
+    return NULL;
+}
+
+char *test_incremental_migrate()
+{
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_t *ht = &tgst.ht;
+    ht->flags = HTABLE_OPT_INCREMENTAL;
+
+    ht->items[1] = &item1;
+    ht->items[3] = &item2;
+    ht->items_count = 2;
+
+    start_migration(ht, 8);
+    ASSERTION(ht->capacity == 8, "Expected: capacity == 8!")
+    ASSERTION(ht->old_items == tgst.arr, "Expected: Old array was kept!")
+    ASSERTION(ht->old_capacity == 4, "Expected: Old capacity == 4!")
+    ASSERTION(allocated_count == 1, "Expected: Memory allocated 1 time!")
+    ASSERTION(memory_not_released, "Expected: Memory was not released!")
+    ASSERTION(tgst.hash_func_calls_count == 0, "Expected: Hash function was not called!")
+
+    migrate(ht, 2);
+    ASSERTION(ht->migrate_index == 2, "Expected: Two slots were migrated!")
+    ASSERTION(ht->items[0] == &item1, "Expected: item1 was moved!")
+    ASSERTION(tgst.arr[1] == marked_as_deleted, "Expected: Old slot was marked as deleted!")
+    ASSERTION(tgst.arr[3] == &item2, "Expected: item2 was not moved yet!")
+
+    migrate(ht, SIZE_MAX);
+    ASSERTION(ht->items[1] == &item2, "Expected: item2 was moved!")
+    ASSERTION(ht->old_items == NULL, "Expected: Migration was finished!")
+    ASSERTION(released_count == 1 && mem_freed[0].mem == (uint8_t*)tgst.arr, "Expected: Old array was released!")
+    ASSERTION(ht->items_count == 2, "Expected: items count == 2!")
+    return NULL;
+}
+
+char *test_incremental_find_in_old()
+{
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_t *ht = &tgst.ht;
+    ht->flags = HTABLE_OPT_INCREMENTAL;
+
+    ht->items[1] = &item1;
+    ht->items[2] = &item2;
+    ht->items_count = 2;
+    start_migration(ht, 8);
+
+    htable_item_base_t *out = NULL;
+    bool res = htable_find(ht, &item2, &out);
+    ASSERTION(res == true, "Expected: Item was found!")
+    ASSERTION(out == &item2, "Expected: Out parameter is item2!")
+    ASSERTION(ht->migrate_index == 4, "Expected: Migration step was done!")
+    ASSERTION(ht->old_items == NULL, "Expected: Migration was finished!")
+    return NULL;
+}
+
+char *test_incremental_functional()
+{
+    htable_options_t options = {8, NULL, HTABLE_OPT_INCREMENTAL | HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
+
+    char keys[12][4];
+    htable_item_base_t item;
+    bool migration_seen = false;
+    for (size_t i = 0; i < 12; i++)
+    {
+        snprintf(keys[i], sizeof(keys[i]), "K%zu", i);
+        item = (htable_item_base_t){(uint8_t*)keys[i], strlen(keys[i]), 0};
+        htable_set(ht, &item, sizeof(htable_item_base_t));
+        migration_seen |= ht->old_items != NULL;
+    }
+    ASSERTION(migration_seen, "Expected: Incremental rehashing was started!")
+    ASSERTION(ht->items_count == 12, "Expected: items count == 12!")
+
+    for (size_t i = 0; i < 12; i++)
+    {
+        item = (htable_item_base_t){(uint8_t*)keys[i], strlen(keys[i]), 0};
+        ASSERTION(htable_find(ht, &item, NULL), "Expected: Item was found!")
+    }
+
+    htable_destroy(ht);
+    DETECT_MEMORY_LEAK
+    return NULL;
+}
+
+int enum_callback(htable_item_base_t *item)
+{
+    tgst.enumerated[tgst.enum_callback_calls_count++] = item;
+    return 1;
+}
+
+int enum_callback_stop(htable_item_base_t *item)
+{
+    tgst.enumerated[tgst.enum_callback_calls_count++] = item;
+    return 0;
+}
+
+char *test_htable_enumerate_items_wrong_params()
+{
+    htable_enumerate_items(NULL, enum_callback);
+    ASSERTION(tgst.enum_callback_calls_count == 0, "Expected: Callback was not called!")
+    htable_enumerate_items(&tgst.ht, NULL);
+    ASSERTION(tgst.enum_callback_calls_count == 0, "Expected: Callback was not called!")
+    return NULL;
+}
+
+char *test_htable_enumerate_items()
+{
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_t *ht = &tgst.ht;
+
+    ht->items[0] = marked_as_deleted;
+    ht->items[1] = &item1;
+    ht->items[2] = marked_as_deleted;
+    ht->items[3] = &item2;
+    ht->items_count = 2;
+
+    bool res = htable_enumerate_items(ht, enum_callback);
+    ASSERTION(res, "Expected: Enumeration was not stopped!")
+    ASSERTION(tgst.enum_callback_calls_count == 2, "Expected: Callback was called 2 times!")
+    ASSERTION(tgst.enumerated[0] == &item1, "Expected: item1 was enumerated!")
+    ASSERTION(tgst.enumerated[1] == &item2, "Expected: item2 was enumerated!")
+    return NULL;
+}
+
+char *test_htable_enumerate_items_stop()
+{
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_t *ht = &tgst.ht;
+
+    ht->items[0] = marked_as_deleted;
+    ht->items[1] = &item1;
+    ht->items[2] = marked_as_deleted;
+    ht->items[3] = &item2;
+    ht->items_count = 2;
+
+    bool res = htable_enumerate_items(ht, enum_callback_stop);
+    ASSERTION(!res, "Expected: Enumeration was stopped!")
+    ASSERTION(tgst.enum_callback_calls_count == 1, "Expected: Callback was called 1 times!")
+    ASSERTION(tgst.enumerated[0] == &item1, "Expected: item1 was enumerated!")
+    return NULL;
+}
+
+char *test_htable_find_wrong_params()
+{
+    htable_t *ht = &tgst.ht;
+    htable_item_base_t item = {NULL, 0, 0};
+    bool res;
+
+    res = htable_find(NULL, NULL, NULL);
+    ASSERTION(res == false, "Expected: Nothing was found!")
+    res = htable_find(ht, NULL, NULL);
+    ASSERTION(res == false, "Expected: Nothing was found!")
+    res = htable_find(ht, &item, NULL);
+    ASSERTION(res == false, "Expected: Nothing was found!")
+    return NULL;
+}
+
+char *test_htable_find()
+{
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_t *ht = &tgst.ht;
+
+    ht->items[0] = marked_as_deleted;
+    ht->items[1] = &item1;
+    ht->items[2] = marked_as_deleted;
+    ht->items[3] = &item2;
+    ht->items_count = 2;
+
+    htable_item_base_t *out = NULL;
+    bool res = htable_find(ht, &item2, &out);
+    ASSERTION(res == true, "Expected: Item was found!")
+    ASSERTION(out != NULL, "Expected: Out parameter is not NULL!")
+    ASSERTION(items_equal(out, &item2), "Expected: Out parameter is item2!")
+    return NULL;
+}
+
+char *test_htable_find_no_out_item()
+{
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->items[0] = marked_as_deleted;
@@ -931,8 +2346,8 @@ char *test_htable_find_no_out_item()
 
 char *test_htable_find_not_found()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->items[0] = &item1;
@@ -940,16 +2355,83 @@ char *test_htable_find_not_found()
     ht->items[2] = &item2;
     ht->items_count = 2;
 
-    htable_item_base_t item3 = {(uint8_t*)"HHH", 3};
+    htable_item_base_t item3 = {(uint8_t*)"HHH", 3, 0};
     bool res = htable_find(ht, &item3, NULL);
     ASSERTION(res == false, "Expected: Item was not found!")
     return NULL;
 }
 
+char *test_htable_find_batch_wrong_params()
+{
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    const htable_item_base_t *items[1] = {&item1};
+    htable_item_base_t *out_items[1];
+
+    ASSERTION(htable_find_batch(NULL, items, 1, out_items) == 0, "Expected: Nothing was found!")
+    ASSERTION(htable_find_batch(&tgst.ht, NULL, 1, out_items) == 0, "Expected: Nothing was found!")
+    ASSERTION(htable_find_batch(&tgst.ht, items, 1, NULL) == 0, "Expected: Nothing was found!")
+    ASSERTION(tgst.hash_func_calls_count == 0, "Expected: Hash function was not called!")
+    return NULL;
+}
+
+char *test_htable_find_batch()
+{
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
+    htable_item_base_t item3 = {(uint8_t*)"HHH", 3, 0};
+    htable_item_base_t item4 = {NULL, 0, 0};
+    htable_t *ht = &tgst.ht;
+
+    ht->items[0] = &item1;
+    ht->items[1] = marked_as_deleted;
+    ht->items[2] = &item2;
+    ht->items_count = 2;
+
+    const htable_item_base_t *items[5] = {&item2, &item3, NULL, &item4, &item1};
+    htable_item_base_t *out_items[5] = {&item1, &item1, &item1, &item1, NULL};
+    size_t found = htable_find_batch(ht, items, 5, out_items);
+    ASSERTION(found == 2, "Expected: 2 items were found!")
+    ASSERTION(out_items[0] == &item2, "Expected: item2 was found!")
+    ASSERTION(out_items[1] == NULL && out_items[2] == NULL && out_items[3] == NULL, "Expected: Items were not found!")
+    ASSERTION(out_items[4] == &item1, "Expected: item1 was found!")
+    ASSERTION(tgst.hash_func_calls_count == 3, "Expected: Hash function was called once per key!")
+    return NULL;
+}
+
+char *test_htable_find_batch_swiss()
+{
+    htable_options_t options = {16, NULL, HTABLE_OPT_SWISS | HTABLE_OPT_ARENA, HTABLE_HASH_WORD, 0};
+    htable_t *ht = htable_make_ex(&options);
+
+    char keys[40][4];
+    htable_item_base_t items[40], *out_items[40];
+    const htable_item_base_t *item_ptrs[40];
+    for (size_t i = 0; i < 40; i++)
+    {
+        snprintf(keys[i], sizeof(keys[i]), "K%zu", i);
+        items[i] = (htable_item_base_t){(uint8_t*)keys[i], strlen(keys[i]), 0};
+        item_ptrs[i] = &items[i];
+        if (i & 1)
+            htable_set(ht, &items[i], sizeof(htable_item_base_t));
+    }
+
+    size_t found = htable_find_batch(ht, item_ptrs, 40, out_items);
+    ASSERTION(found == 20, "Expected: 20 items were found!")
+    for (size_t i = 0; i < 40; i++)
+    {
+        ASSERTION((out_items[i] != NULL) == (i & 1), "Expected: Odd items were found!")
+        ASSERTION(!out_items[i] || items_equal(out_items[i], &items[i]), "Expected: Items are equal!")
+    }
+
+    htable_destroy(ht);
+    DETECT_MEMORY_LEAK
+    return NULL;
+}
+
 char *test_htable_remove_wrong_params()
 {
     htable_t *ht = &tgst.ht;
-    htable_item_base_t item = {NULL, 0};
+    htable_item_base_t item = {NULL, 0, 0};
     bool res;
 
     res = htable_remove(NULL, NULL);
@@ -963,8 +2445,8 @@ char *test_htable_remove_wrong_params()
 
 char *test_htable_remove_exist_key()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->items[0] = &item1;
@@ -986,8 +2468,8 @@ char *test_htable_remove_exist_key()
 
 char *test_htable_remove_not_exist_key()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->items[0] = &item1;
@@ -995,7 +2477,7 @@ char *test_htable_remove_not_exist_key()
     ht->items[2] = &item2;
     ht->items_count = 2;
 
-    htable_item_base_t item3 = {(uint8_t*)"HHH", 3};
+    htable_item_base_t item3 = {(uint8_t*)"HHH", 3, 0};
     bool res = htable_remove(ht, &item3);
     ASSERTION(res == false, "Expected: Item was not found!")
     ASSERTION(tgst.destructor_calls_count == 0, "Expected: Item destructor was not called!")
@@ -1008,7 +2490,7 @@ char *test_htable_remove_not_exist_key()
 char *test_htable_pop_wrong_params()
 {
     htable_t *ht = &tgst.ht;
-    htable_item_base_t item = {NULL, 0};
+    htable_item_base_t item = {NULL, 0, 0};
     htable_item_base_t *res;
 
     res = htable_pop(NULL, NULL);
@@ -1022,8 +2504,8 @@ char *test_htable_pop_wrong_params()
 
 char *test_htable_pop_exist_key()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->items[0] = &item1;
@@ -1043,8 +2525,8 @@ char *test_htable_pop_exist_key()
 
 char *test_htable_pop_not_exist_key()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->items[0] = &item1;
@@ -1052,7 +2534,7 @@ char *test_htable_pop_not_exist_key()
     ht->items[2] = &item2;
     ht->items_count = 2;
 
-    htable_item_base_t item3 = {(uint8_t*)"HHH", 3};
+    htable_item_base_t item3 = {(uint8_t*)"HHH", 3, 0};
     htable_item_base_t *res = htable_pop(ht, &item3);
     ASSERTION(res == NULL, "Expected: Item was not found!")
     ASSERTION(ht->items_count == 2, "Expected: items count == 2!")
@@ -1065,11 +2547,11 @@ char *test_functional()
     htable_t *ht =  htable_make(8, NULL);
     ASSERTION(ht != NULL, "Expected: Hash table was created!")
 
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"AT_KEY_2", 8};
-    htable_item_base_t item3 = {(uint8_t*)"CC_KEY_22", 9};
-    htable_item_base_t item4 = {(uint8_t*)"PU_KEY_333", 10};
-    htable_item_base_t item5 = {(uint8_t*)"HASH TABLE DONT CONTAIN THIS KEY", 32};
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"AT_KEY_2", 8, 0};
+    htable_item_base_t item3 = {(uint8_t*)"CC_KEY_22", 9, 0};
+    htable_item_base_t item4 = {(uint8_t*)"PU_KEY_333", 10, 0};
+    htable_item_base_t item5 = {(uint8_t*)"HASH TABLE DONT CONTAIN THIS KEY", 32, 0};
 
     htable_set(ht, &item1, sizeof(htable_item_base_t));
     htable_set(ht, &item2, sizeof(htable_item_base_t));
@@ -1114,12 +2596,13 @@ char *test_functional()
 }
 
 char *test_htable_set_last_item() {
-    htable_item_base_t item1 = {(uint8_t *) "PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t *) "ABCD_KEY", 8};
+    htable_item_base_t item1 = {(uint8_t *) "PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t *) "ABCD_KEY", 8, 0};
     htable_t *ht = &tgst.ht;
 
     ht->hash_func = const_hash_func_2;
     ht->items[3] = &item2;
+    ht->hashes[3] = 3;
     ht->items_count = 1;
 
     htable_set(ht, &item1, sizeof(htable_item_base_t));
@@ -1134,13 +2617,15 @@ char *test_htable_set_last_item() {
 
 char *test_htable_find_last_item()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->hash_func = const_hash_func_2;
     ht->items[0] = &item1;
     ht->items[3] = &item2;
+    ht->hashes[0] = 3;
+    ht->hashes[3] = 3;
     ht->items_count = 2;
 
     htable_item_base_t *out = NULL;
@@ -1153,13 +2638,15 @@ char *test_htable_find_last_item()
 
 char *test_htable_remove_exist_key_last_item()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->hash_func = const_hash_func_2;
     ht->items[0] = &item1;
     ht->items[3] = &item2;
+    ht->hashes[0] = 3;
+    ht->hashes[3] = 3;
     ht->items_count = 2;
 
     bool res = htable_remove(ht, &item1);
@@ -1176,13 +2663,15 @@ char *test_htable_remove_exist_key_last_item()
 
 char *test_htable_pop_exist_key_last_item()
 {
-    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6};
-    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7};
+    htable_item_base_t item1 = {(uint8_t*)"PT_KEY", 6, 0};
+    htable_item_base_t item2 = {(uint8_t*)"ABC_KEY", 7, 0};
     htable_t *ht = &tgst.ht;
 
     ht->hash_func = const_hash_func_2;
     ht->items[0] = &item1;
     ht->items[3] = &item2;
+    ht->hashes[0] = 3;
+    ht->hashes[3] = 3;
     ht->items_count = 2;
 
     htable_item_base_t *res = htable_pop(ht, &item1);
@@ -1202,8 +2691,9 @@ char *test_htable_set_special_case() {
     ht->items[1] = marked_as_deleted;
     ht->items[2] = marked_as_deleted;
     ht->items[3] = marked_as_deleted;
+    ht->deleted_count = 4;
 
-    htable_item_base_t item = {(uint8_t*)"PT_KEY", 6};
+    htable_item_base_t item = {(uint8_t*)"PT_KEY", 6, 0};
     htable_set(ht, &item, sizeof(htable_item_base_t));
     ASSERTION(ht->last_error != HTABLE_FULL, "Expected: Htable status is not HTABLE FULL!")
     ASSERTION(ht->items_count == 1, "Expected: items count == 1!")
@@ -1223,7 +2713,7 @@ char *test_htable_find_special_case() {
     ht->items[2] = marked_as_deleted;
     ht->items[3] = marked_as_deleted;
 
-    htable_item_base_t item = {(uint8_t*)"PT_KEY", 6};
+    htable_item_base_t item = {(uint8_t*)"PT_KEY", 6, 0};
     bool res = htable_find(ht, &item, NULL);
     ASSERTION(ht->last_error != HTABLE_FULL, "Expected: Htable status is not HTABLE FULL!")
     ASSERTION(res == false, "Expected: Nothing was found!")
@@ -1238,7 +2728,7 @@ char *test_htable_remove_special_case() {
     ht->items[2] = marked_as_deleted;
     ht->items[3] = marked_as_deleted;
 
-    htable_item_base_t item = {(uint8_t*)"PT_KEY", 6};
+    htable_item_base_t item = {(uint8_t*)"PT_KEY", 6, 0};
     bool res = htable_remove(ht, &item);
     ASSERTION(ht->last_error != HTABLE_FULL, "Expected: Htable status is not HTABLE FULL!")
     ASSERTION(res == false, "Expected: Nothing was found!")
@@ -1253,7 +2743,7 @@ char *test_htable_pop_special_case() {
     ht->items[2] = marked_as_deleted;
     ht->items[3] = marked_as_deleted;
 
-    htable_item_base_t item = {(uint8_t*)"PT_KEY", 6};
+    htable_item_base_t item = {(uint8_t*)"PT_KEY", 6, 0};
     htable_item_base_t *res = htable_pop(ht, &item);
     ASSERTION(ht->last_error != HTABLE_FULL, "Expected: Htable status is not HTABLE FULL!")
     ASSERTION(res == NULL, "Expected: Nothing was found!")
@@ -1265,6 +2755,10 @@ int main(void)
 {
     struct test_case tests[] = {
         {"Test default_item_destructor", test_default_item_destructor},
+        {"Test default_item_destructor inline key", test_default_item_destructor_inline_key},
+        {"Test default_item_destructor arena", test_default_item_destructor_arena},
+        {"Test arena_alloc", test_arena_alloc},
+        {"Test arena_alloc fail", test_arena_alloc_fail},
         {"Test compare_items_key 1", test_compare_items_key_different_key_len},
         {"Test compare_items_key 2", test_compare_items_key_different_key},
         {"Test compare_items_key 3", test_compare_items_key_the_same_key},
@@ -1278,21 +2772,67 @@ int main(void)
         {"Test find 4", test_find_direct},
         {"Test find 5", test_find_relative_1},
         {"Test find 6", test_find_relative_2},
+        {"Test find 7", test_find_hash_mismatch},
         {"Test htable_status", test_htable_status},
         {"Test htable_set_item_destructor", test_htable_set_item_destructor},
         {"Test htable_make", test_htable_make},
         {"Test htable_make malloc fail", test_htable_make_malloc_fail},
         {"Test htable_make set hash function", test_htable_make_with_specified_params},
+        {"Test htable_make_ex", test_htable_make_ex},
         {"Test htable_make calloc fail", test_htable_make_calloc_fail},
         {"Test htable_set wrong parameters", test_htable_set_wrong_parameters},
         {"Test htable_set ", test_htable_set},
+        {"Test htable_set inline key", test_htable_set_inline_key},
+        {"Test htable_set inline key too long", test_htable_set_inline_key_too_long},
+        {"Test htable_set arena", test_htable_set_arena},
         {"Test htable_set full ", test_htable_set_full},
         {"Test htable_set memory fail 1", test_htable_set_mem_fail_1},
         {"Test htable_set memory fail 2", test_htable_set_mem_fail_2},
         {"Test htable_set change item", test_htable_set_change_item},
         {"Test htable_set expand", test_htable_set_expand},
+        {"Test htable_upsert wrong parameters", test_htable_upsert_wrong_parameters},
+        {"Test htable_upsert insert", test_htable_upsert_insert},
+        {"Test htable_upsert existing", test_htable_upsert_existing},
+        {"Test htable_upsert existing no grow", test_htable_upsert_existing_no_grow},
+        {"Test htable_upsert mem fail", test_htable_upsert_mem_fail},
+        {"Test htable_*_hashed", test_htable_hashed},
         {"Test htable_destroy wrong parameters", test_htable_destroy_wrong_param},
         {"Test htable_destroy", test_htable_destroy},
+        {"Test htable_destroy arena", test_htable_destroy_arena},
+        {"Test htable_make_ex swiss", test_htable_make_ex_swiss},
+        {"Test swiss find full", test_swiss_find_full},
+        {"Test swiss find deleted", test_swiss_find_deleted},
+        {"Test swiss clear_slot", test_swiss_clear_slot},
+        {"Test swiss functional", test_swiss_functional},
+        {"Test htable_set cleanup deleted", test_htable_set_cleanup_deleted},
+        {"Test robin hood find", test_robin_hood_find},
+        {"Test robin hood insert", test_robin_hood_insert},
+        {"Test robin hood remove", test_robin_hood_remove},
+        {"Test robin hood churn", test_robin_hood_churn},
+        {"Test htable_make_ex wrong options", test_htable_make_ex_wrong_options},
+        {"Test htable_make_ex hash", test_htable_make_ex_hash},
+        {"Test built-in hash functions", test_builtin_hash_functions},
+        {"Test dense make", test_dense_make},
+        {"Test dense functional", test_dense_functional},
+        {"Test dense destroy", test_dense_destroy},
+        {"Test htable_make_alloc wrong params", test_htable_make_alloc_wrong_params},
+        {"Test htable_make_alloc", test_htable_make_alloc},
+        {"Test htable_stats wrong params", test_htable_stats_wrong_params},
+        {"Test htable_stats", test_htable_stats},
+        {"Test htable_stats resize", test_htable_stats_resize},
+        {"Test htable_merge wrong params", test_htable_merge_wrong_params},
+        {"Test htable_merge", test_htable_merge},
+        {"Test htable_merge mem fail", test_htable_merge_mem_fail},
+        {"Test htable_set_max_items wrong params", test_htable_set_max_items_wrong_params},
+        {"Test htable bounded", test_htable_bounded},
+        {"Test htable bounded make fail", test_htable_bounded_make_fail},
+        {"Test htable bounded stream", test_htable_bounded_stream},
+        {"Test bloom find", test_bloom_find},
+        {"Test bloom make fail", test_bloom_make_fail},
+        {"Test bloom functional", test_bloom_functional},
+        {"Test incremental migrate", test_incremental_migrate},
+        {"Test incremental find in old", test_incremental_find_in_old},
+        {"Test incremental functional", test_incremental_functional},
         {"Test htable_enumerate_items wrong params", test_htable_enumerate_items_wrong_params},
         {"Test htable_enumerate_items", test_htable_enumerate_items},
         {"Test htable_enumerate_items stop", test_htable_enumerate_items_stop},
@@ -1300,6 +2840,9 @@ int main(void)
         {"Test htable_find ", test_htable_find},
         {"Test htable_find no out_item ", test_htable_find_no_out_item},
         {"Test htable_find not found item ", test_htable_find_not_found},
+        {"Test htable_find_batch wrong params", test_htable_find_batch_wrong_params},
+        {"Test htable_find_batch", test_htable_find_batch},
+        {"Test htable_find_batch swiss", test_htable_find_batch_swiss},
         {"Test htable_remove wrong params ", test_htable_remove_wrong_params},
         {"Test htable_remove exist key ", test_htable_remove_exist_key},
         {"Test htable_remove not exist key ", test_htable_remove_not_exist_key},
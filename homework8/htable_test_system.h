@@ -0,0 +1,70 @@
+#ifndef _H_TABLE_TEST_SYSTEM_H
+#define _H_TABLE_TEST_SYSTEM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/// --------------------- PRIMITIVE TEST SYSTEM --------------------
+
+#define MAX_MESSAGE_BUFFER 1024
+static char message_buffer[MAX_MESSAGE_BUFFER];
+
+#define ASSERTION(cond, msg)                                                            \
+do{                                                                                     \
+    if (!(cond))                                                                        \
+    {                                                                                   \
+        snprintf(message_buffer, MAX_MESSAGE_BUFFER, "%s:%d %s", __FILE__, __LINE__, msg); \
+        return message_buffer;                                                          \
+    }                                                                                   \
+} while(0);                                                                             \
+
+typedef char* (*test_func_t)(void);
+
+struct test_case
+{
+    char *test_description;
+    test_func_t test_func;
+};
+
+static int run_tests(struct test_case *test_cases)
+{
+    size_t test_executed = 0;
+    size_t test_fail = 0;
+
+    for (struct test_case *tc = test_cases; tc->test_func != NULL; tc++)
+    {
+        char *msg = tc->test_func();
+        printf("%-46s ", tc->test_description);
+        if (msg != NULL)
+        {
+            printf(" FAIL!\n    %s\n", msg);
+            test_fail++;
+        }
+        else
+        {
+            printf(" OK!\n");
+        }
+        test_executed++;
+    }
+
+    printf("-------------------------------------------------------------\n");
+    printf("Test executed:     %32lu\n", test_executed);
+    printf("Test completed ok: %32lu\n", test_executed - test_fail);
+    printf("Test failed:       %32lu\n\n", test_fail);
+    if (test_fail)
+        printf("!!!! TESTS HAVE NOT PASSED !!!!\n\n\n");
+    return test_fail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#define TEST_KEY_SIZE 16
+
+/**
+ * Fill keys with distinct strings: prefix followed by i * 7919 (prime, so neighbour keys differ in many digits)
+ */
+static inline void make_test_keys(char (*keys)[TEST_KEY_SIZE], size_t count, const char *prefix)
+{
+    for (size_t i = 0; i < count; i++)
+        snprintf(keys[i], TEST_KEY_SIZE, "%s%zu", prefix, i * 7919);
+}
+
+#endif // _H_TABLE_TEST_SYSTEM_H
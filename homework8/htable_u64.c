@@ -0,0 +1,199 @@
+#include <stdlib.h>
+
+#include "htable_hash.h"
+#include "htable_u64.h"
+
+#define CHECK_AND_EXIT_WITH_VAL_IF(cond, v)       if (cond)  return v;
+#define CHECK_AND_EXIT_IF(cond)                   if (cond)  return;
+
+#define U64_MIN_BITS 4
+#define U64_MAX_BITS 40
+#define U64_MULTIPLIER 0x9E3779B97F4A7C15ull    // 2^64 / golden ratio
+#define U64_EMPTY 0                             // Key of empty slot, key 0 is kept out of slots
+
+typedef struct
+{
+    uint64_t key;
+    uint64_t val;
+} u64_slot_t;
+
+struct htable_u64_t
+{
+    u64_slot_t *slots;
+    size_t capacity;        // 2^bits
+    unsigned shift;         // 64 - bits, hash keeps high bits of the product
+    uint64_t multiplier;    // Odd
+    size_t count;           // Including key 0
+    bool has_zero;
+    uint64_t zero_val;
+};
+
+static inline size_t home_index(const htable_u64_t *ht, uint64_t key)
+{
+    return (size_t)((key * ht->multiplier) >> ht->shift);
+}
+
+/**
+ * Returns slot of key or empty slot where it has to be inserted. Key is not 0.
+ */
+static inline size_t probe(const htable_u64_t *ht, uint64_t key)
+{
+    size_t mask = ht->capacity - 1;
+    size_t index = home_index(ht, key);
+    while (ht->slots[index].key != key && ht->slots[index].key != U64_EMPTY)
+        index = (index + 1) & mask;
+    return index;
+}
+
+static bool alloc_slots(htable_u64_t *ht, unsigned bits)
+{
+    u64_slot_t *slots = calloc((size_t)1 << bits, sizeof(u64_slot_t));
+    CHECK_AND_EXIT_WITH_VAL_IF(!slots, false)
+    ht->slots = slots;
+    ht->capacity = (size_t)1 << bits;
+    ht->shift = 64 - bits;
+    return true;
+}
+
+static bool grow(htable_u64_t *ht)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(64 - ht->shift >= U64_MAX_BITS, false)
+
+    u64_slot_t *old_slots = ht->slots;
+    size_t old_capacity = ht->capacity;
+    CHECK_AND_EXIT_WITH_VAL_IF(!alloc_slots(ht, 64 - ht->shift + 1), false)
+
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        if (old_slots[i].key != U64_EMPTY)
+            ht->slots[probe(ht, old_slots[i].key)] = old_slots[i];
+    }
+    free(old_slots);
+    return true;
+}
+
+htable_u64_t *htable_u64_make(size_t init_len, uint64_t seed)
+{
+    htable_u64_t *ht = malloc(sizeof(htable_u64_t));
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, NULL)
+
+    unsigned bits = U64_MIN_BITS;
+    while (((size_t)1 << bits) - ((size_t)1 << (bits - 2)) < init_len && bits < U64_MAX_BITS)
+        bits++;
+    if (!alloc_slots(ht, bits))
+    {
+        free(ht);
+        return NULL;
+    }
+    // Seed is mixed, so no simple seed selects a degenerate multiplier (1, or the one of another seed)
+    ht->multiplier = (seed) ? htable_fmix64(seed) | 1 : U64_MULTIPLIER;
+    ht->count = 0;
+    ht->has_zero = false;
+    ht->zero_val = 0;
+    return ht;
+}
+
+void htable_u64_destroy(htable_u64_t *ht)
+{
+    CHECK_AND_EXIT_IF(!ht)
+    free(ht->slots);
+    free(ht);
+}
+
+uint64_t *htable_u64_upsert(htable_u64_t *ht, uint64_t key, bool *inserted)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, NULL)
+    if (inserted)
+        *inserted = false;
+
+    if (key == U64_EMPTY)
+    {
+        if (!ht->has_zero)
+        {
+            ht->has_zero = true;
+            ht->zero_val = 0;
+            ht->count++;
+            if (inserted)
+                *inserted = true;
+        }
+        return &ht->zero_val;
+    }
+
+    size_t index = probe(ht, key);
+    if (ht->slots[index].key == key)
+        return &ht->slots[index].val;
+
+    // Key 0 is counted too, so the load is at most 3/4
+    if (ht->count + 1 > ht->capacity - (ht->capacity >> 2))
+    {
+        CHECK_AND_EXIT_WITH_VAL_IF(!grow(ht), NULL)
+        index = probe(ht, key);
+    }
+    ht->slots[index].key = key;
+    ht->slots[index].val = 0;
+    ht->count++;
+    if (inserted)
+        *inserted = true;
+    return &ht->slots[index].val;
+}
+
+uint64_t *htable_u64_find(htable_u64_t *ht, uint64_t key)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, NULL)
+    if (key == U64_EMPTY)
+        return (ht->has_zero) ? &ht->zero_val : NULL;
+
+    size_t index = probe(ht, key);
+    return (ht->slots[index].key == key) ? &ht->slots[index].val : NULL;
+}
+
+bool htable_u64_remove(htable_u64_t *ht, uint64_t key)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, false)
+    if (key == U64_EMPTY)
+    {
+        CHECK_AND_EXIT_WITH_VAL_IF(!ht->has_zero, false)
+        ht->has_zero = false;
+        ht->count--;
+        return true;
+    }
+
+    size_t index = probe(ht, key);
+    CHECK_AND_EXIT_WITH_VAL_IF(ht->slots[index].key != key, false)
+
+    // Backward shift: a key moves to the freed slot if its home slot is not after the freed slot
+    size_t mask = ht->capacity - 1, next, home;
+    for (next = (index + 1) & mask; ht->slots[next].key != U64_EMPTY; next = (next + 1) & mask)
+    {
+        home = home_index(ht, ht->slots[next].key);
+        if (((next - home) & mask) >= ((next - index) & mask))
+        {
+            ht->slots[index] = ht->slots[next];
+            index = next;
+        }
+    }
+    ht->slots[index].key = U64_EMPTY;
+    ht->count--;
+    return true;
+}
+
+size_t htable_u64_count(const htable_u64_t *ht)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, 0)
+    return ht->count;
+}
+
+bool htable_u64_enumerate(htable_u64_t *ht, int (*callback)(uint64_t key, uint64_t *value, void *ctx), void *ctx)
+{
+    CHECK_AND_EXIT_WITH_VAL_IF(!ht, true)
+    CHECK_AND_EXIT_WITH_VAL_IF(!callback, true)
+
+    if (ht->has_zero && !callback(U64_EMPTY, &ht->zero_val, ctx))
+        return false;
+    for (size_t i = 0; i < ht->capacity; i++)
+    {
+        if (ht->slots[i].key != U64_EMPTY && !callback(ht->slots[i].key, &ht->slots[i].val, ctx))
+            return false;
+    }
+    return true;
+}
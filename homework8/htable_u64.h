@@ -0,0 +1,96 @@
+#ifndef _H_TABLE_U64_H
+#define _H_TABLE_U64_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct htable_u64_t htable_u64_t;
+
+/**
+ *   Make a hash table with 64-bit integer keys and 64-bit values
+ *
+ *   \param [in] init_len - The initial number of keys in the hash table
+ *
+ *   \param [in] seed - Seed of hash function (0 is Fibonacci hashing, other seeds select mixed multipliers)
+ *
+ *   \return It returns pointer to the instance of hash table or NULL if error happened
+ *
+ *   \details Keys are stored inline in slots next to values: no key buffers, no per-key allocations.
+ *   Slot is selected by multiply-shift hash (high bits of key multiplied by odd constant),
+ *   keys are compared as integers. Slot array is loaded up to 3/4 (linear probing),
+ *   removal shifts following keys back, so there are no deleted marks. Any key including 0 can be stored.
+ *   Multiply-shift isn't resistant to chosen keys, use htable_t with random seed for untrusted input.
+ */
+htable_u64_t *htable_u64_make(size_t init_len, uint64_t seed);
+
+/**
+ *  Destroy the hash table
+ *
+ *  \param [in] ht - The instance of hash table
+ */
+void htable_u64_destroy(htable_u64_t *ht);
+
+/**
+ *  Find value of key or insert the key if it isn't in the hash table
+ *
+ *  \param [in] ht - The instance of hash table
+ *
+ *  \param [in] key - The key
+ *
+ *  \param [out] inserted - The pointer where true is returned if key was inserted (can be NULL)
+ *
+ *  \return It returns pointer to the value of key (zeroed for inserted key) or NULL if memory
+ *  can't be allocated. The pointer is valid until the next insert or remove.
+ */
+uint64_t *htable_u64_upsert(htable_u64_t *ht, uint64_t key, bool *inserted);
+
+/**
+ *  Find value of key
+ *
+ *  \param [in] ht - The instance of hash table
+ *
+ *  \param [in] key - The key
+ *
+ *  \return It returns pointer to the value of key (valid until the next insert or remove)
+ *  or NULL if key isn't found.
+ */
+uint64_t *htable_u64_find(htable_u64_t *ht, uint64_t key);
+
+/**
+ *  Remove key from the hash table
+ *
+ *  \param [in] ht - The instance of hash table
+ *
+ *  \param [in] key - The key
+ *
+ *  \return It returns true if key was removed, false if key isn't found.
+ */
+bool htable_u64_remove(htable_u64_t *ht, uint64_t key);
+
+/**
+ *  Get the number of keys in the hash table
+ *
+ *  \param [in] ht - The instance of hash table
+ *
+ *  \return It returns the number of keys.
+ */
+size_t htable_u64_count(const htable_u64_t *ht);
+
+/**
+ * Enumerate keys of the hash table
+ *
+ * \param [in] ht - The instance of hash table
+ *
+ * \param [in] callback - The pointer to function that will be called for each key with its value
+ *
+ * \param [in] ctx - The pointer passed to callback
+ *
+ * \return It returns false if enumeration was stopped by callback, true otherwise.
+ *
+ * \details The callback function can return zero to stop enumeration. Value can be changed,
+ * keys must not be inserted or removed while enumerating. The order of keys is unspecified.
+ */
+bool htable_u64_enumerate(htable_u64_t *ht, int (*callback)(uint64_t key, uint64_t *value, void *ctx), void *ctx);
+
+#endif // _H_TABLE_U64_H
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "htable_u64.h"
+#include "htable_test_system.h"
+
+/// TEST CASES
+#define KEYS_COUNT 100000
+#define RANGE 1024
+
+struct enumerated
+{
+    size_t count;
+    uint64_t key_sum;
+    bool values_ok;
+    size_t stop_after;
+};
+
+static int enum_callback(uint64_t key, uint64_t *value, void *ctx)
+{
+    struct enumerated *e = ctx;
+    e->values_ok = e->values_ok && *value == ~key;
+    e->key_sum += key;
+    e->count++;
+    return e->count != e->stop_after;
+}
+
+char *test_wrong_params()
+{
+    htable_u64_t *ht = htable_u64_make(0, 0);
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
+    ASSERTION(htable_u64_upsert(NULL, 1, NULL) == NULL, "Expected: NULL!")
+    ASSERTION(htable_u64_find(NULL, 1) == NULL, "Expected: NULL!")
+    ASSERTION(!htable_u64_remove(NULL, 1), "Expected: false!")
+    ASSERTION(htable_u64_count(NULL) == 0, "Expected: 0!")
+    ASSERTION(htable_u64_enumerate(NULL, enum_callback, NULL), "Expected: true!")
+    ASSERTION(htable_u64_enumerate(ht, NULL, NULL), "Expected: true!")
+    ASSERTION(htable_u64_find(ht, 0) == NULL, "Expected: Key 0 isn't found!")
+    ASSERTION(!htable_u64_remove(ht, 0), "Expected: Key 0 isn't removed!")
+    htable_u64_destroy(NULL);
+    htable_u64_destroy(ht);
+    return NULL;
+}
+
+/**
+ * Sequential keys, keys differing only in high bits and key 0 (empty slot inside the table).
+ */
+char *test_functional()
+{
+    const uint64_t steps[3] = {1, (uint64_t)1 << 32, 0x9E3779B97F4A7C15ull};
+    bool inserted;
+    uint64_t *value;
+
+    for (size_t s = 0; s < 3; s++)
+    {
+        htable_u64_t *ht = htable_u64_make(0, s);
+        ASSERTION(ht != NULL, "Expected: Hash table was created!")
+        for (uint64_t i = 0; i < KEYS_COUNT; i++)
+        {
+            value = htable_u64_upsert(ht, i * steps[s], &inserted);
+            ASSERTION(value != NULL && inserted && *value == 0, "Expected: Key was inserted with zeroed value!")
+            *value = ~(i * steps[s]);
+        }
+        ASSERTION(htable_u64_count(ht) == KEYS_COUNT, "Expected: All keys were inserted!")
+
+        for (uint64_t i = 0; i < KEYS_COUNT; i++)
+        {
+            value = htable_u64_upsert(ht, i * steps[s], &inserted);
+            ASSERTION(value != NULL && !inserted && *value == ~(i * steps[s]), "Expected: Value of existing key!")
+            value = htable_u64_find(ht, i * steps[s]);
+            ASSERTION(value != NULL && *value == ~(i * steps[s]), "Expected: Key was found!")
+            ASSERTION(htable_u64_find(ht, (KEYS_COUNT + i) * steps[s]) == NULL, "Expected: Key isn't found!")
+        }
+        ASSERTION(htable_u64_count(ht) == KEYS_COUNT, "Expected: Nothing was inserted!")
+
+        struct enumerated e = {0, 0, true, 0};
+        ASSERTION(htable_u64_enumerate(ht, enum_callback, &e), "Expected: Enumeration wasn't stopped!")
+        ASSERTION(e.count == KEYS_COUNT && e.values_ok, "Expected: All keys with values!")
+        ASSERTION(e.key_sum == (uint64_t)KEYS_COUNT * (KEYS_COUNT - 1) / 2 * steps[s], "Expected: Sum of keys!")
+
+        e = (struct enumerated){0, 0, true, 10};
+        ASSERTION(!htable_u64_enumerate(ht, enum_callback, &e), "Expected: Enumeration was stopped!")
+        ASSERTION(e.count == 10, "Expected: Callback was called 10 times!")
+        htable_u64_destroy(ht);
+    }
+    return NULL;
+}
+
+struct ordered
+{
+    uint64_t last;
+    size_t ascending;
+};
+
+static int order_callback(uint64_t key, __attribute__((unused)) uint64_t *value, void *ctx)
+{
+    struct ordered *o = ctx;
+    o->ascending += key > o->last;
+    o->last = key;
+    return 1;
+}
+
+char *test_seeds()
+{
+    // Seeds which used to select multipliers 1 and the golden ratio of seed 0
+    const uint64_t seeds[3] = {0x9E3779B97F4A7C14ull, 0, 1};
+    size_t ascending[3];
+
+    for (size_t s = 0; s < 3; s++)
+    {
+        htable_u64_t *ht = htable_u64_make(0, seeds[s]);
+        ASSERTION(ht != NULL, "Expected: Hash table was created!")
+        for (uint64_t i = 1; i <= RANGE; i++)
+            ASSERTION(htable_u64_upsert(ht, i, NULL) != NULL, "Expected: Key was inserted!")
+
+        // Enumeration goes in slot order: it keeps key order only if keys weren't scattered
+        struct ordered o = {0, 0};
+        htable_u64_enumerate(ht, order_callback, &o);
+        ascending[s] = o.ascending;
+        ASSERTION(o.ascending < RANGE - RANGE / 4, "Expected: Keys were scattered over slots!")
+        htable_u64_destroy(ht);
+    }
+    ASSERTION(ascending[1] != ascending[2], "Expected: Seeds 0 and 1 select different multipliers!")
+    return NULL;
+}
+
+/**
+ * Random inserts and removes of keys from a small range are checked against a plain array:
+ * removal shifts keys back and clusters are long.
+ */
+char *test_remove()
+{
+    static bool present[RANGE];
+    htable_u64_t *ht = htable_u64_make(RANGE, 0);
+    size_t count = 0;
+    uint64_t x = 1, key;
+    ASSERTION(ht != NULL, "Expected: Hash table was created!")
+
+    for (size_t i = 0; i < 200000; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        key = (x % RANGE) << 20;  // Low bits are zero
+        if (x & 0x100000)
+        {
+            bool inserted;
+            ASSERTION(htable_u64_upsert(ht, key, &inserted) != NULL, "Expected: Key was inserted!")
+            ASSERTION(inserted == !present[x % RANGE], "Expected: Key was inserted if it isn't present!")
+            count += inserted;
+            present[x % RANGE] = true;
+        }
+        else
+        {
+            ASSERTION(htable_u64_remove(ht, key) == present[x % RANGE], "Expected: Key was removed if it's present!")
+            count -= present[x % RANGE];
+            present[x % RANGE] = false;
+        }
+        ASSERTION(htable_u64_count(ht) == count, "Expected: Count of keys!")
+    }
+    for (uint64_t k = 0; k < RANGE; k++)
+        ASSERTION((htable_u64_find(ht, k << 20) != NULL) == present[k], "Expected: Only present keys are found!")
+
+    for (uint64_t k = 0; k < RANGE; k++)
+        htable_u64_remove(ht, k << 20);
+    ASSERTION(htable_u64_count(ht) == 0, "Expected: All keys were removed!")
+    htable_u64_destroy(ht);
+    return NULL;
+}
+
+int main(void)
+{
+    struct test_case test_cases[] = {
+        {"Test u64 wrong params", test_wrong_params},
+        {"Test u64 functional", test_functional},
+        {"Test u64 seeds", test_seeds},
+        {"Test u64 remove", test_remove},
+        {0, 0},
+    };
+
+    return run_tests(test_cases);
+}